@@ -0,0 +1,138 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LineFramer.h"
+
+#include <algorithm>
+
+extern "C"
+{
+    #include <esp_log.h>
+    #include <string.h>
+}
+
+namespace
+{
+	const char*	LOG_TAG = "IDFix::LineFramer";
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		size_t LineFramer::feed(const uint8_t *data, size_t length)
+		{
+			size_t consumed = 0;
+
+			// release the lines which were read already
+			if ( _readPosition > 0 )
+			{
+				memmove(_buffer, _buffer + _readPosition, _length - _readPosition);
+				_length -= _readPosition;
+				_scanPosition -= _readPosition;
+				_readPosition = 0;
+			}
+
+			if ( _discarding )
+			{
+				// skip the rest of a dropped line
+				const void* lineEnd = memchr(data, '\n', length);
+
+				if ( lineEnd == nullptr )
+				{
+					return length;
+				}
+
+				consumed = static_cast<size_t>( static_cast<const uint8_t*>(lineEnd) - data ) + 1;
+				data += consumed;
+				length -= consumed;
+				_discarding = false;
+			}
+
+			if ( _length == CAPACITY )
+			{
+				// the buffer is full and holds no line end, the line can't fit
+				ESP_LOGW(LOG_TAG, "feed: dropping a line longer than %u bytes", static_cast<unsigned>(CAPACITY));
+
+				_dropped++;
+				_length = 0;
+				_scanPosition = 0;
+				_discarding = true;
+
+				return consumed;
+			}
+
+			size_t chunk = std::min(CAPACITY - _length, length);
+
+			memcpy(_buffer + _length, data, chunk);
+			_length += chunk;
+
+			return consumed + chunk;
+		}
+
+		bool LineFramer::nextLine(char *&line)
+		{
+			while ( _scanPosition < _length )
+			{
+				const void* found = memchr(_buffer + _scanPosition, '\n', _length - _scanPosition);
+
+				if ( found == nullptr )
+				{
+					_scanPosition = _length;
+					return false;
+				}
+
+				size_t lineStart = _readPosition;
+				size_t lineEnd = static_cast<size_t>( static_cast<const char*>(found) - _buffer );
+
+				_scanPosition = lineEnd + 1;
+				_readPosition = _scanPosition;
+
+				if ( lineEnd > lineStart && _buffer[lineEnd - 1] == '\r' )
+				{
+					lineEnd--;
+				}
+
+				if ( lineEnd == lineStart )
+				{
+					// skip empty lines
+					continue;
+				}
+
+				_buffer[lineEnd] = '\0';
+				line = _buffer + lineStart;
+
+				return true;
+			}
+
+			return false;
+		}
+
+		void LineFramer::reset()
+		{
+			_length = 0;
+			_readPosition = 0;
+			_scanPosition = 0;
+			_discarding = false;
+		}
+
+		uint32_t LineFramer::getDroppedCount() const
+		{
+			return _dropped;
+		}
+	}
+}
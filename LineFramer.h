@@ -0,0 +1,97 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LINEFRAMER_H
+#define LINEFRAMER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+        /**
+         * @brief The LineFramer class splits a byte stream into lines terminated by "\r\n" or "\n"
+         *
+         * Incoming bytes are collected in a fixed buffer, so lines may be split across several
+         * reads and a single read may carry several lines. Complete lines are handed out in place
+         * and NUL-terminated, a line which does not fit into the buffer is dropped.
+         *
+         * @code
+         * while ( remaining > 0 )
+         * {
+         *     size_t consumed = framer.feed(data, remaining);
+         *     data += consumed;
+         *     remaining -= consumed;
+         *
+         *     char *line;
+         *     while ( framer.nextLine(line) )
+         *     {
+         *         // line is valid until the next call of feed()
+         *     }
+         * }
+         * @endcode
+         */
+		class LineFramer
+		{
+			public:
+
+				static constexpr size_t	CAPACITY = 1024;
+
+                /**
+                 * @brief Add received bytes, lines read by nextLine() before are released
+                 *
+                 * @param data      the received bytes
+                 * @param length    the number of received bytes
+                 *
+                 * @return the number of bytes consumed, call again with the rest after reading the complete lines
+                 */
+				size_t				feed(const uint8_t *data, size_t length);
+
+                /**
+                 * @brief Get the next complete, non-empty line without its line end
+                 *
+                 * @param line  set to the NUL-terminated line inside the buffer
+                 *
+                 * @return \c false if no complete line is buffered
+                 */
+				bool				nextLine(char *&line);
+
+                /**
+                 * @brief Drop all buffered bytes, e.g. when the connection was closed
+                 */
+				void				reset(void);
+
+                /**
+                 * @brief Get the number of lines dropped because they did not fit into the buffer
+                 */
+				uint32_t			getDroppedCount(void) const;
+
+			private:
+
+				char				_buffer[CAPACITY];
+				size_t				_length = { 0 };		///< number of buffered bytes
+				size_t				_readPosition = { 0 };	///< start of the first line not read yet
+				size_t				_scanPosition = { 0 };	///< the bytes before do not contain a line end
+				bool				_discarding = { false };
+				uint32_t			_dropped = { 0 };
+		};
+	}
+}
+
+#endif
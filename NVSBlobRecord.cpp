@@ -0,0 +1,123 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "NVSBlobRecord.h"
+
+extern "C"
+{
+    #include <esp_log.h>
+    #include <nvs.h>
+}
+
+namespace
+{
+	const char*		LOG_TAG = "IDFix::NVSBlobRecord";
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		NVSBlob::NVSBlob(const char *nvsNamespace, const char *key)
+			: _namespace(nvsNamespace), _key(key)
+		{
+
+		}
+
+		NVSBlob::ReadResult NVSBlob::read(void *data, size_t size) const
+		{
+			nvs_handle_t	handle;
+			size_t			length = size;
+			esp_err_t		result;
+
+			result = nvs_open(_namespace, NVS_READONLY, &handle);
+			if ( result != ESP_OK )
+			{
+				// a namespace nobody wrote to does not exist yet
+				return result == ESP_ERR_NVS_NOT_FOUND ? ReadResult::Absent : ReadResult::Failed;
+			}
+
+			result = nvs_get_blob(handle, _key, data, &length);
+			nvs_close(handle);
+
+			if ( result == ESP_ERR_NVS_NOT_FOUND )
+			{
+				return ReadResult::Absent;
+			}
+
+			return result == ESP_OK && length == size ? ReadResult::Read : ReadResult::Failed;
+		}
+
+		bool NVSBlob::write(const void *data, size_t size) const
+		{
+			nvs_handle_t	handle;
+			esp_err_t		result;
+
+			result = nvs_open(_namespace, NVS_READWRITE, &handle);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGW(LOG_TAG, "write: nvs_open failed: %d", result);
+				return false;
+			}
+
+			result = nvs_set_blob(handle, _key, data, size);
+			if ( result == ESP_OK )
+			{
+				result = nvs_commit(handle);
+			}
+
+			nvs_close(handle);
+
+			if ( result != ESP_OK )
+			{
+				ESP_LOGW(LOG_TAG, "write: writing %s failed: %d", _key, result);
+				return false;
+			}
+
+			return true;
+		}
+
+		bool NVSBlob::erase() const
+		{
+			nvs_handle_t	handle;
+			esp_err_t		result;
+
+			result = nvs_open(_namespace, NVS_READWRITE, &handle);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGW(LOG_TAG, "erase: nvs_open failed: %d", result);
+				return false;
+			}
+
+			result = nvs_erase_key(handle, _key);
+			if ( result == ESP_OK )
+			{
+				result = nvs_commit(handle);
+			}
+
+			nvs_close(handle);
+
+			if ( result != ESP_OK && result != ESP_ERR_NVS_NOT_FOUND )
+			{
+				ESP_LOGW(LOG_TAG, "erase: erasing %s failed: %d", _key, result);
+				return false;
+			}
+
+			return true;
+		}
+	}
+}
@@ -0,0 +1,213 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NVSBLOBRECORD_H
+#define NVSBLOBRECORD_H
+
+extern "C"
+{
+    #include <stdint.h>
+    #include <stddef.h>
+    #include <string.h>
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+        /**
+         * @brief The NVSBlob class reads, writes and erases one blob of the NVS
+         */
+		class NVSBlob
+		{
+			public:
+
+				enum class ReadResult : uint8_t
+				{
+					Read,			///< the blob was read
+					Absent,			///< the NVS holds no blob under the key
+					Failed			///< the blob has another size or the NVS could not be read
+				};
+
+									NVSBlob(const char *nvsNamespace, const char *key);
+
+                /**
+                 * @brief Read the blob
+                 *
+                 * @return Read only if a blob of exactly the given size is stored
+                 */
+				ReadResult			read(void *data, size_t size) const;
+
+                /**
+                 * @brief Write and commit the blob
+                 */
+				bool				write(const void *data, size_t size) const;
+
+                /**
+                 * @brief Erase the blob if it is stored
+                 *
+                 * @return \c false if the blob could not be erased
+                 */
+				bool				erase(void) const;
+
+			private:
+
+				const char*			_namespace;
+				const char*			_key;
+		};
+
+        /**
+         * @brief The NVSBlobRecord class keeps a small record in memory and persists it as an NVS blob
+         *
+         * The payload is a POD struct with a \c version member, a stored blob of another size or
+         * version is ignored. remember() only marks the record dirty, persist() writes it, so the
+         * flash write can be done where it stalls nobody.
+         *
+         * The record tracks whether the NVS holds the key, so clear() also erases a stale blob
+         * which load() rejected, and only skips the NVS access if the key is known to be absent.
+         */
+		template <typename Payload>
+		class NVSBlobRecord
+		{
+			public:
+
+									NVSBlobRecord(const char *nvsNamespace, const char *key, uint8_t version)
+										: _blob(nvsNamespace, key), _version(version)
+									{
+
+									}
+
+                /**
+                 * @brief Load the record from the NVS
+                 *
+                 * @return \c false if no valid record is stored
+                 */
+				bool				load(void)
+				{
+					Payload				payload;
+					NVSBlob::ReadResult	result = _blob.read(&payload, sizeof(payload));
+
+					_valid = false;
+					_dirty = false;
+					_absent = result == NVSBlob::ReadResult::Absent;
+
+					if ( result != NVSBlob::ReadResult::Read || payload.version != _version )
+					{
+						return false;
+					}
+
+					_payload = payload;
+					_valid = true;
+
+					return true;
+				}
+
+                /**
+                 * @brief Take a new payload, it is persisted by the next persist() if it changed
+                 *
+                 * @return \c true if the payload changed and persist() has to write it
+                 */
+				bool				remember(Payload payload)
+				{
+					payload.version = _version;
+
+					if ( _valid && memcmp(&payload, &_payload, sizeof(payload)) == 0 )
+					{
+						// nothing changed, spare the flash
+						return false;
+					}
+
+					_payload = payload;
+					_valid = true;
+					_dirty = true;
+
+					return true;
+				}
+
+                /**
+                 * @brief Write the record if remember() changed it
+                 *
+                 * @return \c false if writing failed
+                 */
+				bool				persist(void)
+				{
+					if ( ! _dirty )
+					{
+						return true;
+					}
+
+					_dirty = false;
+
+					if ( ! _blob.write(&_payload, sizeof(_payload)) )
+					{
+						return false;
+					}
+
+					_absent = false;
+
+					return true;
+				}
+
+                /**
+                 * @brief Forget the record and remove it from the NVS
+                 */
+				void				clear(void)
+				{
+					_valid = false;
+					_dirty = false;
+
+					if ( _absent )
+					{
+						// there is nothing to erase, spare the NVS access
+						return;
+					}
+
+					_absent = _blob.erase();
+				}
+
+                /**
+                 * @brief Forget the record in memory only, e.g. if the loaded payload is unusable
+                 */
+				void				invalidate(void)
+				{
+					_valid = false;
+					_dirty = false;
+				}
+
+				bool				isValid(void) const
+				{
+					return _valid;
+				}
+
+				const Payload&		get(void) const
+				{
+					return _payload;
+				}
+
+			private:
+
+				NVSBlob				_blob;
+				uint8_t				_version;
+				Payload				_payload = {};
+				bool				_valid = { false };
+				bool				_dirty = { false };
+				bool				_absent = { false };	///< the NVS is known to hold no blob under the key
+		};
+	}
+}
+
+#endif
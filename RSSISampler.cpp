@@ -0,0 +1,110 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RSSISampler.h"
+
+#include <algorithm>
+
+namespace
+{
+	const int32_t	EWMA_FRACTION_BITS = 4;
+	const int32_t	EWMA_WEIGHT_SHIFT = 3;
+
+	// divide by 2^shift and round to nearest, a plain division truncates towards zero and lets the average lag behind
+	int32_t roundedShift(int32_t value, int32_t shift)
+	{
+		int32_t half = 1 << ( shift - 1 );
+
+		return ( value >= 0 ? value + half : value - half ) / ( 1 << shift );
+	}
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		void RSSISampler::record(int8_t rssi)
+		{
+			int32_t sample = static_cast<int32_t>(rssi) * (1 << EWMA_FRACTION_BITS);
+
+			// claim a slot first, so concurrent writers never take the same one
+			uint32_t written = _written.fetch_add(1, std::memory_order_acq_rel);
+
+			_samples[written % CAPACITY].store(rssi, std::memory_order_relaxed);
+
+			int32_t ewma = _ewma.load(std::memory_order_relaxed);
+			int32_t next;
+
+			// the first sample seeds the average, also by CAS, so a concurrent writer's update is not overwritten
+			do
+			{
+				next = ewma == EWMA_EMPTY ? sample : ewma + roundedShift(sample - ewma, EWMA_WEIGHT_SHIFT);
+			}
+			while ( ! _ewma.compare_exchange_weak(ewma, next, std::memory_order_relaxed) );
+		}
+
+		void RSSISampler::reset()
+		{
+			_ewma.store(EWMA_EMPTY, std::memory_order_relaxed);
+			_written.store(0, std::memory_order_release);
+		}
+
+		int8_t RSSISampler::getEWMA() const
+		{
+			int32_t ewma = _ewma.load(std::memory_order_relaxed);
+
+			if ( ewma == EWMA_EMPTY )
+			{
+				return 0;
+			}
+
+			return static_cast<int8_t>( roundedShift(ewma, EWMA_FRACTION_BITS) );
+		}
+
+		RSSIStatistics RSSISampler::getStatistics() const
+		{
+			RSSIStatistics	statistics = {};
+			int8_t			window[CAPACITY];
+			uint32_t		written = _written.load(std::memory_order_acquire);
+			size_t			count = std::min<size_t>(written, CAPACITY);
+
+			if ( count == 0 )
+			{
+				return statistics;
+			}
+
+			for ( size_t index = 0; index < count; index++ )
+			{
+				window[index] = _samples[index].load(std::memory_order_relaxed);
+			}
+
+			statistics.count = static_cast<uint16_t>(count);
+			statistics.last = _samples[(written - 1) % CAPACITY].load(std::memory_order_relaxed);
+			statistics.ewma = getEWMA();
+
+			std::sort(window, window + count);
+
+			statistics.min = window[0];
+			statistics.max = window[count - 1];
+			statistics.p10 = window[( count - 1 ) * 10 / 100];
+			statistics.p50 = window[( count - 1 ) * 50 / 100];
+			statistics.p90 = window[( count - 1 ) * 90 / 100];
+
+			return statistics;
+		}
+	}
+}
@@ -0,0 +1,97 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RSSISAMPLER_H
+#define RSSISAMPLER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+        /**
+         * @brief The RSSIStatistics struct summarizes the samples of an RSSISampler
+         */
+        struct RSSIStatistics
+        {
+            uint16_t    count;      ///< the number of samples the statistics are based on
+            int8_t      last;
+            int8_t      min;
+            int8_t      max;
+            int8_t      ewma;       ///< exponentially weighted moving average over all samples
+            int8_t      p10;
+            int8_t      p50;
+            int8_t      p90;
+        };
+
+        /**
+         * @brief The RSSISampler class records RSSI samples into a fixed size ring buffer
+         *
+         * The sampler never allocates and never locks. Samples may be recorded from several tasks,
+         * e.g. the roaming timer and the application, while any other task reads the statistics.
+         * A reader just may miss a sample recorded concurrently.
+         */
+		class RSSISampler
+		{
+			public:
+
+				static constexpr size_t	CAPACITY = 32;
+
+                /**
+                 * @brief Record a sample, the oldest sample is dropped if the buffer is full
+                 *
+                 * @param rssi  the RSSI in dBm
+                 */
+				void				record(int8_t rssi);
+
+                /**
+                 * @brief Drop all samples, the average starts over with the next sample
+                 */
+				void				reset(void);
+
+                /**
+                 * @brief Get the exponentially weighted moving average of all samples
+                 *
+                 * Each sample contributes with a weight of 1/8, the average is rounded to the nearest dBm.
+                 *
+                 * @return the average or 0 if there are no samples
+                 */
+				int8_t				getEWMA(void) const;
+
+                /**
+                 * @brief Calculate the statistics of the buffered samples
+                 *
+                 * @return the statistics, count is 0 if there are no samples
+                 */
+				RSSIStatistics		getStatistics(void) const;
+
+			private:
+
+				static constexpr int32_t					EWMA_EMPTY = INT32_MIN;	///< no sample was averaged yet
+
+				std::array<std::atomic<int8_t>, CAPACITY>	_samples = {};
+				std::atomic<uint32_t>						_written = { 0 };
+				std::atomic<int32_t>						_ewma = { EWMA_EMPTY };	///< fixed point with 4 fractional bits
+		};
+	}
+}
+
+#endif
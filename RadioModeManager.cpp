@@ -0,0 +1,203 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RadioModeManager.h"
+
+extern "C"
+{
+    #include <esp_log.h>
+    #include <esp_wifi.h>
+}
+
+namespace
+{
+	const char*	LOG_TAG = "IDFix::RadioModeManager";
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		RadioModeManager::RadioModeManager()
+		{
+			// the driver is called with the mutex held, so the mode and the driver never disagree
+			_mutex = xSemaphoreCreateRecursiveMutex();
+		}
+
+		RadioModeManager::~RadioModeManager()
+		{
+			vSemaphoreDelete(_mutex);
+		}
+
+		bool RadioModeManager::acquire(User user)
+		{
+			bool result = true;
+
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			_users[user]++;
+
+			if ( ! apply() )
+			{
+				_users[user]--;
+				result = false;
+			}
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			return result;
+		}
+
+		bool RadioModeManager::start()
+		{
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			if ( ! _started && _mode != WIFI_MODE_NULL )
+			{
+				_driverCalls++;
+
+				esp_err_t error = esp_wifi_start();
+				if ( error == ESP_OK )
+				{
+					_started = true;
+				}
+				else
+				{
+					ESP_LOGE(LOG_TAG, "start: esp_wifi_start failed: %u", error);
+				}
+			}
+
+			bool started = _started;
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			return started;
+		}
+
+		bool RadioModeManager::release(User user)
+		{
+			bool result = false;
+
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			if ( _users[user] > 0 )
+			{
+				_users[user]--;
+				result = apply();
+			}
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			return result;
+		}
+
+		bool RadioModeManager::isUsedBy(User user) const
+		{
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			bool used = _users[user] > 0;
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			return used;
+		}
+
+		wifi_mode_t RadioModeManager::getMode() const
+		{
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			wifi_mode_t mode = _mode;
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			return mode;
+		}
+
+		uint32_t RadioModeManager::getDriverCallCount() const
+		{
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			uint32_t driverCalls = _driverCalls;
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			return driverCalls;
+		}
+
+		wifi_mode_t RadioModeManager::targetMode() const
+		{
+			// scans run on the station interface
+			bool station = _users[UserStation] > 0 || _users[UserScan] > 0;
+			bool accessPoint = _users[UserAccessPoint] > 0;
+
+			if ( station && accessPoint )
+			{
+				return WIFI_MODE_APSTA;
+			}
+
+			if ( station )
+			{
+				return WIFI_MODE_STA;
+			}
+
+			return accessPoint ? WIFI_MODE_AP : WIFI_MODE_NULL;
+		}
+
+		bool RadioModeManager::apply()
+		{
+			// called with the mutex held
+
+			esp_err_t	result;
+			wifi_mode_t	mode = targetMode();
+
+			if ( mode == _mode )
+			{
+				return true;
+			}
+
+			if ( mode == WIFI_MODE_NULL && _started )
+			{
+				// nobody needs the radio anymore
+				_driverCalls++;
+
+				result = esp_wifi_stop();
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "apply: esp_wifi_stop failed: %u", result);
+					return false;
+				}
+
+				_started = false;
+			}
+
+			ESP_LOGD(LOG_TAG, "switching wifi mode %d -> %d", _mode, mode);
+
+			_driverCalls++;
+
+			result = esp_wifi_set_mode(mode);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "apply: esp_wifi_set_mode failed: %u", result);
+				return false;
+			}
+
+			_mode = mode;
+
+			return true;
+		}
+	}
+}
@@ -0,0 +1,112 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RADIOMODEMANAGER_H
+#define RADIOMODEMANAGER_H
+
+extern "C"
+{
+    #include <esp_wifi_types.h>
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/semphr.h>
+}
+
+#include <array>
+#include <cstdint>
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+        /**
+         * @brief The RadioModeManager class derives the WIFI mode from the users of the radio
+         *
+         * The station, the access point and scans acquire the radio and release it when they are done.
+         * The mode follows the reference counts of the users and the driver is only touched if the
+         * mode actually changes: a scan while the station is running costs no driver call at all,
+         * and the driver is only stopped when the last user released the radio.
+         *
+         * The radio is acquired and released from the application, the event loop and the esp_timer
+         * task, so all methods may be called from any task.
+         */
+		class RadioModeManager
+		{
+			public:
+
+				enum User : uint8_t
+				{
+					UserStation,
+					UserAccessPoint,
+					UserScan,
+					USER_COUNT
+				};
+
+									RadioModeManager();
+									~RadioModeManager();
+
+                /**
+                 * @brief Add a user and switch to the mode needed, the driver is not started
+                 *
+                 * Interface configurations can be set between acquire() and start().
+                 *
+                 * @param user  the user
+                 *
+                 * @return \c false if the mode could not be set
+                 */
+				bool				acquire(User user);
+
+                /**
+                 * @brief Start the driver if it is not running yet
+                 *
+                 * @return \c false if the driver could not be started
+                 */
+				bool				start(void);
+
+                /**
+                 * @brief Remove a user and switch to the mode the remaining users need
+                 *
+                 * The driver is stopped once the radio has no users anymore.
+                 *
+                 * @param user  the user
+                 *
+                 * @return \c false if the user did not hold the radio or the mode could not be set
+                 */
+				bool				release(User user);
+
+				bool				isUsedBy(User user) const;
+				wifi_mode_t			getMode(void) const;
+
+                /**
+                 * @brief Get the number of mode changes, starts and stops issued to the driver
+                 */
+				uint32_t			getDriverCallCount(void) const;
+
+			private:
+
+				wifi_mode_t			targetMode(void) const;
+				bool				apply(void);
+
+				std::array<uint8_t, USER_COUNT>	_users = {};
+				wifi_mode_t						_mode = { WIFI_MODE_NULL };
+				bool							_started = { false };
+				uint32_t						_driverCalls = { 0 };
+				SemaphoreHandle_t				_mutex = { nullptr };
+		};
+	}
+}
+
+#endif
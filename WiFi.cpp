@@ -17,34 +17,268 @@
 
 #include "WiFi.h"
 #include "WiFiEventHandler.h"
+#include "WiFiEventDispatcher.h"
 #include "WiFiUtils.h"
 #include "auxiliary.h"
 
+#include <array>
+#include <algorithm>
+
 extern "C"
 {
     #include <esp_log.h>
     #include <esp_wifi.h>
     #include <string.h>
     #include <lwip/sockets.h>
+    #include <lwip/netifapi.h>
+    #include <lwip/dhcp.h>
+    #include <lwip/etharp.h>
+
+    #include <esp_system.h>
+    #if __has_include(<esp_random.h>)
+        #include <esp_random.h>
+    #endif
+
+    #if __has_include(<esp_idf_version.h>)
+        #include <esp_idf_version.h>
+    #endif
 }
 
+#ifndef IDFIX_WIFI_SINGLE_AP_RECORD_API
+    #if defined(ESP_IDF_VERSION_VAL)
+        #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+            #define IDFIX_WIFI_SINGLE_AP_RECORD_API 1
+        #endif
+    #endif
+#endif
+
+#ifndef IDFIX_WIFI_SINGLE_AP_RECORD_API
+    #define IDFIX_WIFI_SINGLE_AP_RECORD_API 0
+#endif
+
 namespace
 {
 	const char*		LOG_TAG = "IDFix::WiFi";
 	const uint8_t	MAC_ADDR_LEN = 6;
 	const uint8_t	MAC_STRING_LEN = 17;
+	const int		PROFILE_PRIORITY_WEIGHT = 10;
+	const uint8_t	ACCESS_POINT_CHANNEL = 1;
+	const uint32_t	PROBE_MIN_TIME = 20;
+	const uint32_t	PROBE_MAX_TIME = 50;
+
+	// scans never overlap, see WiFi::claimScan(), so all of them share one buffer to fetch the AP records
+	const uint16_t		SCAN_CHUNK_SIZE = IDFix::WiFi::WiFiScanCache::CAPACITY;
+	wifi_ap_record_t	scanChunk[SCAN_CHUNK_SIZE];
+
+	const uint32_t		LEASE_PROBE_TIME = 200;		///< ms to wait for an answer to the ARP probe of a cached address
+	const uint32_t		LEASE_POLL_INTERVAL = 100;	///< ms between two checks if the renewed lease is bound
+
+	// events posted by WiFi itself, so timer callbacks can hand their work over to the default event loop
+	// and flash writes wait until the event which caused them is handled
+	ESP_EVENT_DEFINE_BASE(IDFIX_WIFI_EVENT);
+
+	enum : int32_t
+	{
+		IDFIX_WIFI_EVENT_LEASE_TIMER,
+		IDFIX_WIFI_EVENT_PERSIST_RECORDS
+	};
+
+	// only the station uses cached leases, the address is set under WiFi::_leaseMutex before calling into lwIP
+	ip4_addr_t			leaseProbeAddress;
+
+	struct netif* stationNetif()
+	{
+		void* netif = nullptr;
+
+		if ( tcpip_adapter_get_netif(TCPIP_ADAPTER_IF_STA, &netif) != ESP_OK )
+		{
+			return nullptr;
+		}
+
+		return static_cast<struct netif*>(netif);
+	}
+
+	// the following run on the tcpip thread
+
+	err_t sendLeaseProbe(struct netif *netif)
+	{
+		// the interface has no address while the DHCP client runs, so this is an RFC 5227 probe
+		return etharp_query(netif, &leaseProbeAddress, nullptr);
+	}
+
+	err_t checkLeaseProbe(struct netif *netif)
+	{
+		struct eth_addr*	ethAddress;
+		const ip4_addr_t*	ipAddress;
+
+		return etharp_find_addr(netif, &leaseProbeAddress, &ethAddress, &ipAddress) >= 0 ? ERR_USE : ERR_OK;
+	}
+
+	err_t checkLeaseBound(struct netif *netif)
+	{
+		return dhcp_supplied_address(netif) ? ERR_OK : ERR_INPROGRESS;
+	}
+
+	struct PowerProfileSettings
+	{
+		wifi_ps_type_t	powerSave;
+		uint16_t		listenInterval;		///< in beacon intervals
+		const char*		name;
+	};
+
+	// indexed by IDFix::WiFi::PowerProfile
+	const PowerProfileSettings POWER_PROFILES[] =
+	{
+		{ WIFI_PS_NONE,			1,	"low latency" },
+		{ WIFI_PS_MIN_MODEM,	3,	"balanced" },
+		{ WIFI_PS_MAX_MODEM,	10,	"max battery" }
+	};
+
+	void applyDriverTuning(wifi_init_config_t &initConfig, const IDFix::WiFi::DriverTuning &tuning)
+	{
+		#ifdef CONFIG_IDF_TARGET_ESP32
+			if ( tuning.staticRxBuffers != 0 )
+			{
+				initConfig.static_rx_buf_num = tuning.staticRxBuffers;
+			}
+
+			if ( tuning.dynamicRxBuffers != 0 )
+			{
+				initConfig.dynamic_rx_buf_num = tuning.dynamicRxBuffers;
+			}
+
+			if ( tuning.dynamicTxBuffers != 0 )
+			{
+				initConfig.dynamic_tx_buf_num = tuning.dynamicTxBuffers;
+			}
+
+			if ( tuning.ampduRx >= 0 )
+			{
+				initConfig.ampdu_rx_enable = tuning.ampduRx;
+			}
+
+			if ( tuning.ampduTx >= 0 )
+			{
+				initConfig.ampdu_tx_enable = tuning.ampduTx;
+			}
+
+			if ( tuning.rxBAWindow != 0 )
+			{
+				initConfig.rx_ba_win = tuning.rxBAWindow;
+			}
+
+			// the driver refuses a block ack window larger than the static RX buffers
+			if ( initConfig.rx_ba_win > initConfig.static_rx_buf_num )
+			{
+				initConfig.rx_ba_win = initConfig.static_rx_buf_num;
+			}
+		#else
+			(void) initConfig;
+			(void) tuning;
+		#endif
+	}
+
+	struct ScanTiming
+	{
+		bool			passive;
+		uint32_t		minTime;		///< milliseconds per channel
+		uint32_t		maxTime;		///< milliseconds per channel
+	};
+
+	// indexed by IDFix::WiFi::ScanProfile, the adaptive profile starts with a fast pass
+	const ScanTiming SCAN_TIMINGS[] =
+	{
+		{ false,	100,	300 },
+		{ false,	20,		60 },
+		{ false,	200,	600 },
+		{ true,		0,		360 },
+		{ false,	20,		60 }
+	};
+
+	const ScanTiming& scanTiming(IDFix::WiFi::ScanProfile profile)
+	{
+		return SCAN_TIMINGS[static_cast<size_t>(profile)];
+	}
+
+	const PowerProfileSettings& powerProfileSettings(IDFix::WiFi::PowerProfile profile)
+	{
+		return POWER_PROFILES[static_cast<size_t>(profile)];
+	}
 }
 
 namespace IDFix
 {
 	namespace WiFi
 	{
-		WiFi::WiFi(WiFiEventHandler* wiFiEventHandler) : _wiFiEventHandler(wiFiEventHandler)
+		uint32_t reconnectDelay(const ReconnectPolicy &policy, DisconnectCategory category, uint16_t attempts, uint32_t random)
+		{
+			uint64_t delay = policy.initialDelay;
+
+			if ( category == DisconnectCategory::LinkLost && attempts == 0 )
+			{
+				// the access point was reachable just now, so try again right away
+				delay = policy.linkLostDelay;
+			}
+
+			for ( uint16_t attempt = 0; attempt < attempts && delay < policy.maxDelay; attempt++ )
+			{
+				delay *= policy.backoffFactor;
+			}
+
+			if ( delay > policy.maxDelay )
+			{
+				delay = policy.maxDelay;
+			}
+
+			uint8_t jitter = policy.jitter > 100 ? 100 : policy.jitter;
+			uint64_t jitterRange = delay * jitter / 100;
+
+			if ( jitterRange > 0 )
+			{
+				delay = delay - jitterRange + ( random % ( jitterRange + 1 ) );
+			}
+
+			return static_cast<uint32_t>(delay);
+		}
+
+		WiFi::WiFi(WiFiEventHandler* wiFiEventHandler)
 		{
+			_eventHandlers.addHandler(wiFiEventHandler);
+		}
+
+		DriverTuning DriverTuning::throughput()
+		{
+			DriverTuning tuning;
+
+			tuning.staticRxBuffers = 16;
+			tuning.dynamicRxBuffers = 64;
+			tuning.dynamicTxBuffers = 64;
+			tuning.ampduRx = 1;
+			tuning.ampduTx = 1;
+			tuning.rxBAWindow = 16;
+
+			return tuning;
+		}
+
+		DriverTuning DriverTuning::minRAM()
+		{
+			DriverTuning tuning;
 
+			tuning.staticRxBuffers = 4;
+			tuning.dynamicRxBuffers = 8;
+			tuning.dynamicTxBuffers = 8;
+			tuning.ampduRx = 0;
+			tuning.ampduTx = 0;
+
+			return tuning;
 		}
 
 		bool WiFi::init()
+		{
+			return init( DriverTuning() );
+		}
+
+		bool WiFi::init(const DriverTuning &tuning)
 		{
 			esp_err_t result;
 
@@ -66,6 +300,14 @@ namespace IDFix
 
                 result = esp_event_handler_register(WIFI_EVENT,	ESP_EVENT_ANY_ID, WiFi::wifiEventHandlerWrapper, static_cast<void*>(this) );
 
+                if ( result != ESP_OK )
+                {
+                    ESP_LOGE(LOG_TAG, "init: esp_event_handler_register failed: %u", result);
+                    return false;
+                }
+
+                result = esp_event_handler_register(IDFIX_WIFI_EVENT, ESP_EVENT_ANY_ID, WiFi::wifiEventHandlerWrapper, static_cast<void*>(this) );
+
                 if ( result != ESP_OK )
                 {
                     ESP_LOGE(LOG_TAG, "init: esp_event_handler_register failed: %u", result);
@@ -78,6 +320,10 @@ namespace IDFix
 
 				#pragma GCC diagnostic pop
 
+				applyDriverTuning(initConfig, tuning);
+
+				uint32_t freeHeap = esp_get_free_heap_size();
+
 				result = esp_wifi_init(&initConfig);
 				if ( result != ESP_OK )
 				{
@@ -85,6 +331,11 @@ namespace IDFix
 					return false;
 				}
 
+				// other tasks may have freed memory in the meantime, don't let the difference wrap
+				uint32_t freeHeapAfterInit = esp_get_free_heap_size();
+				_driverHeapUsage = freeHeap > freeHeapAfterInit ? freeHeap - freeHeapAfterInit : 0;
+				ESP_LOGI(LOG_TAG, "init: WIFI driver uses %u bytes of heap", static_cast<unsigned>(_driverHeapUsage));
+
 				result = esp_wifi_set_storage(WIFI_STORAGE_RAM);
 				if ( result != ESP_OK )
 				{
@@ -92,17 +343,7 @@ namespace IDFix
 					return false;
 				}
 
-				wifi_country_t countryConfig;
-
-				countryConfig.cc[0] = 'D';
-				countryConfig.cc[1] = 'E';
-				countryConfig.cc[2] = '\0';
-
-				countryConfig.schan = 1;
-				countryConfig.nchan = 13;
-				countryConfig.policy = WIFI_COUNTRY_POLICY_MANUAL;
-
-				esp_wifi_set_country(&countryConfig);
+				applyRegulatoryDomain();
 
 				result = esp_wifi_set_mode(WIFI_MODE_NULL);
 				if ( result != ESP_OK )
@@ -110,6 +351,12 @@ namespace IDFix
 					ESP_LOGE(LOG_TAG, "connectWPA: esp_wifi_set_mode(WIFI_MODE_NULL) failed: %u", result);
 				}
 
+				result = esp_wifi_set_ps(powerProfileSettings(_powerProfile).powerSave);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "init: esp_wifi_set_ps failed: %u", result);
+				}
+
 				_isInitialized = true;
 				return true;
 			}
@@ -119,249 +366,1528 @@ namespace IDFix
 
         void WiFi::wifiEventHandler(void* UNUSED(instance), esp_event_base_t eventBase, int32_t eventID, void *eventData)
 		{
+			EventMethod		eventMethod;
+
+			#if IDFIX_WIFI_EVENT_LOGGING
+				const char*	eventName = eventBase == WIFI_EVENT ? WiFiUtils::wiFiEventTypeToString( eventID ) : WiFiUtils::ipEventTypeToString( eventID );
+			#endif
 
 			if ( eventBase == WIFI_EVENT )
 			{
-				ESP_LOGI(LOG_TAG, "\033[1;92mWIFI_EVENT: %s\033[0m", WiFiUtils::wiFiEventTypeToString( eventID ) );
-
-				switch (eventID)
+				eventMethod = lookupEventMethod(EventBaseIndex::WiFi, eventID);
+			}
+			else if ( eventBase == IP_EVENT )
+			{
+				eventMethod = lookupEventMethod(EventBaseIndex::IP, eventID);
+			}
+			else
+			{
+				if ( eventBase == IDFIX_WIFI_EVENT && eventID == IDFIX_WIFI_EVENT_LEASE_TIMER )
 				{
-					case WIFI_EVENT_STA_START:
-					{
-						_stationInitialized = true;
-						return;
-					}
-
-					case WIFI_EVENT_AP_START:
-					{
-						if ( _wiFiEventHandler != nullptr )
-						{
-                            tcpip_adapter_ip_info_t		apAdapterInfo;
-
-                            tcpip_adapter_get_ip_info(TCPIP_ADAPTER_IF_AP, &apAdapterInfo);
-                            _wiFiEventHandler->accessPointStarted(apAdapterInfo.ip);
-						}
-
-						return;
-					}
-
-					case WIFI_EVENT_AP_STOP:
-					{
-						if ( _wiFiEventHandler != nullptr )
-						{
-							_wiFiEventHandler->accessPointStopped();
-						}
-
-						return;
-					}
-
-					case WIFI_EVENT_STA_DISCONNECTED:
-					{
-						if ( _wiFiEventHandler != nullptr )
-						{
-							_wiFiEventHandler->networkDisconnected();
-						}
-						return;
-					}
-
-					case WIFI_EVENT_AP_STACONNECTED:
-					{
-						return;
-					}
-
-					default:
-						ESP_LOGW(LOG_TAG, "WIFI_EVENT not handled: %s", WiFiUtils::wiFiEventTypeToString( eventID ));
-						return;
+					onLeaseTimer( *static_cast<uint32_t*>(eventData) );
+				}
+				else if ( eventBase == IDFIX_WIFI_EVENT && eventID == IDFIX_WIFI_EVENT_PERSIST_RECORDS )
+				{
+					onPersistRecords();
 				}
 
 				return;
 			}
 
-			if ( eventBase == IP_EVENT )
-			{
-				ESP_LOGI(LOG_TAG, "\033[1;92mIP_EVENT: %s\033[0m", WiFiUtils::ipEventTypeToString( eventID ) );
-
-				switch (eventID)
-				{
-					case IP_EVENT_STA_GOT_IP:
-					{
-						ESP_LOGI(LOG_TAG, "\033[1;92mwifiEventHandler: IP_EVENT: IP_EVENT_STA_GOT_IP\033[0m" );
+			_eventTrace.record(eventBase, eventID, eventData);
+			_connectionTimeline.eventReceived();
 
-						ip_event_got_ip_t* event = static_cast<ip_event_got_ip_t*>(eventData);
+			#if IDFIX_WIFI_EVENT_LOGGING
+				ESP_LOGI(LOG_TAG, "%s", eventName );
+			#endif
 
-						#pragma GCC diagnostic push
-						#pragma GCC diagnostic ignored "-Wold-style-cast"
+			if ( eventMethod == nullptr )
+			{
+				#if IDFIX_WIFI_EVENT_LOGGING
+					ESP_LOGW(LOG_TAG, "event not handled: %s", eventName );
+				#endif
+				return;
+			}
 
-						ESP_LOGI(LOG_TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip) );
+			(this->*eventMethod)(eventData);
+		}
 
-						#pragma GCC diagnostic pop
+		WiFi::EventMethod WiFi::lookupEventMethod(EventBaseIndex eventBase, int32_t eventID)
+		{
+			// events which are expected but need no handling map to onIgnoredEvent, unexpected ones to nullptr
+			static constexpr std::array<EventMethod, WiFiUtils::WIFI_EVENT_COUNT> wiFiEventMethods = []()
+			{
+				std::array<EventMethod, WiFiUtils::WIFI_EVENT_COUNT> methods = {};
 
-                        IPInfo ipInfo;
+				methods[WIFI_EVENT_SCAN_DONE]			= &WiFi::onScanDone;
+				methods[WIFI_EVENT_STA_START]			= &WiFi::onStationStart;
+				methods[WIFI_EVENT_STA_STOP]			= &WiFi::onStationStop;
+				methods[WIFI_EVENT_STA_CONNECTED]		= &WiFi::onStationConnected;
+				methods[WIFI_EVENT_STA_DISCONNECTED]	= &WiFi::onStationDisconnected;
+				methods[WIFI_EVENT_AP_START]			= &WiFi::onAccessPointStart;
+				methods[WIFI_EVENT_AP_STOP]				= &WiFi::onAccessPointStop;
+				methods[WIFI_EVENT_AP_STACONNECTED]		= &WiFi::onIgnoredEvent;
 
-                        ipInfo.ip.addr = event->ip_info.ip.addr;
-                        ipInfo.gateway.addr = event->ip_info.gw.addr;
-                        ipInfo.netMask.addr = event->ip_info.netmask.addr;
+				return methods;
+			}();
 
-						if ( _wiFiEventHandler != nullptr )
-						{
-                            _wiFiEventHandler->networkConnected(ipInfo);
-						}
+			static constexpr std::array<EventMethod, WiFiUtils::IP_EVENT_COUNT> ipEventMethods = []()
+			{
+				std::array<EventMethod, WiFiUtils::IP_EVENT_COUNT> methods = {};
 
-						return;
-					}
+				methods[IP_EVENT_STA_GOT_IP]			= &WiFi::onStationGotIP;
+				methods[IP_EVENT_STA_LOST_IP]			= &WiFi::onStationLostIP;
 
-					case IP_EVENT_STA_LOST_IP:
-					{
-						if ( _wiFiEventHandler != nullptr )
-						{
-							_wiFiEventHandler->networkDisconnected();
-						}
-						return;
-					}
+				return methods;
+			}();
 
-					default:
+			if ( eventID < 0 )
+			{
+				return nullptr;
+			}
 
-						ESP_LOGW(LOG_TAG, "IP_EVENT not handled: %s", WiFiUtils::ipEventTypeToString( eventID ) );
-						return;
-				}
+			switch (eventBase)
+			{
+				case EventBaseIndex::WiFi:
+					return static_cast<size_t>(eventID) < wiFiEventMethods.size() ? wiFiEventMethods[eventID] : nullptr;
 
-				return;
+				case EventBaseIndex::IP:
+					return static_cast<size_t>(eventID) < ipEventMethods.size() ? ipEventMethods[eventID] : nullptr;
 			}
 
+			return nullptr;
 		}
 
-        void WiFi::wifiEventHandlerWrapper(void *instance, esp_event_base_t eventBase, int32_t eventID, void *eventData)
-        {
-            WiFi *objectInstance = static_cast<WiFi*>(instance);
-
-            if ( objectInstance != nullptr )
-            {
-                objectInstance->wifiEventHandler(instance, eventBase, eventID, eventData);
-            }
-        }
-
-		bool WiFi::connectWPA(const char *ssid, const char *password)
+		void WiFi::onIgnoredEvent(void* UNUSED(eventData))
 		{
-			esp_err_t		result;
-			wifi_config_t	wifiConfigSTA = {};
-			wifi_mode_t		currentMode, newMode;
-
-			if ( _isInitialized )
-			{
-                #ifdef CONFIG_IDF_TARGET_ESP32
-
-                    if ( _stationInterface == nullptr )
-                    {
-                        _stationInterface = esp_netif_create_default_wifi_sta();
-
-                        if ( _stationInterface == nullptr )
-                        {
-                            ESP_LOGE(LOG_TAG, "startAP: esp_netif_create_default_wifi_ap failed");
-                            return false;
-                        }
-                    }
-
-                #endif
 
-                if ( _stationEventsRegistered == false )
-                {
-                    result = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, WiFi::wifiEventHandlerWrapper, static_cast<void*>(this) );
-                    if ( result != ESP_OK )
-                    {
-                        ESP_LOGE(LOG_TAG, "connectWPA: esp_event_handler_register failed: %u", result);
-                        return false;
-                    }
+		}
 
-                    result = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_LOST_IP, WiFi::wifiEventHandlerWrapper, static_cast<void*>(this) );
-                    if ( result != ESP_OK )
-                    {
-                        ESP_LOGE(LOG_TAG, "connectWPA: esp_event_handler_register failed: %u", result);
-                        return false;
-                    }
+		void WiFi::onStationStart(void* UNUSED(eventData))
+		{
+			_stationInitialized = true;
+			_connectionTimeline.stationStarted();
+		}
 
-                    _stationEventsRegistered = true;
-                }
+		void WiFi::onStationStop(void* UNUSED(eventData))
+		{
+			// the radio mode manager stops the driver once nobody uses the radio, the next connect starts it again
+			_stationInitialized = false;
+		}
 
-				// check if we're already in AP mode and set mode accordingly
-				result = esp_wifi_get_mode(&currentMode);
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "connectWPA: esp_wifi_get_mode failed: %u", result);
-					return false;
-				}
+		void WiFi::onScanDone(void *eventData)
+		{
+			if ( _blockingScanEvents > 0 )
+			{
+				// blocking scans and probes are finished by their callers, the events arrive in the order the scans were started
+				_blockingScanEvents--;
+				return;
+			}
 
-				ESP_LOGV(LOG_TAG, "current wifi mode: %d", currentMode);
+			if ( _scanPending && _scanAsync )
+			{
+				wifi_event_sta_scan_done_t* event = static_cast<wifi_event_sta_scan_done_t*>(eventData);
 
-				switch (currentMode)
+				if ( event->status != 0 )
 				{
-					case WIFI_MODE_AP:
-					case WIFI_MODE_APSTA:
-						newMode = WIFI_MODE_APSTA;
-						break;
-					default:
-						newMode = WIFI_MODE_STA;
+					ESP_LOGW(LOG_TAG, "WIFI_EVENT_SCAN_DONE: scan finished with status %u", event->status);
 				}
 
-				result = esp_wifi_set_mode(newMode);
-				if ( result != ESP_OK )
+				if ( scanNextChannel(false) )
 				{
-					ESP_LOGE(LOG_TAG, "connectWPA: esp_wifi_set_mode failed: %u", result);
-					return false;
+					return;
 				}
 
-				memset(&wifiConfigSTA, 0, sizeof(wifiConfigSTA) );
-
-				wifiConfigSTA.sta.channel			= 0;
-				wifiConfigSTA.sta.scan_method		=	WIFI_ALL_CHANNEL_SCAN;
-
-				#ifdef CONFIG_IDF_TARGET_ESP8266
-                    wifiConfigSTA.sta.pmf_cfg.capable	= true;
-                    wifiConfigSTA.sta.pmf_cfg.required	= false;
-                #endif
+				int16_t apCount = finishScan();
 
-				strncpy( reinterpret_cast<char *>(wifiConfigSTA.sta.ssid),		ssid,		sizeof(wifiConfigSTA.sta.ssid) );
-				strncpy( reinterpret_cast<char *>(wifiConfigSTA.sta.password),	password,	sizeof(wifiConfigSTA.sta.password) );
+				// the flags belong to the owner of the scan slot, so read them before releasing it
+				bool roaming = _roamingScanPending;
 
-				result = esp_wifi_set_config(WIFI_IF_STA, &wifiConfigSTA);
-				if ( result != ESP_OK )
+				if ( roaming && apCount > 0 )
 				{
-					ESP_LOGE(LOG_TAG, "connectWPA: esp_wifi_set_config failed: %u", result);
-					return false;
+					// roaming scans are our own business, the handler doesn't know about them
+					roamToBestAccessPoint();
 				}
 
-				result = esp_wifi_start();
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "connectWPA: esp_wifi_start failed: %u", result);
-					return false;
-				}
+				_roamingScanPending = false;
+				_scanAsync = false;
+				_scanPending = false;
 
-				result = esp_wifi_connect();
-				if ( result != ESP_OK )
+				if ( ! roaming )
 				{
-					ESP_LOGE(LOG_TAG, "connectWPA: esp_wifi_connect failed: %u", result);
+					notifyScanFinished(apCount);
 				}
-
-			}
-			else
-			{
-				ESP_LOGE(LOG_TAG, "connectWPA: WiFi is not initialized");
-				return false;
 			}
-
-			return true;
 		}
 
-		bool WiFi::connectWPA(const std::string &ssid, const std::string &password)
+		void WiFi::onAccessPointStart(void* UNUSED(eventData))
 		{
-			return connectWPA( ssid.c_str(), password.c_str() );
+			tcpip_adapter_ip_info_t		apAdapterInfo;
+
+			tcpip_adapter_get_ip_info(TCPIP_ADAPTER_IF_AP, &apAdapterInfo);
+			notifyAccessPointStarted(apAdapterInfo.ip);
 		}
 
-		bool WiFi::startAP(const char *ssid, const char *password)
+		void WiFi::onAccessPointStop(void* UNUSED(eventData))
+		{
+			notifyAccessPointStopped();
+		}
+
+		void WiFi::onStationConnected(void *eventData)
+		{
+			_fastConnectAttempt = false;
+			_rssiSampler.reset();
+			_connectionTimeline.stationConnected();
+
+			wifi_event_sta_connected_t* event = static_cast<wifi_event_sta_connected_t*>(eventData);
+			memcpy(_connectedBSSID, event->bssid, sizeof(_connectedBSSID));
+
+			if ( _fastReconnect )
+			{
+				if ( _connectionRecord.remember(event->ssid, event->ssid_len, event->bssid, event->channel) )
+				{
+					schedulePersist();
+				}
+			}
+
+			if ( _leaseCaching && _leaseRecord.matches(event->bssid) )
+			{
+				probeCachedLease();
+			}
+		}
+
+		void WiFi::onStationDisconnected(void *eventData)
+		{
+			wifi_event_sta_disconnected_t* event = static_cast<wifi_event_sta_disconnected_t*>(eventData);
+			DisconnectCategory category = WiFiUtils::classifyDisconnectReason(event->reason);
+
+			_lastDisconnectReason = event->reason;
+			_stationConnected = false;
+			ESP_LOGI(LOG_TAG, "station disconnected, reason %u (%s)", event->reason, WiFiUtils::disconnectCategoryToString(category) );
+
+			if ( _leaseMutex != nullptr )
+			{
+				// a lease which was not confirmed yet may be the reason we got kicked
+				releaseCachedLease( category != DisconnectCategory::LocalRequest );
+			}
+
+			if ( _roamingInProgress )
+			{
+				_roamingInProgress = false;
+
+				if ( category == DisconnectCategory::LocalRequest )
+				{
+					// we left the old access point on purpose, now join the new one
+					_connectionTimeline.connectRequested(false);
+
+					esp_err_t result = esp_wifi_connect();
+					if ( result != ESP_OK )
+					{
+						ESP_LOGE(LOG_TAG, "roaming: esp_wifi_connect failed: %u", result);
+					}
+
+					notifyNetworkDisconnected();
+
+					return;
+				}
+			}
+
+			if ( _fastConnectAttempt )
+			{
+				_fastConnectAttempt = false;
+
+				// the remembered access point is gone, don't bother the handler but search all channels
+				if ( category != DisconnectCategory::AuthFailure && fallbackToFullScan() )
+				{
+					return;
+				}
+			}
+
+			notifyNetworkDisconnected();
+
+			if ( category == DisconnectCategory::LocalRequest )
+			{
+				_connectionTimeline.cancel();
+				resetReconnect();
+				return;
+			}
+
+			if ( _reconnectPolicy.enabled && _stationRequested && ! scheduleReconnect(category) )
+			{
+				notifyReconnectFailed(category);
+			}
+		}
+
+		void WiFi::onStationGotIP(void *eventData)
+		{
+			ip_event_got_ip_t* event = static_cast<ip_event_got_ip_t*>(eventData);
+
+			#if IDFIX_WIFI_EVENT_LOGGING
+				#pragma GCC diagnostic push
+				#pragma GCC diagnostic ignored "-Wold-style-cast"
+
+				ESP_LOGI(LOG_TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip) );
+
+				#pragma GCC diagnostic pop
+			#endif
+
+			IPInfo ipInfo;
+
+			ipInfo.ip.addr = event->ip_info.ip.addr;
+			ipInfo.gateway.addr = event->ip_info.gw.addr;
+			ipInfo.netMask.addr = event->ip_info.netmask.addr;
+
+			if ( _leaseCaching )
+			{
+				xSemaphoreTakeRecursive(_leaseMutex, portMAX_DELAY);
+
+				LeaseState	leaseState = _leaseState;
+				bool		renewed = leaseState == LeaseState::Renewing || leaseState == LeaseState::Bound;
+				bool		confirmed = renewed && _stationConnected && ipInfo.ip.addr == _leaseRecord.getIP();
+
+				if ( leaseState == LeaseState::Probing )
+				{
+					// DHCP was faster than the probe
+					stopLeaseTimer();
+					_leaseState = LeaseState::Unused;
+				}
+				else if ( renewed )
+				{
+					_leaseState = LeaseState::Bound;
+				}
+
+				if ( leaseState != LeaseState::Applied && _leaseRecord.remember(_connectedBSSID, ipInfo.ip.addr, ipInfo.netMask.addr, ipInfo.gateway.addr) )
+				{
+					schedulePersist();
+				}
+
+				xSemaphoreGiveRecursive(_leaseMutex);
+
+				if ( confirmed )
+				{
+					// the DHCP server handed out the cached address again, the handler knows it already
+					return;
+				}
+			}
+
+			resetReconnect();
+			_stationConnected = true;
+			_connectionTimeline.gotIP();
+
+			notifyNetworkConnected(ipInfo);
+		}
+
+		void WiFi::onStationLostIP(void* UNUSED(eventData))
+		{
+			_stationConnected = false;
+
+			if ( _leaseCaching )
+			{
+				_leaseRecord.clear();
+			}
+
+			notifyNetworkDisconnected();
+		}
+
+		bool WiFi::addEventHandler(WiFiEventHandler *handler, int8_t priority)
+		{
+			return _eventHandlers.addHandler(handler, priority);
+		}
+
+		bool WiFi::removeEventHandler(WiFiEventHandler *handler)
+		{
+			return _eventHandlers.removeHandler(handler);
+		}
+
+		bool WiFi::enableEventDispatcher(uint32_t stackSize, UBaseType_t priority)
+		{
+			if ( _eventDispatcher == nullptr )
+			{
+				_eventDispatcher = new WiFiEventDispatcher(&_eventHandlers);
+			}
+
+			if ( ! _eventDispatcher->start(stackSize, priority) )
+			{
+				// without its task the dispatcher would swallow all notifications, so deliver them directly again
+				delete _eventDispatcher;
+				_eventDispatcher = nullptr;
+
+				ESP_LOGE(LOG_TAG, "enableEventDispatcher: the dispatcher could not be started");
+				return false;
+			}
+
+			return true;
+		}
+
+		void WiFi::dispatch(const HandlerNotification &notification)
+		{
+			if ( _eventDispatcher != nullptr )
+			{
+				if ( ! _eventDispatcher->post(notification) )
+				{
+					ESP_LOGW(LOG_TAG, "event dispatcher queue full, notification dropped");
+				}
+
+				return;
+			}
+
+			_eventHandlers.deliver(notification);
+		}
+
+		void WiFi::notifyNetworkConnected(const IPInfo &ipInfo)
+		{
+			HandlerNotification notification;
+
+			notification.type = HandlerNotification::Type::NetworkConnected;
+			notification.ipInfo = ipInfo;
+			dispatch(notification);
+		}
+
+		void WiFi::notifyNetworkDisconnected()
+		{
+			HandlerNotification notification;
+
+			notification.type = HandlerNotification::Type::NetworkDisconnected;
+			dispatch(notification);
+		}
+
+		void WiFi::notifyAccessPointStarted(ip4_addr_t accessPointIPAddress)
+		{
+			HandlerNotification notification;
+
+			notification.type = HandlerNotification::Type::AccessPointStarted;
+			notification.accessPointIPAddress = accessPointIPAddress;
+			dispatch(notification);
+		}
+
+		void WiFi::notifyAccessPointStopped()
+		{
+			HandlerNotification notification;
+
+			notification.type = HandlerNotification::Type::AccessPointStopped;
+			dispatch(notification);
+		}
+
+		void WiFi::notifyScanFinished(int16_t apCount)
+		{
+			HandlerNotification notification;
+
+			notification.type = HandlerNotification::Type::ScanFinished;
+			notification.apCount = apCount;
+			dispatch(notification);
+		}
+
+		void WiFi::notifyReconnectFailed(DisconnectCategory category)
+		{
+			HandlerNotification notification;
+
+			notification.type = HandlerNotification::Type::ReconnectFailed;
+			notification.category = category;
+			dispatch(notification);
+		}
+
+        void WiFi::reconnectTimerCallback(void *instance)
+        {
+            WiFi *objectInstance = static_cast<WiFi*>(instance);
+
+            if ( objectInstance != nullptr && objectInstance->_stationRequested )
+            {
+                ESP_LOGI(LOG_TAG, "reconnect attempt %u", objectInstance->_reconnectAttempts);
+
+                // if the access point is pinned and gone, fall back to a full scan right away
+                objectInstance->_fastConnectAttempt = objectInstance->_bssidPinned;
+                objectInstance->_connectionTimeline.connectRequested(false);
+
+                esp_err_t result = esp_wifi_connect();
+                if ( result != ESP_OK )
+                {
+                    ESP_LOGE(LOG_TAG, "reconnectTimerCallback: esp_wifi_connect failed: %u", result);
+                }
+            }
+        }
+
+        void WiFi::roamingTimerCallback(void *instance)
+        {
+            WiFi *objectInstance = static_cast<WiFi*>(instance);
+
+            if ( objectInstance != nullptr )
+            {
+                objectInstance->checkRoaming();
+            }
+        }
+
+        void WiFi::leaseTimerCallback(void *instance)
+        {
+            WiFi *objectInstance = static_cast<WiFi*>(instance);
+
+            if ( objectInstance == nullptr )
+            {
+                return;
+            }
+
+            // the lease state may notify the handlers, which must only happen on the default event loop
+            uint32_t generation = objectInstance->_leaseTimerGeneration;
+
+            esp_err_t result = esp_event_post(IDFIX_WIFI_EVENT, IDFIX_WIFI_EVENT_LEASE_TIMER, &generation, sizeof(generation), 0);
+            if ( result != ESP_OK )
+            {
+                ESP_LOGE(LOG_TAG, "leaseTimerCallback: esp_event_post failed: %u", result);
+
+                // the event queue is full, try again later
+                result = esp_timer_start_once(objectInstance->_leaseTimer, static_cast<uint64_t>(LEASE_POLL_INTERVAL) * 1000);
+                if ( result != ESP_OK )
+                {
+                    ESP_LOGE(LOG_TAG, "leaseTimerCallback: esp_timer_start_once failed: %u", result);
+                }
+            }
+        }
+
+        void WiFi::wifiEventHandlerWrapper(void *instance, esp_event_base_t eventBase, int32_t eventID, void *eventData)
+        {
+            WiFi *objectInstance = static_cast<WiFi*>(instance);
+
+            if ( objectInstance != nullptr )
+            {
+                objectInstance->wifiEventHandler(instance, eventBase, eventID, eventData);
+            }
+        }
+
+		void WiFi::schedulePersist()
+		{
+			// the flash write blocks the event loop for milliseconds, so let the events already queued go first
+			esp_err_t result = esp_event_post(IDFIX_WIFI_EVENT, IDFIX_WIFI_EVENT_PERSIST_RECORDS, nullptr, 0, 0);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGW(LOG_TAG, "schedulePersist: esp_event_post failed: %u", result);
+				onPersistRecords();
+			}
+		}
+
+		void WiFi::onPersistRecords()
+		{
+			_connectionRecord.persist();
+
+			if ( _leaseMutex != nullptr )
+			{
+				xSemaphoreTakeRecursive(_leaseMutex, portMAX_DELAY);
+				_leaseRecord.persist();
+				xSemaphoreGiveRecursive(_leaseMutex);
+			}
+		}
+
+		bool WiFi::connectWPA(const char *ssid, const char *password)
+		{
+			return connectStation(ssid, password, nullptr, 0);
+		}
+
+		bool WiFi::scanAndConnect(const std::string &ssid, const std::string &password)
+		{
+			if ( ! _isInitialized )
+			{
+				ESP_LOGE(LOG_TAG, "scanAndConnect: WiFi is not initialized");
+				return false;
+			}
+
+			if ( ! _scanCache.covers(ssid) && scan(ssid) < 0 )
+			{
+				return false;
+			}
+
+			// a copy, a roaming scan may replace the records while we connect
+			wifi_ap_record_t accessPoint;
+
+			if ( ! _scanCache.findStrongest(ssid, accessPoint) )
+			{
+				ESP_LOGW(LOG_TAG, "scanAndConnect: %s is not visible", ssid.c_str());
+				return false;
+			}
+
+			return connectStation(ssid.c_str(), password.c_str(), accessPoint.bssid, accessPoint.primary);
+		}
+
+		bool WiFi::connectStation(const char *ssid, const char *password, const uint8_t *bssid, uint8_t channel)
+		{
+			esp_err_t		result;
+			wifi_config_t	wifiConfigSTA = {};
+
+			if ( _isInitialized )
+			{
+                #ifdef CONFIG_IDF_TARGET_ESP32
+
+                    if ( _stationInterface == nullptr )
+                    {
+                        _stationInterface = esp_netif_create_default_wifi_sta();
+
+                        if ( _stationInterface == nullptr )
+                        {
+                            ESP_LOGE(LOG_TAG, "startAP: esp_netif_create_default_wifi_ap failed");
+                            return false;
+                        }
+                    }
+
+                #endif
+
+                if ( _stationEventsRegistered == false )
+                {
+                    result = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, WiFi::wifiEventHandlerWrapper, static_cast<void*>(this) );
+                    if ( result != ESP_OK )
+                    {
+                        ESP_LOGE(LOG_TAG, "connectStation: esp_event_handler_register failed: %u", result);
+                        return false;
+                    }
+
+                    result = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_LOST_IP, WiFi::wifiEventHandlerWrapper, static_cast<void*>(this) );
+                    if ( result != ESP_OK )
+                    {
+                        ESP_LOGE(LOG_TAG, "connectStation: esp_event_handler_register failed: %u", result);
+                        return false;
+                    }
+
+                    _stationEventsRegistered = true;
+                }
+
+				// a running access point keeps running next to the station
+				if ( ! _radio.isUsedBy(RadioModeManager::UserStation) && ! _radio.acquire(RadioModeManager::UserStation) )
+				{
+					ESP_LOGE(LOG_TAG, "connectStation: enabling the station failed");
+					return false;
+				}
+
+				memset(&wifiConfigSTA, 0, sizeof(wifiConfigSTA) );
+
+				wifiConfigSTA.sta.channel			= 0;
+				wifiConfigSTA.sta.scan_method		=	WIFI_ALL_CHANNEL_SCAN;
+				wifiConfigSTA.sta.listen_interval	= powerProfileSettings(_powerProfile).listenInterval;
+
+				if ( _fastReconnect && ! _connectionRecordLoaded )
+				{
+					_connectionRecord.load();
+					_connectionRecordLoaded = true;
+				}
+
+				_fastConnectAttempt = false;
+				_bssidPinned = false;
+				_stationRequested = true;
+				resetReconnect();
+
+				_connectionTimeline.connectRequested( ! _stationInitialized );
+
+				if ( bssid != nullptr )
+				{
+					// the access point was just found by a scan, join it without searching again
+					wifiConfigSTA.sta.bssid_set		= true;
+					wifiConfigSTA.sta.channel		= channel;
+					wifiConfigSTA.sta.scan_method	= WIFI_FAST_SCAN;
+					memcpy(wifiConfigSTA.sta.bssid, bssid, sizeof(wifiConfigSTA.sta.bssid));
+
+					_fastConnectAttempt = true;
+					_bssidPinned = true;
+				}
+				else if ( _fastReconnect && _connectionRecord.matches(ssid) )
+				{
+					// try the access point of the last connection directly, see fallbackToFullScan()
+					wifiConfigSTA.sta.bssid_set		= true;
+					wifiConfigSTA.sta.channel		= _connectionRecord.getChannel();
+					wifiConfigSTA.sta.scan_method	= WIFI_FAST_SCAN;
+					memcpy(wifiConfigSTA.sta.bssid, _connectionRecord.getBSSID(), sizeof(wifiConfigSTA.sta.bssid));
+
+					_fastConnectAttempt = true;
+					_bssidPinned = true;
+				}
+				else
+				{
+					if ( _channelPlan != 0 && ! _scanCache.covers(ssid) )
+					{
+						// searching the planned channels is faster than letting the driver sweep all of them
+						if ( _radio.start() && scan(ssid) <= 0 )
+						{
+							ESP_LOGW(LOG_TAG, "connectStation: %s not found on the planned channels", ssid);
+						}
+					}
+
+					wifi_ap_record_t cachedAP;
+
+					_scanCache.lock();
+					bool cached = _scanCache.covers(ssid) && _scanCache.findStrongest(ssid, cachedAP);
+					_scanCache.unlock();
+
+					if ( cached )
+					{
+						// we've just seen the network, so start searching on its channel and stop at the first match
+						wifiConfigSTA.sta.channel		= cachedAP.primary;
+						wifiConfigSTA.sta.scan_method	= WIFI_FAST_SCAN;
+					}
+				}
+
+				#ifdef CONFIG_IDF_TARGET_ESP8266
+                    wifiConfigSTA.sta.pmf_cfg.capable	= true;
+                    wifiConfigSTA.sta.pmf_cfg.required	= false;
+                #endif
+
+				strncpy( reinterpret_cast<char *>(wifiConfigSTA.sta.ssid),		ssid,		sizeof(wifiConfigSTA.sta.ssid) );
+				strncpy( reinterpret_cast<char *>(wifiConfigSTA.sta.password),	password,	sizeof(wifiConfigSTA.sta.password) );
+
+				result = esp_wifi_set_config(WIFI_IF_STA, &wifiConfigSTA);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "connectStation: esp_wifi_set_config failed: %u", result);
+					return false;
+				}
+
+				if ( _radio.start() == false )
+				{
+					ESP_LOGE(LOG_TAG, "connectStation: starting the radio failed");
+					return false;
+				}
+
+				result = esp_wifi_connect();
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "connectStation: esp_wifi_connect failed: %u", result);
+				}
+
+			}
+			else
+			{
+				ESP_LOGE(LOG_TAG, "connectStation: WiFi is not initialized");
+				return false;
+			}
+
+			return true;
+		}
+
+		bool WiFi::connectWPA(const std::string &ssid, const std::string &password)
+		{
+			return connectWPA( ssid.c_str(), password.c_str() );
+		}
+
+		void WiFi::addNetworkProfile(const std::string &ssid, const std::string &password, int8_t priority)
+		{
+			for ( NetworkProfile &profile : _networkProfiles )
+			{
+				if ( profile.ssid == ssid )
+				{
+					profile.password = password;
+					profile.priority = priority;
+					return;
+				}
+			}
+
+			NetworkProfile profile;
+
+			profile.ssid = ssid;
+			profile.password = password;
+			profile.priority = priority;
+
+			_networkProfiles.push_back(profile);
+		}
+
+		bool WiFi::removeNetworkProfile(const std::string &ssid)
+		{
+			for ( auto profile = _networkProfiles.begin(); profile != _networkProfiles.end(); ++profile )
+			{
+				if ( profile->ssid == ssid )
+				{
+					_networkProfiles.erase(profile);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		void WiFi::clearNetworkProfiles()
+		{
+			_networkProfiles.clear();
+		}
+
+		bool WiFi::connectBestNetwork()
+		{
+			if ( _networkProfiles.empty() )
+			{
+				ESP_LOGE(LOG_TAG, "connectBestNetwork: no network profiles");
+				return false;
+			}
+
+			bool needsScan = false;
+
+			for ( const NetworkProfile &profile : _networkProfiles )
+			{
+				if ( ! _scanCache.covers(profile.ssid) )
+				{
+					needsScan = true;
+					break;
+				}
+			}
+
+			if ( needsScan && scan() < 0 )
+			{
+				return false;
+			}
+
+			const NetworkProfile*	bestProfile = nullptr;
+			wifi_ap_record_t		bestAP = {};
+			int						bestScore = 0;
+
+			_scanCache.lock();
+
+			// the records are sorted by RSSI, so the first match of a profile is its strongest access point
+			for ( size_t index = 0; index < _scanCache.size(); index++ )
+			{
+				std::string ssid = _scanCache.getSSID(index);
+
+				for ( const NetworkProfile &profile : _networkProfiles )
+				{
+					if ( profile.ssid != ssid )
+					{
+						continue;
+					}
+
+					int score = _scanCache.getRSSI(index) + profile.priority * PROFILE_PRIORITY_WEIGHT;
+
+					if ( bestProfile == nullptr || score > bestScore )
+					{
+						bestProfile = &profile;
+						memcpy(bestAP.bssid, _scanCache.getBSSID(index), sizeof(bestAP.bssid));
+						bestAP.primary = _scanCache.getChannel(index);
+						bestScore = score;
+					}
+				}
+			}
+
+			_scanCache.unlock();
+
+			if ( bestProfile == nullptr )
+			{
+				ESP_LOGW(LOG_TAG, "connectBestNetwork: none of the known networks is visible");
+				return false;
+			}
+
+			ESP_LOGI(LOG_TAG, "connectBestNetwork: connecting to %s", bestProfile->ssid.c_str());
+
+			// we know the access point already, so don't let the driver search it again
+			return connectStation(bestProfile->ssid.c_str(), bestProfile->password.c_str(), bestAP.bssid, bestAP.primary);
+		}
+
+		void WiFi::setFastReconnect(bool enabled)
+		{
+			_fastReconnect = enabled;
+		}
+
+		bool WiFi::setDHCPLeaseCaching(bool enabled, uint32_t renewDelay)
+		{
+			if ( enabled && _leaseMutex == nullptr )
+			{
+				_leaseMutex = xSemaphoreCreateRecursiveMutex();
+				if ( _leaseMutex == nullptr )
+				{
+					ESP_LOGE(LOG_TAG, "setDHCPLeaseCaching: xSemaphoreCreateRecursiveMutex failed");
+					return false;
+				}
+			}
+
+			if ( enabled && _leaseTimer == nullptr )
+			{
+				esp_timer_create_args_t timerArgs = {};
+
+				timerArgs.callback = &WiFi::leaseTimerCallback;
+				timerArgs.arg = static_cast<void*>(this);
+				timerArgs.name = "wifi_lease";
+
+				esp_err_t result = esp_timer_create(&timerArgs, &_leaseTimer);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "setDHCPLeaseCaching: esp_timer_create failed: %u", result);
+					return false;
+				}
+			}
+
+			if ( enabled && ! _leaseCaching )
+			{
+				_leaseRecord.load();
+			}
+
+			_leaseCaching = enabled;
+			_leaseRenewDelay = renewDelay;
+
+			return true;
+		}
+
+		bool WiFi::probeCachedLease()
+		{
+			struct netif*	netif = stationNetif();
+			bool			probing = false;
+
+			if ( netif == nullptr )
+			{
+				ESP_LOGE(LOG_TAG, "probeCachedLease: the station has no network interface");
+				return false;
+			}
+
+			xSemaphoreTakeRecursive(_leaseMutex, portMAX_DELAY);
+
+			// another host may have got the address while we were away
+			leaseProbeAddress.addr = _leaseRecord.getIP();
+
+			err_t error = netifapi_netif_common(netif, nullptr, &sendLeaseProbe);
+			if ( error != ERR_OK )
+			{
+				ESP_LOGE(LOG_TAG, "probeCachedLease: etharp_query failed: %d", error);
+			}
+			else
+			{
+				stopLeaseTimer();
+
+				esp_err_t result = esp_timer_start_once(_leaseTimer, static_cast<uint64_t>(LEASE_PROBE_TIME) * 1000);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "probeCachedLease: esp_timer_start_once failed: %u", result);
+				}
+				else
+				{
+					_leaseState = LeaseState::Probing;
+					probing = true;
+				}
+			}
+
+			xSemaphoreGiveRecursive(_leaseMutex);
+
+			return probing;
+		}
+
+		void WiFi::stopLeaseTimer()
+		{
+			// an event of the stopped timer may still be queued, onLeaseTimer() drops it by its generation
+			esp_timer_stop(_leaseTimer);
+			_leaseTimerGeneration++;
+		}
+
+		void WiFi::onLeaseTimer(uint32_t generation)
+		{
+			xSemaphoreTakeRecursive(_leaseMutex, portMAX_DELAY);
+
+			if ( generation != _leaseTimerGeneration )
+			{
+				xSemaphoreGiveRecursive(_leaseMutex);
+				return;
+			}
+
+			switch ( _leaseState )
+			{
+				case LeaseState::Probing:
+					applyCachedLease();
+					break;
+
+				case LeaseState::Applied:
+					renewCachedLease();
+					break;
+
+				case LeaseState::Renewing:
+					checkLeaseRenewal();
+					break;
+
+				default:
+					// the lease was released or bound while the timer fired
+					break;
+			}
+
+			xSemaphoreGiveRecursive(_leaseMutex);
+		}
+
+		bool WiFi::applyCachedLease()
+		{
+			tcpip_adapter_ip_info_t ipInfo;
+			esp_err_t				result;
+			struct netif*			netif = stationNetif();
+
+			if ( netif == nullptr || netifapi_netif_common(netif, nullptr, &checkLeaseProbe) != ERR_OK )
+			{
+				ESP_LOGW(LOG_TAG, "applyCachedLease: the cached address is in use, waiting for DHCP");
+
+				_leaseState = LeaseState::Unused;
+				_leaseRecord.clear();
+
+				return false;
+			}
+
+			ipInfo.ip.addr = _leaseRecord.getIP();
+			ipInfo.netmask.addr = _leaseRecord.getNetMask();
+			ipInfo.gw.addr = _leaseRecord.getGateway();
+
+			result = tcpip_adapter_dhcpc_stop(TCPIP_ADAPTER_IF_STA);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "applyCachedLease: tcpip_adapter_dhcpc_stop failed: %u", result);
+				_leaseState = LeaseState::Unused;
+				return false;
+			}
+
+			// setting the address reports IP_EVENT_STA_GOT_IP right away, which has to see the new state
+			_leaseState = LeaseState::Applied;
+
+			result = tcpip_adapter_set_ip_info(TCPIP_ADAPTER_IF_STA, &ipInfo);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "applyCachedLease: tcpip_adapter_set_ip_info failed: %u", result);
+				_leaseState = LeaseState::Unused;
+				tcpip_adapter_dhcpc_start(TCPIP_ADAPTER_IF_STA);
+				return false;
+			}
+
+			result = esp_timer_start_once(_leaseTimer, static_cast<uint64_t>(_leaseRenewDelay) * 1000);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "applyCachedLease: esp_timer_start_once failed: %u", result);
+			}
+
+			return true;
+		}
+
+		bool WiFi::renewCachedLease()
+		{
+			struct netif*	netif = stationNetif();
+			uint32_t		delay = LEASE_POLL_INTERVAL;
+			bool			renewing = false;
+
+			// tcpip_adapter_dhcpc_start() would take the address off the interface until the server answers
+			err_t error = netif != nullptr ? netifapi_dhcp_start(netif) : ERR_IF;
+			if ( error != ERR_OK )
+			{
+				ESP_LOGE(LOG_TAG, "renewCachedLease: dhcp_start failed: %d", error);
+
+				// keep the cached address and try again later
+				delay = _leaseRenewDelay;
+			}
+			else
+			{
+				_leaseState = LeaseState::Renewing;
+				renewing = true;
+			}
+
+			esp_err_t result = esp_timer_start_once(_leaseTimer, static_cast<uint64_t>(delay) * 1000);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "renewCachedLease: esp_timer_start_once failed: %u", result);
+			}
+
+			return renewing;
+		}
+
+		void WiFi::checkLeaseRenewal()
+		{
+			tcpip_adapter_ip_info_t	leaseInfo;
+			struct netif*			netif = stationNetif();
+
+			if ( netif == nullptr || netifapi_netif_common(netif, nullptr, &checkLeaseBound) != ERR_OK )
+			{
+				// the client keeps asking as long as the link is up
+				esp_err_t result = esp_timer_start_once(_leaseTimer, static_cast<uint64_t>(LEASE_POLL_INTERVAL) * 1000);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "checkLeaseRenewal: esp_timer_start_once failed: %u", result);
+				}
+
+				return;
+			}
+
+			esp_err_t result = tcpip_adapter_get_ip_info(TCPIP_ADAPTER_IF_STA, &leaseInfo);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "checkLeaseRenewal: tcpip_adapter_get_ip_info failed: %u", result);
+				return;
+			}
+
+			_leaseState = LeaseState::Bound;
+
+			if ( leaseInfo.ip.addr == _leaseRecord.getIP() )
+			{
+				// the DHCP server handed out the cached address again, the handler knows it already
+				if ( _leaseRecord.remember(_connectedBSSID, leaseInfo.ip.addr, leaseInfo.netmask.addr, leaseInfo.gw.addr) )
+				{
+					schedulePersist();
+				}
+
+				return;
+			}
+
+			ESP_LOGI(LOG_TAG, "the DHCP server did not confirm the cached lease");
+
+			if ( _leaseRecord.remember(_connectedBSSID, leaseInfo.ip.addr, leaseInfo.netmask.addr, leaseInfo.gw.addr) )
+			{
+				schedulePersist();
+			}
+
+			IPInfo ipInfo;
+
+			ipInfo.ip.addr = leaseInfo.ip.addr;
+			ipInfo.gateway.addr = leaseInfo.gw.addr;
+			ipInfo.netMask.addr = leaseInfo.netmask.addr;
+
+			notifyNetworkConnected(ipInfo);
+		}
+
+		void WiFi::releaseCachedLease(bool discard)
+		{
+			xSemaphoreTakeRecursive(_leaseMutex, portMAX_DELAY);
+
+			LeaseState leaseState = _leaseState;
+
+			stopLeaseTimer();
+			_leaseState = LeaseState::Unused;
+
+			// while probing the DHCP client of the adapter keeps running
+			if ( leaseState != LeaseState::Unused && leaseState != LeaseState::Probing )
+			{
+				if ( discard && leaseState != LeaseState::Bound )
+				{
+					_leaseRecord.clear();
+				}
+
+				struct netif* netif = stationNetif();
+
+				if ( leaseState != LeaseState::Applied && netif != nullptr )
+				{
+					netifapi_dhcp_stop(netif);
+				}
+
+				// the next connect has to use DHCP again, the client waits for the link by itself
+				esp_err_t result = tcpip_adapter_dhcpc_start(TCPIP_ADAPTER_IF_STA);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "releaseCachedLease: tcpip_adapter_dhcpc_start failed: %u", result);
+				}
+			}
+
+			xSemaphoreGiveRecursive(_leaseMutex);
+		}
+
+		uint32_t WiFi::getDriverHeapUsage() const
+		{
+			return _driverHeapUsage;
+		}
+
+		bool WiFi::setRegulatoryDomain(const char *countryCode, uint8_t firstChannel, uint8_t channelCount)
+		{
+			if ( countryCode == nullptr || strlen(countryCode) != 2 || firstChannel < 1 || channelCount < 1 || firstChannel + channelCount - 1 > 14 )
+			{
+				ESP_LOGE(LOG_TAG, "setRegulatoryDomain: invalid regulatory domain");
+				return false;
+			}
+
+			_countryCode[0] = countryCode[0];
+			_countryCode[1] = countryCode[1];
+			_firstChannel = firstChannel;
+			_channelCount = channelCount;
+
+			if ( _channelPlan != 0 && ( _channelPlan & regulatoryChannels() ) == 0 )
+			{
+				ESP_LOGW(LOG_TAG, "setRegulatoryDomain: no planned channel is allowed, scans will cover all channels");
+			}
+
+			if ( _isInitialized )
+			{
+				return applyRegulatoryDomain();
+			}
+
+			return true;
+		}
+
+		bool WiFi::applyRegulatoryDomain()
+		{
+			wifi_country_t countryConfig = {};
+
+			countryConfig.cc[0] = _countryCode[0];
+			countryConfig.cc[1] = _countryCode[1];
+			countryConfig.cc[2] = '\0';
+
+			countryConfig.schan = _firstChannel;
+			countryConfig.nchan = _channelCount;
+			countryConfig.policy = WIFI_COUNTRY_POLICY_MANUAL;
+
+			esp_err_t result = esp_wifi_set_country(&countryConfig);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "applyRegulatoryDomain: esp_wifi_set_country failed: %u", result);
+				return false;
+			}
+
+			return true;
+		}
+
+		bool WiFi::setChannelPlan(std::initializer_list<uint8_t> channels)
+		{
+			uint16_t plan = 0;
+
+			for ( uint8_t channel : channels )
+			{
+				if ( channel >= 1 && channel <= 14 )
+				{
+					plan |= 1 << channel;
+				}
+				else
+				{
+					ESP_LOGW(LOG_TAG, "setChannelPlan: ignoring invalid channel %u", channel);
+				}
+			}
+
+			if ( channels.size() > 0 && ( plan & regulatoryChannels() ) == 0 )
+			{
+				// scanning would silently fall back to all channels
+				ESP_LOGE(LOG_TAG, "setChannelPlan: none of the channels is allowed in the regulatory domain");
+				return false;
+			}
+
+			if ( ( plan & ~regulatoryChannels() ) != 0 )
+			{
+				ESP_LOGW(LOG_TAG, "setChannelPlan: channels outside the regulatory domain are not scanned");
+			}
+
+			_channelPlan = plan;
+
+			return true;
+		}
+
+		uint16_t WiFi::regulatoryChannels() const
+		{
+			return static_cast<uint16_t>( ( ( 1 << _channelCount ) - 1 ) << _firstChannel );
+		}
+
+		bool WiFi::isScanChannel(uint8_t channel) const
+		{
+			uint16_t channels = _channelPlan & regulatoryChannels();
+
+			if ( channels == 0 )
+			{
+				// without a usable plan all allowed channels are scanned
+				channels = regulatoryChannels();
+			}
+
+			return channel >= 1 && channel <= 14 && ( channels & ( 1 << channel ) ) != 0;
+		}
+
+		void WiFi::setScanProfile(ScanProfile profile)
+		{
+			_scanProfile = profile;
+		}
+
+		bool WiFi::setPowerProfile(PowerProfile profile)
+		{
+			int64_t now = esp_timer_get_time();
+
+			if ( _isInitialized )
+			{
+				esp_err_t result = esp_wifi_set_ps(powerProfileSettings(profile).powerSave);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "setPowerProfile: esp_wifi_set_ps failed: %u", result);
+					return false;
+				}
+			}
+
+			_powerProfileTime[static_cast<size_t>(_powerProfile)] += static_cast<uint64_t>(now - _powerProfileSince);
+			_powerProfileSince = now;
+
+			if ( profile != _powerProfile )
+			{
+				ESP_LOGI(LOG_TAG, "power profile %s -> %s", powerProfileSettings(_powerProfile).name, powerProfileSettings(profile).name);
+				_powerProfile = profile;
+			}
+
+			return true;
+		}
+
+		PowerProfile WiFi::getPowerProfile() const
+		{
+			return _powerProfile;
+		}
+
+		uint64_t WiFi::getPowerProfileTime(PowerProfile profile) const
+		{
+			uint64_t time = _powerProfileTime[static_cast<size_t>(profile)];
+
+			if ( profile == _powerProfile )
+			{
+				time += static_cast<uint64_t>(esp_timer_get_time() - _powerProfileSince);
+			}
+
+			return time / 1000;
+		}
+
+		bool WiFi::setReconnectPolicy(const ReconnectPolicy &policy)
+		{
+			if ( policy.enabled && _reconnectTimer == nullptr )
+			{
+				esp_timer_create_args_t timerArgs = {};
+
+				timerArgs.callback = &WiFi::reconnectTimerCallback;
+				timerArgs.arg = static_cast<void*>(this);
+				timerArgs.name = "wifi_reconnect";
+
+				esp_err_t result = esp_timer_create(&timerArgs, &_reconnectTimer);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "setReconnectPolicy: esp_timer_create failed: %u", result);
+					return false;
+				}
+			}
+
+			resetReconnect();
+			_reconnectPolicy = policy;
+
+			return true;
+		}
+
+		bool WiFi::enableRoaming(const RoamingConfig &config)
+		{
+			esp_err_t result;
+
+			if ( _roamingTimer == nullptr )
+			{
+				esp_timer_create_args_t timerArgs = {};
+
+				timerArgs.callback = &WiFi::roamingTimerCallback;
+				timerArgs.arg = static_cast<void*>(this);
+				timerArgs.name = "wifi_roaming";
+
+				result = esp_timer_create(&timerArgs, &_roamingTimer);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "enableRoaming: esp_timer_create failed: %u", result);
+					return false;
+				}
+			}
+			else
+			{
+				esp_timer_stop(_roamingTimer);
+			}
+
+			_roamingConfig = config;
+			_weakRSSISamples = 0;
+			_roamingArmed = true;
+
+			result = esp_timer_start_periodic(_roamingTimer, static_cast<uint64_t>(config.interval) * 1000);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "enableRoaming: esp_timer_start_periodic failed: %u", result);
+				return false;
+			}
+
+			return true;
+		}
+
+		void WiFi::disableRoaming()
+		{
+			if ( _roamingTimer != nullptr )
+			{
+				esp_timer_stop(_roamingTimer);
+			}
+		}
+
+		void WiFi::checkRoaming()
+		{
+			wifi_ap_record_t apInfo;
+
+			if ( ! _stationConnected || _roamingInProgress || _roamingScanPending )
+			{
+				return;
+			}
+
+			if ( esp_wifi_sta_get_ap_info(&apInfo) != ESP_OK )
+			{
+				return;
+			}
+
+			// decide on the smoothed level, so a single outlier neither triggers nor re-arms roaming
+			_rssiSampler.record(apInfo.rssi);
+			int8_t rssi = _rssiSampler.getEWMA();
+
+			if ( rssi >= _roamingConfig.threshold + _roamingConfig.hysteresis )
+			{
+				_roamingArmed = true;
+				_weakRSSISamples = 0;
+				return;
+			}
+
+			if ( rssi >= _roamingConfig.threshold )
+			{
+				_weakRSSISamples = 0;
+				return;
+			}
+
+			if ( ! _roamingArmed || ++_weakRSSISamples < _roamingConfig.samplesBelow )
+			{
+				return;
+			}
+
+			ESP_LOGI(LOG_TAG, "weak link (%d dBm), scanning for a better access point", rssi);
+
+			std::string ssid( reinterpret_cast<const char*>(apInfo.ssid), strnlen( reinterpret_cast<const char*>(apInfo.ssid), sizeof(apInfo.ssid) ) );
+
+			// if another scan is running, try again with the next sample
+			if ( startAsyncScan(ssid, true, true) )
+			{
+				_roamingArmed = false;
+				_weakRSSISamples = 0;
+			}
+		}
+
+		bool WiFi::roamToBestAccessPoint()
+		{
+			wifi_ap_record_t	apInfo;
+			wifi_config_t		wifiConfigSTA;
+			esp_err_t			result;
+
+			if ( ! _stationConnected || esp_wifi_sta_get_ap_info(&apInfo) != ESP_OK )
+			{
+				return false;
+			}
+
+			std::string ssid( reinterpret_cast<const char*>(apInfo.ssid), strnlen( reinterpret_cast<const char*>(apInfo.ssid), sizeof(apInfo.ssid) ) );
+			wifi_ap_record_t bestAP;
+
+			if ( ! _scanCache.findStrongest(ssid, bestAP)
+				|| memcmp(bestAP.bssid, apInfo.bssid, sizeof(apInfo.bssid)) == 0
+				|| bestAP.rssi < apInfo.rssi + _roamingConfig.minImprovement )
+			{
+				ESP_LOGI(LOG_TAG, "roaming: no better access point found");
+				return false;
+			}
+
+			result = esp_wifi_get_config(WIFI_IF_STA, &wifiConfigSTA);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "roaming: esp_wifi_get_config failed: %u", result);
+				return false;
+			}
+
+			wifiConfigSTA.sta.bssid_set		= true;
+			wifiConfigSTA.sta.channel		= bestAP.primary;
+			wifiConfigSTA.sta.scan_method	= WIFI_FAST_SCAN;
+			memcpy(wifiConfigSTA.sta.bssid, bestAP.bssid, sizeof(wifiConfigSTA.sta.bssid));
+
+			result = esp_wifi_set_config(WIFI_IF_STA, &wifiConfigSTA);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "roaming: esp_wifi_set_config failed: %u", result);
+				return false;
+			}
+
+			ESP_LOGI(LOG_TAG, "roaming from %d dBm to %d dBm on channel %u", apInfo.rssi, bestAP.rssi, bestAP.primary);
+
+			// if the new access point can't be joined, fallbackToFullScan() takes over
+			_bssidPinned = true;
+			_fastConnectAttempt = true;
+			_roamingInProgress = true;
+
+			result = esp_wifi_disconnect();
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "roaming: esp_wifi_disconnect failed: %u", result);
+				_roamingInProgress = false;
+				_fastConnectAttempt = false;
+				return false;
+			}
+
+			return true;
+		}
+
+		uint8_t WiFi::getLastDisconnectReason() const
+		{
+			return _lastDisconnectReason;
+		}
+
+		bool WiFi::scheduleReconnect(DisconnectCategory category)
+		{
+			if ( category == DisconnectCategory::AuthFailure )
+			{
+				ESP_LOGW(LOG_TAG, "credentials rejected, not reconnecting");
+				resetReconnect();
+				return false;
+			}
+
+			if ( _reconnectPolicy.maxAttempts != 0 && _reconnectAttempts >= _reconnectPolicy.maxAttempts )
+			{
+				ESP_LOGW(LOG_TAG, "giving up reconnecting after %u attempts", _reconnectAttempts);
+				_reconnectAttempts = 0;
+				return false;
+			}
+
+			uint32_t delay = reconnectDelay(_reconnectPolicy, category, _reconnectAttempts, esp_random());
+
+			// a timer still pending from a previous attempt is superseded by this one
+			esp_timer_stop(_reconnectTimer);
+
+			esp_err_t result = esp_timer_start_once(_reconnectTimer, static_cast<uint64_t>(delay) * 1000);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "scheduleReconnect: esp_timer_start_once failed: %u", result);
+				return false;
+			}
+
+			_reconnectAttempts++;
+			ESP_LOGI(LOG_TAG, "reconnecting in %u ms", delay);
+
+			return true;
+		}
+
+		void WiFi::resetReconnect()
+		{
+			if ( _reconnectTimer != nullptr )
+			{
+				esp_timer_stop(_reconnectTimer);
+			}
+
+			_reconnectAttempts = 0;
+		}
+
+		bool WiFi::fallbackToFullScan()
+		{
+			esp_err_t		result;
+			wifi_config_t	wifiConfigSTA;
+
+			ESP_LOGI(LOG_TAG, "connecting to the pinned access point failed, falling back to a full scan");
+
+			result = esp_wifi_get_config(WIFI_IF_STA, &wifiConfigSTA);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "fallbackToFullScan: esp_wifi_get_config failed: %u", result);
+				_connectionRecord.clear();
+				return false;
+			}
+
+			// the access point may have been pinned by a scan as well, only forget it if it was remembered
+			if ( memcmp(wifiConfigSTA.sta.bssid, _connectionRecord.getBSSID(), sizeof(wifiConfigSTA.sta.bssid)) == 0 )
+			{
+				_connectionRecord.clear();
+			}
+
+			wifiConfigSTA.sta.bssid_set		= false;
+			wifiConfigSTA.sta.channel		= 0;
+			wifiConfigSTA.sta.scan_method	= WIFI_ALL_CHANNEL_SCAN;
+
+			_bssidPinned = false;
+
+			result = esp_wifi_set_config(WIFI_IF_STA, &wifiConfigSTA);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "fallbackToFullScan: esp_wifi_set_config failed: %u", result);
+				return false;
+			}
+
+			result = esp_wifi_connect();
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "fallbackToFullScan: esp_wifi_connect failed: %u", result);
+				return false;
+			}
+
+			return true;
+		}
+
+		bool WiFi::startAP(const char *ssid, const char *password)
 		{
 			esp_err_t		result;
 			wifi_config_t	wifiConfigAP = {};
-			wifi_mode_t		currentMode, newMode;
 
 			if ( _isInitialized )
 			{
@@ -373,234 +1899,537 @@ namespace IDFix
                         return false;
                     }
 
-                    _accessPointInterface = esp_netif_create_default_wifi_ap();
+                    _accessPointInterface = esp_netif_create_default_wifi_ap();
+
+                    if ( _accessPointInterface == nullptr )
+                    {
+                        ESP_LOGE(LOG_TAG, "startAP: esp_netif_create_default_wifi_ap failed");
+                        return false;
+                    }
+                #endif
+
+				memset(&wifiConfigAP, 0, sizeof(wifiConfigAP) );
+
+				wifiConfigAP.ap.channel = ACCESS_POINT_CHANNEL;
+				wifiConfigAP.ap.beacon_interval = 100;
+				wifiConfigAP.ap.max_connection = 1;
+				wifiConfigAP.ap.ssid_len = static_cast<uint8_t>( strlen(ssid) );
+				strncpy( reinterpret_cast<char *>(wifiConfigAP.ap.ssid),		ssid, sizeof(wifiConfigAP.ap.ssid) );
+
+				if ( strlen(password) == 0 )
+				{
+					wifiConfigAP.ap.authmode = WIFI_AUTH_OPEN;
+				}
+				else
+				{
+					wifiConfigAP.ap.authmode = WIFI_AUTH_WPA_WPA2_PSK;
+					strncpy( reinterpret_cast<char *>(wifiConfigAP.ap.password),	password, sizeof(wifiConfigAP.ap.password) );
+				}
+
+				// a running station keeps running next to the access point
+				if ( ! _radio.isUsedBy(RadioModeManager::UserAccessPoint) && ! _radio.acquire(RadioModeManager::UserAccessPoint) )
+				{
+					ESP_LOGE(LOG_TAG, "startAP: enabling the access point failed");
+					return false;
+				}
+
+				result = esp_wifi_set_config(WIFI_IF_AP, &wifiConfigAP);
+				if ( result != ESP_OK )
+				{
+					ESP_LOGE(LOG_TAG, "startAP: esp_wifi_set_config failed: %u", result);
+					return false;
+				}
+
+				if ( _radio.start() == false )
+				{
+					ESP_LOGE(LOG_TAG, "startAP: starting the radio failed");
+					return false;
+				}
+
+			}
+			else
+			{
+				ESP_LOGE(LOG_TAG, "startAP: WiFi is not initialized");
+				return false;
+			}
+
+			return true;
+		}
+
+		bool WiFi::stopAP()
+		{
+			if ( ! _radio.isUsedBy(RadioModeManager::UserAccessPoint) )
+			{
+				return false;
+			}
+
+			// a running station or scan keeps the radio running
+			if ( _radio.release(RadioModeManager::UserAccessPoint) == false )
+			{
+				ESP_LOGE(LOG_TAG, "stopAP: disabling the access point failed");
+			}
+
+            #ifdef CONFIG_IDF_TARGET_ESP32
+                esp_netif_destroy(_accessPointInterface);
+                _accessPointInterface = nullptr;
+            #endif
+
+			return true;
+		}
+
+		int16_t WiFi::scan(const std::string &ssid, bool showHidden)
+		{
+			if ( ! _isInitialized )
+			{
+				ESP_LOGE(LOG_TAG, "scan: WiFi is not initialized");
+				return -1;
+			}
+
+			if ( ! claimScan() )
+			{
+				ESP_LOGE(LOG_TAG, "scan: another scan is already running");
+				return -1;
+			}
+
+			if ( startScan(ssid, showHidden, true) == false )
+			{
+				_scanPending = false;
+				return -1;
+			}
+
+			while ( scanNextChannel(true) )
+			{
+				// each channel of the channel plan is a blocking scan of its own
+			}
+
+			int16_t apCount = finishScan();
+			_scanPending = false;
+
+			return apCount;
+		}
+
+		bool WiFi::scanAsync(const std::string &ssid, bool showHidden)
+		{
+			if ( ! _isInitialized )
+			{
+				ESP_LOGE(LOG_TAG, "scanAsync: WiFi is not initialized");
+				return false;
+			}
+
+			return startAsyncScan(ssid, showHidden, false);
+		}
+
+		bool WiFi::startAsyncScan(const std::string &ssid, bool showHidden, bool roaming)
+		{
+			if ( ! claimScan() )
+			{
+				ESP_LOGE(LOG_TAG, "scanAsync: another scan is already running");
+				return false;
+			}
+
+			// only mark the scan as ours once we own it, or onScanDone() takes the scan of somebody else for a roaming scan
+			_roamingScanPending = roaming;
+			_scanAsync = true;
+
+			if ( startScan(ssid, showHidden, false) == false )
+			{
+				_roamingScanPending = false;
+				_scanAsync = false;
+				_scanPending = false;
+				return false;
+			}
+
+			return true;
+		}
+
+		bool WiFi::claimScan()
+		{
+			bool expected = false;
+
+			return _scanPending.compare_exchange_strong(expected, true);
+		}
+
+		bool WiFi::startScan(const std::string &ssid, bool showHidden, bool block)
+		{
+			if ( prepareForScan() == false )
+			{
+				return false;
+			}
+
+			// the driver may access the SSID until the scan is done, so keep our own copy
+			_scanSSID = ssid;
+			_scanShowHidden = showHidden;
+			_scanPassChannels = _channelPlan & regulatoryChannels();
+
+			if ( _channelPlan != 0 && _scanPassChannels == 0 )
+			{
+				ESP_LOGW(LOG_TAG, "startScan: no planned channel is allowed in the regulatory domain, scanning all channels");
+			}
+			_scanHitChannels = 0;
+			_scanRefining = false;
+			_scanChannel = nextScanChannel(0);
+			_scanFoundCount = 0;
+			_scanFailed = false;
+
+			// with a channel plan, the records of all channels are collected before they are committed,
+			// until then the results of the previous scan stay readable
+			_scanCache.begin(_scanSSID);
 
-                    if ( _accessPointInterface == nullptr )
-                    {
-                        ESP_LOGE(LOG_TAG, "startAP: esp_netif_create_default_wifi_ap failed");
-                        return false;
-                    }
-                #endif
+			if ( startChannelScan(block) == false )
+			{
+				recoverFromScan();
+				return false;
+			}
 
-				memset(&wifiConfigAP, 0, sizeof(wifiConfigAP) );
+			return true;
+		}
 
-				wifiConfigAP.ap.channel = 1;
-				wifiConfigAP.ap.beacon_interval = 100;
-				wifiConfigAP.ap.max_connection = 1;
-				wifiConfigAP.ap.ssid_len = static_cast<uint8_t>( strlen(ssid) );
-				strncpy( reinterpret_cast<char *>(wifiConfigAP.ap.ssid),		ssid, sizeof(wifiConfigAP.ap.ssid) );
+		bool WiFi::startChannelScan(bool block)
+		{
+			esp_err_t			result;
+			wifi_scan_config_t	scanConfig = {};
 
-				if ( strlen(password) == 0 )
-				{
-					wifiConfigAP.ap.authmode = WIFI_AUTH_OPEN;
-				}
-				else
-				{
-					wifiConfigAP.ap.authmode = WIFI_AUTH_WPA_WPA2_PSK;
-					strncpy( reinterpret_cast<char *>(wifiConfigAP.ap.password),	password, sizeof(wifiConfigAP.ap.password) );
-				}
+			if ( _scanSSID.empty() )
+			{
+				scanConfig.ssid = nullptr;
+			}
+			else
+			{
+				scanConfig.ssid = const_cast<uint8_t*>( reinterpret_cast<const uint8_t*>( _scanSSID.c_str() ) ) ;
+				ESP_LOGI(LOG_TAG, "Scanning for ssid: %s", scanConfig.ssid);
+			}
 
-				// check if we're already in ST mode and set mode accordingly
-				result = esp_wifi_get_mode(&currentMode);
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "startAP: esp_wifi_get_mode failed: %u", result);
-					return false;
-				}
+			scanConfig.bssid = nullptr;
+			scanConfig.channel = _scanChannel;
+			scanConfig.show_hidden = _scanShowHidden;
 
-				switch (currentMode)
-				{
-					case WIFI_MODE_STA:
-					case WIFI_MODE_APSTA:
-						newMode = WIFI_MODE_APSTA;
-						break;
-					default:
-						newMode = WIFI_MODE_AP;
-				}
+			const ScanTiming &timing = scanTiming( _scanProfile == ScanProfile::Adaptive && _scanRefining ? ScanProfile::Thorough : _scanProfile );
 
-				ESP_LOGI(LOG_TAG, "current wifi mode: %d", currentMode);
-				ESP_LOGI(LOG_TAG, "setting wifi mode: %d", newMode);
+			if ( timing.passive )
+			{
+				scanConfig.scan_type = WIFI_SCAN_TYPE_PASSIVE;
+				scanConfig.scan_time.passive = timing.maxTime;
+			}
+			else
+			{
+				scanConfig.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+				scanConfig.scan_time.active.min = timing.minTime;
+				scanConfig.scan_time.active.max = timing.maxTime;
+			}
 
-				result = esp_wifi_set_mode(newMode);
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "startAP: esp_wifi_set_mode failed: %u", result);
-					return false;
-				}
+			if ( block )
+			{
+				// counted before the scan starts, the event loop may see SCAN_DONE before we return
+				_blockingScanEvents++;
+			}
 
-				result = esp_wifi_set_config(WIFI_IF_AP, &wifiConfigAP);
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "startAP: esp_wifi_set_config failed: %u", result);
-					return false;
-				}
+			result = esp_wifi_scan_start(&scanConfig, block);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "scan: esp_wifi_scan_start failed: %u", result);
 
-				result = esp_wifi_start();
-				if ( result != ESP_OK )
+				if ( block )
 				{
-					ESP_LOGE(LOG_TAG, "startAP: esp_wifi_start failed: %u", result);
-					return false;
+					_blockingScanEvents--;
 				}
 
-			}
-			else
-			{
-				ESP_LOGE(LOG_TAG, "startAP: WiFi is not initialized");
 				return false;
 			}
 
 			return true;
 		}
 
-		bool WiFi::stopAP()
+		bool WiFi::scanNextChannel(bool block)
 		{
-			wifi_mode_t		currentMode, newMode;
-			esp_err_t		result;
-
-			// check if we're already in ST mode and set mode accordingly
-			result = esp_wifi_get_mode(&currentMode);
-			if ( result != ESP_OK )
+			if ( collectScanResults() == false )
 			{
-				ESP_LOGE(LOG_TAG, "stopAP: esp_wifi_get_mode failed: %u", result);
+				_scanFailed = true;
 				return false;
 			}
 
-			// are we actually in AP / STAP mode?
-			if ( (currentMode == WIFI_MODE_AP) || currentMode == WIFI_MODE_APSTA )
+			if ( _scanChannel != 0 )
 			{
-				if ( currentMode == WIFI_MODE_APSTA )
-				{
-					// if we are in APSTA mode, switch to STA only mode
-					newMode = WIFI_MODE_STA;
-				}
-				else
+				_scanChannel = nextScanChannel(_scanChannel);
+
+				if ( _scanChannel != 0 )
 				{
-					// else we disable wifi completely
-					newMode = 	WIFI_MODE_NULL;
+					// if the next channel can't be scanned, report what we found so far
+					return startChannelScan(block);
 				}
+			}
 
-				result = esp_wifi_set_mode(newMode);
-				if ( result != ESP_OK )
+			if ( _scanProfile == ScanProfile::Adaptive && ! _scanRefining && _scanHitChannels != 0 )
+			{
+				// take a closer look only where access points answered the fast pass
+				_scanRefining = true;
+				_scanPassChannels = _scanHitChannels;
+				_scanChannel = nextScanChannel(0);
+
+				if ( _scanChannel != 0 )
 				{
-					ESP_LOGE(LOG_TAG, "startAP: esp_wifi_set_mode failed: %u", result);
+					return startChannelScan(block);
 				}
+			}
 
-                #ifdef CONFIG_IDF_TARGET_ESP32
-                    esp_netif_destroy(_accessPointInterface);
-                    _accessPointInterface = nullptr;
-                #endif
+			return false;
+		}
+
+		bool WiFi::addScanRecord(const wifi_ap_record_t &record)
+		{
+			if ( record.primary >= 1 && record.primary <= 14 )
+			{
+				_scanHitChannels |= 1 << record.primary;
+			}
+
+			return _scanCache.insert(record);
+		}
+
+		uint8_t WiFi::nextScanChannel(uint8_t channel) const
+		{
+			uint8_t lastChannel = _firstChannel + _channelCount - 1;
+
+			if ( _scanPassChannels == 0 )
+			{
+				return 0;
+			}
 
-				if ( newMode != WIFI_MODE_STA )
+			for ( uint8_t next = std::max<uint8_t>(channel + 1, _firstChannel); next <= lastChannel; next++ )
+			{
+				if ( _scanPassChannels & ( 1 << next ) )
 				{
-					// if we're not in station mode now, shutdown wifi
-					result = esp_wifi_stop();
-					if ( result != ESP_OK )
-					{
-						ESP_LOGE(LOG_TAG, "stopAP: esp_wifi_stop failed: %u", result);
-					}
+					return next;
 				}
-
-				return true;
 			}
 
-			return false;
+			return 0;
 		}
 
-		int16_t WiFi::scan(const std::string &ssid, bool showHidden)
+		bool WiFi::collectScanResults()
 		{
-			wifi_mode_t		currentMode;
 			esp_err_t		result;
-			int16_t			returnValue = -1;
 			uint16_t		apCount = 0;
+			uint16_t		newRecords = 0;
 
-			if ( _isInitialized )
+			result = esp_wifi_scan_get_ap_num(&apCount);
+			if ( result != ESP_OK )
 			{
-				result = esp_wifi_get_mode(&currentMode);
-				if ( result != ESP_OK )
+				ESP_LOGE(LOG_TAG, "scan: esp_wifi_scan_get_ap_num failed: %u", result);
+				return false;
+			}
+
+			#if IDFIX_WIFI_SINGLE_AP_RECORD_API
+
+				// fetch all records in chunks, so the cache keeps the strongest ones whatever the number of APs around
+				uint16_t remaining = apCount;
+
+				while ( remaining > 0 && result == ESP_OK )
 				{
-					ESP_LOGE(LOG_TAG, "scan: esp_wifi_get_mode failed: %u", result);
-					return -1;
+					uint16_t chunkCount = 0;
+
+					while ( chunkCount < SCAN_CHUNK_SIZE && remaining > 0 )
+					{
+						result = esp_wifi_scan_get_ap_record(&scanChunk[chunkCount]);
+						if ( result != ESP_OK )
+						{
+							break;
+						}
+
+						chunkCount++;
+						remaining--;
+					}
+
+					for ( uint16_t index = 0; index < chunkCount; index++ )
+					{
+						if ( addScanRecord(scanChunk[index]) )
+						{
+							newRecords++;
+						}
+					}
 				}
 
-				if ( prepareForScan(currentMode) == false )
+				// release the records we did not fetch
+				esp_wifi_clear_ap_list();
+
+			#else
+
+				// the driver hands out the records only once and frees the rest, so the first chunk in the
+				// driver's order is all we get, not necessarily the strongest access points
+				uint16_t chunkCount = SCAN_CHUNK_SIZE;
+
+				result = esp_wifi_scan_get_ap_records(&chunkCount, scanChunk);
+				if ( result == ESP_OK )
 				{
-					return -1;
+					for ( uint16_t index = 0; index < chunkCount; index++ )
+					{
+						if ( addScanRecord(scanChunk[index]) )
+						{
+							newRecords++;
+						}
+					}
+
+					if ( apCount > chunkCount )
+					{
+						// the driver dropped the records which did not fit, they may include the SSID somebody looks for
+						_scanCache.markTruncated();
+					}
 				}
 
-				wifi_scan_config_t scanConfig;
+			#endif
+
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "scan: fetching the AP records failed: %u", result);
 
-				if ( ssid.empty() )
+				if ( result == ESP_ERR_WIFI_NOT_INIT )
+				{
+					ESP_LOGE(LOG_TAG, "ESP_ERR_WIFI_NOT_INIT");
+				}
+				else if ( result == ESP_ERR_WIFI_NOT_STARTED )
+				{
+					ESP_LOGE(LOG_TAG, "ESP_ERR_WIFI_NOT_STARTED");
+				}
+				else if ( result == ESP_ERR_INVALID_ARG )
 				{
-					scanConfig.ssid = nullptr;
+					ESP_LOGE(LOG_TAG, "ESP_ERR_INVALID_ARG");
+				}
+				else if ( result == ESP_ERR_NO_MEM )
+				{
+					ESP_LOGE(LOG_TAG, "ESP_ERR_NO_MEM");
 				}
 				else
 				{
-					scanConfig.ssid = const_cast<uint8_t*>( reinterpret_cast<const uint8_t*>( ssid.c_str() ) ) ;
-					ESP_LOGI(LOG_TAG, "Scanning for ssid: %s", scanConfig.ssid);
+					ESP_LOGE(LOG_TAG, "Unknown esp_wifi_scan_get_ap_records result!");
 				}
 
-				scanConfig.bssid = nullptr;
-				scanConfig.channel = 0;
-				scanConfig.show_hidden = showHidden;
-				scanConfig.scan_type = WIFI_SCAN_TYPE_ACTIVE;
-				scanConfig.scan_time.active.min = 100;
-				scanConfig.scan_time.active.max = 300;
+				return false;
+			}
 
-				result = esp_wifi_scan_start(&scanConfig, true);
-				if ( result != ESP_OK )
+			// a refining pass visits channels again, so only count access points we did not see before
+			_scanFoundCount += _scanRefining ? newRecords : apCount;
+
+			return true;
+		}
+
+		int16_t WiFi::finishScan()
+		{
+			if ( _scanFailed )
+			{
+				_scanCache.invalidate();
+				recoverFromScan();
+				return -1;
+			}
+
+			_scanCache.commit();
+
+			recoverFromScan();
+
+			return static_cast<int16_t>(_scanFoundCount);
+		}
+
+		ProbeResult WiFi::probeSSID(const std::string &ssid, uint32_t maxTime)
+		{
+			if ( ! _isInitialized )
+			{
+				ESP_LOGE(LOG_TAG, "probeSSID: WiFi is not initialized");
+				return ProbeResult::Error;
+			}
+
+			if ( ! claimScan() )
+			{
+				ESP_LOGE(LOG_TAG, "probeSSID: a scan is running");
+				return ProbeResult::Error;
+			}
+
+			if ( prepareForScan() == false )
+			{
+				_scanPending = false;
+				return ProbeResult::Error;
+			}
+
+			int64_t		deadline = esp_timer_get_time() + static_cast<int64_t>(maxTime) * 1000;
+			uint8_t		lastChannel = _firstChannel + _channelCount - 1;
+			ProbeResult	result = ProbeResult::NotFound;
+
+			// a standalone configuration AP uses its default channel, unless we must not send there
+			if ( isScanChannel(ACCESS_POINT_CHANNEL) )
+			{
+				result = probeChannel(ssid, ACCESS_POINT_CHANNEL);
+			}
+
+			// a configuration AP running next to a station shares the channel of the station, so check the planned channels next
+			for ( uint8_t channel = _firstChannel; channel <= lastChannel && result == ProbeResult::NotFound; channel++ )
+			{
+				if ( channel == ACCESS_POINT_CHANNEL || ! isScanChannel(channel) )
 				{
-					ESP_LOGE(LOG_TAG, "scan: esp_wifi_scan_start failed: %u", result);
-					recoverFromScan(currentMode);
-					return -1;
+					continue;
 				}
 
-				ESP_ERROR_CHECK(esp_wifi_scan_get_ap_num(&apCount));
-				returnValue = static_cast<int16_t>(apCount);
+				if ( esp_timer_get_time() + static_cast<int64_t>(PROBE_MAX_TIME) * 1000 > deadline )
+				{
+					ESP_LOGW(LOG_TAG, "probeSSID: time is up, channels from %u on were not probed", channel);
+					break;
+				}
 
-				wifi_ap_record_t	*apList = new wifi_ap_record_t[apCount];
-				uint16_t			getAPCount = apCount;
+				result = probeChannel(ssid, channel);
+			}
 
-				result = esp_wifi_scan_get_ap_records(&getAPCount, apList);
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "scan: esp_wifi_scan_get_ap_records failed: %u", result);
+			recoverFromScan();
+			_scanPending = false;
 
-					if ( result == ESP_ERR_WIFI_NOT_INIT )
-					{
-						ESP_LOGE(LOG_TAG, "ESP_ERR_WIFI_NOT_INIT");
-					}
-					else if ( result == ESP_ERR_WIFI_NOT_STARTED )
-					{
-						ESP_LOGE(LOG_TAG, "ESP_ERR_WIFI_NOT_STARTED");
-					}
-					else if ( result == ESP_ERR_INVALID_ARG )
-					{
-						ESP_LOGE(LOG_TAG, "ESP_ERR_INVALID_ARG");
-					}
-					else if ( result == ESP_ERR_NO_MEM )
-					{
-						ESP_LOGE(LOG_TAG, "ESP_ERR_NO_MEM");
-					}
-					else
-					{
-						ESP_LOGE(LOG_TAG, "Unknown esp_wifi_scan_get_ap_records result!");
-					}
+			return result;
+		}
 
-					returnValue = -1;
-				}
+		ProbeResult WiFi::probeChannel(const std::string &ssid, uint8_t channel)
+		{
+			esp_err_t			result;
+			wifi_scan_config_t	scanConfig = {};
+			uint16_t			apCount = 0;
 
-				delete[] apList;
+			scanConfig.ssid = const_cast<uint8_t*>( reinterpret_cast<const uint8_t*>( ssid.c_str() ) );
+			scanConfig.bssid = nullptr;
+			scanConfig.channel = channel;
+			scanConfig.show_hidden = true;
+			scanConfig.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+			scanConfig.scan_time.active.min = PROBE_MIN_TIME;
+			scanConfig.scan_time.active.max = PROBE_MAX_TIME;
 
-				recoverFromScan(currentMode);
+			_blockingScanEvents++;
 
+			result = esp_wifi_scan_start(&scanConfig, true);
+			if ( result != ESP_OK )
+			{
+				ESP_LOGE(LOG_TAG, "probeChannel: esp_wifi_scan_start failed: %u", result);
+				_blockingScanEvents--;
+				return ProbeResult::Error;
 			}
-			else
+
+			result = esp_wifi_scan_get_ap_num(&apCount);
+
+			// release the records, we only need to know if there were any
+			#if IDFIX_WIFI_SINGLE_AP_RECORD_API
+				esp_wifi_clear_ap_list();
+			#else
+				uint16_t chunkCount = SCAN_CHUNK_SIZE;
+				esp_wifi_scan_get_ap_records(&chunkCount, scanChunk);
+			#endif
+
+			if ( result != ESP_OK )
 			{
-				ESP_LOGE(LOG_TAG, "scan: WiFi is not initialized");
-				return -1;
+				ESP_LOGE(LOG_TAG, "probeChannel: esp_wifi_scan_get_ap_num failed: %u", result);
+				return ProbeResult::Error;
 			}
 
-			return returnValue;
+			return apCount > 0 ? ProbeResult::Found : ProbeResult::NotFound;
+		}
+
+		const WiFiScanCache &WiFi::getScanResults() const
+		{
+			return _scanCache;
+		}
+
+		void WiFi::setScanCacheTimeToLive(uint32_t timeToLive)
+		{
+			_scanCache.setTimeToLive(timeToLive);
 		}
 
         std::string WiFi::getStationMACAddress()
@@ -637,74 +2466,69 @@ namespace IDFix
         int8_t WiFi::getRSSILevel() const
         {
             wifi_ap_record_t info;
-            esp_wifi_sta_get_ap_info(&info);
+
+            if ( esp_wifi_sta_get_ap_info(&info) != ESP_OK )
+            {
+                return INVALID_RSSI;
+            }
+
             return info.rssi;
         }
 
-		bool WiFi::prepareForScan(wifi_mode_t currentMode)
-		{
-			esp_err_t	result;
+        int8_t WiFi::sampleRSSI()
+        {
+            int8_t rssi = getRSSILevel();
 
-			if ( currentMode ==  WIFI_MODE_NULL )
-			{
-				result = esp_wifi_set_mode(WIFI_MODE_STA);
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "prepareScan: esp_wifi_set_mode failed: %u", result);
-					return false;
-				}
+            if ( rssi != INVALID_RSSI )
+            {
+                _rssiSampler.record(rssi);
+            }
 
-				// if we're comming from WIFI_MODE_NULL, wifi was not yet started
-				result = esp_wifi_start();
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "prepareScan: esp_wifi_start failed: %u", result);
-				}
+            return rssi;
+        }
+
+        RSSIStatistics WiFi::getRSSIStatistics() const
+        {
+            return _rssiSampler.getStatistics();
+        }
+
+        const WiFiEventTrace &WiFi::getEventTrace() const
+        {
+            return _eventTrace;
+        }
+
+        const WiFiConnectionTimeline &WiFi::getConnectionTimeline() const
+        {
+            return _connectionTimeline;
+        }
+
+        const RadioModeManager &WiFi::getRadioModeManager() const
+        {
+            return _radio;
+        }
+
+		bool WiFi::prepareForScan()
+		{
+			if ( _radio.acquire(RadioModeManager::UserScan) == false )
+			{
+				ESP_LOGE(LOG_TAG, "prepareScan: enabling the station for scanning failed");
+				return false;
 			}
-			else if ( currentMode == WIFI_MODE_AP )
+
+			if ( _radio.start() == false )
 			{
-				result = esp_wifi_set_mode(WIFI_MODE_APSTA);
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "prepareScan: esp_wifi_set_mode failed: %u", result);
-					return false;
-				}
+				ESP_LOGE(LOG_TAG, "prepareScan: starting the radio failed");
+				_radio.release(RadioModeManager::UserScan);
+				return false;
 			}
 
 			return true;
 		}
 
-		bool WiFi::recoverFromScan(wifi_mode_t targetMode)
+		bool WiFi::recoverFromScan()
 		{
-			esp_err_t	result;
-			bool		returnValue = true;
-
-			// we only changed state in prepareForScan if mode previously was WIFI_MODE_NULL or WIFI_MODE_AP
-			// so we have to recover only in one of this modes
-			if ( (targetMode == WIFI_MODE_NULL) || (targetMode == WIFI_MODE_AP) )
-			{
-
-				// reset the state prior the scan
-				result = esp_wifi_set_mode(targetMode);
-				if ( result != ESP_OK )
-				{
-					ESP_LOGE(LOG_TAG, "scan: esp_wifi_set_mode failed: %u", result);
-					returnValue = false;
-				}
-
-				if ( targetMode == WIFI_MODE_NULL )
-				{
-					// if we came from WIFI_MODE_NULL, also disable the wifi finally
-					result = esp_wifi_stop();
-					if ( result != ESP_OK )
-					{
-						ESP_LOGE(LOG_TAG, "scan: esp_wifi_stop failed: %u", result);
-						returnValue = false;
-					}
-				}
-			}
-
-			return returnValue;
+			// only switches the mode back if nobody else needs the station interface
+			return _radio.release(RadioModeManager::UserScan);
 		}
 
 	}
@@ -22,17 +22,36 @@ extern "C"
 {
     #include <esp_event.h>
     #include <esp_netif.h>
+    #include <esp_timer.h>
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/semphr.h>
     #include <arpa/inet.h>
     #include <lwip/sockets.h>
 }
 
+#include "WiFiUtils.h"
+#include "WiFiScanCache.h"
+#include "WiFiConnectionRecord.h"
+#include "WiFiLeaseRecord.h"
+#include "RSSISampler.h"
+#include "WiFiEventTrace.h"
+#include "WiFiConnectionTimeline.h"
+#include "RadioModeManager.h"
+#include "WiFiEventHandlerRegistry.h"
+
 #include <string>
+#include <vector>
+#include <atomic>
+#include <array>
+#include <initializer_list>
 
 namespace IDFix
 {
 	namespace WiFi
 	{
 		class WiFiEventHandler;
+		class WiFiEventDispatcher;
+		struct HandlerNotification;
 
         struct IPInfo
         {
@@ -54,6 +73,135 @@ namespace IDFix
             }
         };
 
+        /**
+         * @brief The ReconnectPolicy struct configures the automatic reconnect of the station
+         *
+         * After the n-th consecutive failure the reconnect is delayed by
+         * min(maxDelay, initialDelay * backoffFactor^n). A share of jitter percent of this
+         * delay is randomized, so devices losing the same access point spread their attempts.
+         *
+         * The reaction depends on the DisconnectCategory of the disconnect: an established link
+         * which got lost is retried after linkLostDelay, rejected credentials are never retried
+         * and a disconnect requested by the station itself is not retried.
+         */
+        struct ReconnectPolicy
+        {
+            bool        enabled = { false };
+            uint32_t    initialDelay = { 500 };     ///< delay before the first attempt in milliseconds
+            uint32_t    linkLostDelay = { 100 };    ///< delay before the first attempt after a lost link in milliseconds
+            uint32_t    maxDelay = { 60000 };       ///< upper bound of the delay in milliseconds
+            uint8_t     backoffFactor = { 2 };      ///< the delay is multiplied by this factor after each failure
+            uint8_t     jitter = { 50 };            ///< randomized share of the delay in percent
+            uint16_t    maxAttempts = { 0 };        ///< give up after this many attempts, 0 retries forever
+        };
+
+        /**
+         * @brief Calculate the jittered backoff delay of a reconnect attempt
+         *
+         * @param policy    the reconnect policy
+         * @param category  the category of the disconnect which triggered the reconnect
+         * @param attempts  the number of attempts made since the last successful connect
+         * @param random    a uniformly distributed random number, e.g. from esp_random()
+         *
+         * @return the delay in milliseconds
+         */
+        uint32_t reconnectDelay(const ReconnectPolicy &policy, DisconnectCategory category, uint16_t attempts, uint32_t random);
+
+        /**
+         * @brief The RoamingConfig struct configures the background roaming monitor
+         *
+         * A roaming scan for the current SSID is started once the RSSI stayed below threshold for
+         * samplesBelow consecutive samples. The monitor re-arms only after the RSSI recovered to
+         * threshold + hysteresis, so a link hovering around the threshold does not trigger scans
+         * over and over again.
+         */
+        struct RoamingConfig
+        {
+            uint32_t    interval = { 5000 };        ///< time between two RSSI samples in milliseconds
+            int8_t      threshold = { -75 };        ///< RSSI in dBm below which the link is considered weak
+            uint8_t     hysteresis = { 5 };         ///< dB above the threshold needed to re-arm the monitor
+            uint8_t     samplesBelow = { 3 };       ///< consecutive weak samples needed to start a roaming scan
+            uint8_t     minImprovement = { 8 };     ///< dB a new access point must be stronger than the current one
+        };
+
+        /**
+         * @brief The NetworkProfile struct holds the credentials of a known network
+         */
+        struct NetworkProfile
+        {
+            std::string ssid;
+            std::string password;
+            int8_t      priority = 0;   ///< each priority step outweighs 10 dB of signal strength, negative values demote the network
+        };
+
+        /**
+         * @brief The DriverTuning struct adjusts the buffers and the AMPDU support of the WIFI driver
+         *
+         * Buffer counts of 0 and AMPDU settings of -1 keep the defaults from the IDF configuration.
+         * The values are only applied on the ESP32, the ESP8266 driver always uses its defaults.
+         */
+        struct DriverTuning
+        {
+            uint16_t    staticRxBuffers = { 0 };    ///< preallocated RX buffers, 2 to 25
+            uint16_t    dynamicRxBuffers = { 0 };   ///< RX buffers allocated on demand
+            uint16_t    dynamicTxBuffers = { 0 };   ///< TX buffers allocated on demand
+            int8_t      ampduRx = { -1 };           ///< 1 enables, 0 disables receiving AMPDUs
+            int8_t      ampduTx = { -1 };           ///< 1 enables, 0 disables sending AMPDUs
+            uint8_t     rxBAWindow = { 0 };         ///< block ack window for AMPDU RX, at most staticRxBuffers
+
+            /**
+             * @brief More buffers and large AMPDU windows for bulk transfers
+             */
+            static DriverTuning throughput(void);
+
+            /**
+             * @brief As few buffers as possible and no AMPDU, for nodes sending little data
+             */
+            static DriverTuning minRAM(void);
+        };
+
+        /**
+         * @brief The PowerProfile enum selects how aggressively the station saves power
+         *
+         * - LowLatency:    modem sleep disabled, every beacon is received
+         * - Balanced:      modem sleep, the station wakes up for every DTIM beacon (the IDF default)
+         * - MaxBattery:    modem sleep, the station wakes up only every 10th beacon interval
+         */
+        enum class PowerProfile : uint8_t
+        {
+            LowLatency,
+            Balanced,
+            MaxBattery
+        };
+
+        /**
+         * @brief The ScanProfile enum trades scan duration against the chance to see every access point
+         *
+         * - Default:       active scan, 100 to 300 ms per channel
+         * - FastActive:    active scan, 20 to 60 ms per channel, may miss slowly responding access points
+         * - Thorough:      active scan, 200 to 600 ms per channel
+         * - Passive:       listen for beacons for 360 ms per channel without sending probe requests
+         * - Adaptive:      a FastActive pass, followed by a Thorough pass only on channels where access points answered
+         */
+        enum class ScanProfile : uint8_t
+        {
+            Default,
+            FastActive,
+            Thorough,
+            Passive,
+            Adaptive
+        };
+
+        /**
+         * @brief The ProbeResult enum is the outcome of WiFi::probeSSID()
+         */
+        enum class ProbeResult : uint8_t
+        {
+            Found,
+            NotFound,
+            Error
+        };
+
         /**
          * @brief The WiFi class allows to control the WIFI adapter of the device
          */
@@ -69,6 +217,24 @@ namespace IDFix
                  */
 				bool				init(void);
 
+                /**
+                 * @brief   Initialize the WIFI adapter with tuned driver buffers
+                 *
+                 * @param tuning    the buffer and AMPDU settings for the driver
+                 *
+                 * @return  \c false if adapter could not be initialized
+                 */
+				bool				init(const DriverTuning &tuning);
+
+                /**
+                 * @brief Get the heap the WIFI driver allocated during init()
+                 *
+                 * Dynamic buffers are allocated later on demand and are not included.
+                 *
+                 * @return  the heap usage in bytes or 0 before init()
+                 */
+				uint32_t			getDriverHeapUsage(void) const;
+
                 /**
                  * @brief Connect to a WPA protected WIFI
                  *
@@ -80,6 +246,182 @@ namespace IDFix
 				bool				connectWPA(const char *ssid, const char *password);
 				bool				connectWPA(const std::string &ssid, const std::string &password);
 
+                /**
+                 * @brief Connect to the strongest access point of a WPA protected WIFI
+                 *
+                 * Uses fresh scan results if available or scans for the SSID, then joins the strongest
+                 * access point directly by its BSSID and channel without letting the driver search again.
+                 * If that access point can't be joined, the driver falls back to a scan over all channels.
+                 *
+                 * @param ssid      the SSID of the WIFI
+                 * @param password  the password for the WIFI
+                 *
+                 * @return  \c false if the network is not visible or the WIFI station mode coud not be started
+                 */
+				bool				scanAndConnect(const std::string &ssid, const std::string &password);
+
+                /**
+                 * @brief Add a known network which is considered by connectBestNetwork()
+                 *
+                 * A profile with the same SSID is replaced.
+                 *
+                 * @param ssid      the SSID of the WIFI
+                 * @param password  the password for the WIFI
+                 * @param priority  the priority of the network, higher values are preferred
+                 */
+				void				addNetworkProfile(const std::string &ssid, const std::string &password, int8_t priority = 0);
+
+                /**
+                 * @brief Remove a known network
+                 *
+                 * @param ssid      the SSID of the WIFI
+                 *
+                 * @return  \c false if no profile for the SSID exists
+                 */
+				bool				removeNetworkProfile(const std::string &ssid);
+
+                /**
+                 * @brief Remove all known networks
+                 */
+				void				clearNetworkProfiles(void);
+
+                /**
+                 * @brief Connect to the best visible known network
+                 *
+                 * All known networks are ranked by one scan pass, or fresh scan results if available.
+                 * The score of a network is the RSSI of its strongest access point plus 10 dB per
+                 * priority step. The winning access point is joined directly, like scanAndConnect() does.
+                 *
+                 * @return  \c false if no known network is visible or the connection could not be started
+                 */
+				bool				connectBestNetwork(void);
+
+                /**
+                 * @brief Enable reconnecting directly to the access point of the last successful connection
+                 *
+                 * If enabled, the BSSID and channel of each successful connection are persisted in the NVS.
+                 * The next connectWPA() to the same SSID tries this access point on its channel first and
+                 * only falls back to a scan over all channels if that attempt fails.
+                 *
+                 * @param enabled   \c true to enable fast reconnects
+                 */
+				void				setFastReconnect(bool enabled);
+
+                /**
+                 * @brief Enable reusing the last DHCP lease when reconnecting to the same access point
+                 *
+                 * If enabled, the address, network mask and gateway of each DHCP lease are persisted in the NVS
+                 * together with the BSSID of the access point. When the station connects to that access point again,
+                 * an ARP probe checks that no other host took the address meanwhile, then the lease is applied and the
+                 * network is reported as connected without waiting for DHCP. After renewDelay the DHCP client confirms
+                 * the lease in the background while the cached address stays in use. If the server hands out another
+                 * address, networkConnected() is called again with the new address.
+                 *
+                 * A cached lease is dropped if the probe is answered, the connection fails before the lease was
+                 * confirmed or the IP is lost.
+                 *
+                 * @param enabled       \c true to enable lease caching
+                 * @param renewDelay    delay in milliseconds until the cached lease is confirmed by DHCP
+                 *
+                 * @return  \c false if the lease timer or its mutex could not be created
+                 */
+				bool				setDHCPLeaseCaching(bool enabled, uint32_t renewDelay = 5000);
+
+                /**
+                 * @brief Switch the power save profile of the station
+                 *
+                 * The modem sleep mode changes right away, the listen interval is negotiated with the
+                 * access point and therefore takes effect with the next connect. Can be called before init(),
+                 * the profile is applied then.
+                 *
+                 * @param profile   the profile to use
+                 *
+                 * @return  \c false if the modem sleep mode could not be set
+                 */
+				bool				setPowerProfile(PowerProfile profile);
+
+				PowerProfile		getPowerProfile(void) const;
+
+                /**
+                 * @brief Get the time spent in a power save profile since boot
+                 *
+                 * @param profile   the profile
+                 *
+                 * @return  the time in milliseconds, including the running period if the profile is active
+                 */
+				uint64_t			getPowerProfileTime(PowerProfile profile) const;
+
+                /**
+                 * @brief Configure the automatic reconnect after the station lost or failed its connection
+                 *
+                 * If the policy gives up, WiFiEventHandler::reconnectFailed() is triggered.
+                 * Authentication failures give up immediately.
+                 *
+                 * @param policy    the reconnect policy to apply
+                 *
+                 * @return  \c false if the reconnect timer could not be created
+                 */
+				bool				setReconnectPolicy(const ReconnectPolicy &policy);
+
+                /**
+                 * @brief Add another handler to be notified about WiFi events
+                 *
+                 * The handler passed to the constructor is registered with priority 0.
+                 *
+                 * @param handler   the handler to add
+                 * @param priority  the priority of the handler, higher priorities are notified first
+                 *
+                 * @return  \c false if too many handlers are registered or the handler is already registered
+                 */
+				bool				addEventHandler(WiFiEventHandler *handler, int8_t priority = 0);
+
+                /**
+                 * @brief Stop notifying a handler about WiFi events
+                 *
+                 * @param handler   the handler to remove
+                 *
+                 * @return  \c false if the handler is not registered
+                 */
+				bool				removeEventHandler(WiFiEventHandler *handler);
+
+                /**
+                 * @brief Run the WiFiEventHandler callbacks on a dedicated task instead of the default event loop
+                 *
+                 * Events are queued in constant time and the event loop is never blocked by a slow
+                 * handler. If the queue overflows, notifications are dropped.
+                 *
+                 * @param stackSize     the stack size of the dispatcher task in bytes
+                 * @param priority      the priority of the dispatcher task
+                 *
+                 * @return  \c false if the dispatcher task could not be started, the handlers keep running on the event loop then
+                 */
+				bool				enableEventDispatcher(uint32_t stackSize = 4096, UBaseType_t priority = 5);
+
+                /**
+                 * @brief Start the background roaming monitor
+                 *
+                 * While the station is connected, the RSSI is sampled periodically. If the link stays
+                 * weak, the monitor scans for the current SSID in the background and moves to a
+                 * clearly stronger access point.
+                 *
+                 * @param config    the roaming configuration
+                 *
+                 * @return  \c false if the monitor could not be started
+                 */
+				bool				enableRoaming(const RoamingConfig &config = RoamingConfig());
+
+                /**
+                 * @brief Stop the background roaming monitor
+                 */
+				void				disableRoaming(void);
+
+                /**
+                 * @brief Get the driver's reason code of the last station disconnect
+                 *
+                 * @return the wifi_err_reason_t of the last disconnect or 0 if there was none
+                 */
+				uint8_t				getLastDisconnectReason(void) const;
+
                 /**
                  * @brief Create an unprotected access point
                  *
@@ -107,6 +449,93 @@ namespace IDFix
                  */
 				int16_t				scan(const std::string &ssid = "", bool showHidden = true);
 
+                /**
+                 * @brief Start a scan for all available or a specified SSID without blocking the caller
+                 *
+                 * The result is reported to the WiFiEventHandler by WiFiEventHandler::scanFinished()
+                 * as soon as the driver signals WIFI_EVENT_SCAN_DONE.
+                 *
+                 * @param ssid          only scan for the specified SSID
+                 * @param showHidden    also include hidden networks
+                 *
+                 * @return              \c false if the scan could not be started or another scan is running
+                 */
+				bool				scanAsync(const std::string &ssid = "", bool showHidden = true);
+
+                /**
+                 * @brief Set the country and the channel range the adapter may use
+                 *
+                 * Defaults to country "DE" with channels 1 to 13. Can be called before init(), the
+                 * regulatory domain is applied then.
+                 *
+                 * @param countryCode   the two letter ISO country code
+                 * @param firstChannel  the first allowed channel
+                 * @param channelCount  the number of allowed channels
+                 *
+                 * @return  \c false if the parameters are invalid or the driver refused them
+                 */
+				bool				setRegulatoryDomain(const char *countryCode, uint8_t firstChannel = 1, uint8_t channelCount = 13);
+
+                /**
+                 * @brief Restrict scans to the channels which are actually used
+                 *
+                 * With a channel plan, scan() and scanAsync() scan the listed channels one after another
+                 * instead of all channels of the regulatory domain. connectWPA() looks for the network on
+                 * the planned channels first, which blocks the call for the duration of the scan, and only
+                 * lets the driver search all channels if it was not found. probeSSID() probes the planned
+                 * channels only.
+                 *
+                 * Planned channels outside the regulatory domain are skipped. If the regulatory domain is
+                 * changed later so that no planned channel is left, scans cover all channels again.
+                 *
+                 * @param channels  the channels to scan, e.g. {1, 6, 11}, an empty list scans all channels again
+                 *
+                 * @return  \c false if none of the channels lies in the regulatory domain, the plan is not changed then
+                 */
+				bool				setChannelPlan(std::initializer_list<uint8_t> channels);
+
+                /**
+                 * @brief Select the dwell times and the scan type used by scan() and scanAsync()
+                 *
+                 * @param profile   the scan profile
+                 */
+				void				setScanProfile(ScanProfile profile);
+
+                /**
+                 * @brief Check quickly if any access point advertises an SSID
+                 *
+                 * Sends directed probe requests with a short dwell time, starting on the channel startAP()
+                 * uses and stopping at the first answer. Only channels of the regulatory domain and the channel
+                 * plan are probed, also the one of startAP(). The remaining channels are only probed as long as
+                 * maxTime allows, so NotFound is a best effort answer. The scan results are not touched.
+                 *
+                 * @param ssid      the SSID to look for
+                 * @param maxTime   the time budget in milliseconds
+                 *
+                 * @return  Found on the first answer, NotFound if the time was up or all channels were probed
+                 */
+				ProbeResult			probeSSID(const std::string &ssid, uint32_t maxTime = 400);
+
+                /**
+                 * @brief Get the access point records of the last finished scan
+                 *
+                 * The records are replaced as soon as the next scan finishes, a running scan collects its records
+                 * aside. The replacement may happen on another task, so hold WiFiScanCache::lock() when combining
+                 * several calls like size() and getSSID(). Before IDF 5.1 the driver
+                 * hands out the records only in one piece, so a scan which saw more than WiFiScanCache::CAPACITY
+                 * access points keeps the first ones in the driver's order, not necessarily the strongest.
+                 *
+                 * @return the scan result cache
+                 */
+				const WiFiScanCache& getScanResults(void) const;
+
+                /**
+                 * @brief Set the time the last scan results are reused instead of scanning again
+                 *
+                 * @param timeToLive    the time to live in milliseconds, 0 disables reusing scan results
+                 */
+				void				setScanCacheTimeToLive(uint32_t timeToLive);
+
                 /**
                  * @brief Get the MAC address of the device
                  *
@@ -124,41 +553,379 @@ namespace IDFix
                 /**
                  * @brief Get the current RSSI level of the connected WIFI
                  *
-                 * @return the current RSSI level
+                 * @return the current RSSI level or INVALID_RSSI if the station is not connected
                  */
                 int8_t              getRSSILevel() const;
 
+                /**
+                 * @brief Get the current RSSI level and record it for the RSSI statistics
+                 *
+                 * The roaming monitor samples the RSSI on its own, otherwise call this periodically
+                 * to feed getRSSIStatistics().
+                 *
+                 * @return the current RSSI level or INVALID_RSSI if the station is not connected
+                 */
+                int8_t              sampleRSSI();
+
+                /**
+                 * @brief Get the statistics of the recently sampled RSSI levels
+                 *
+                 * The samples are dropped whenever the station connects to an access point.
+                 *
+                 * @return the RSSI statistics, count is 0 if no samples were recorded yet
+                 */
+                RSSIStatistics      getRSSIStatistics() const;
+
+                static constexpr int8_t INVALID_RSSI = -128;
+
+                /**
+                 * @brief Get the binary trace of the recent WIFI and IP events
+                 *
+                 * @return the event trace
+                 */
+                const WiFiEventTrace& getEventTrace() const;
+
+                /**
+                 * @brief Get the durations of the phases of past station connects
+                 */
+                const WiFiConnectionTimeline& getConnectionTimeline() const;
+
+                /**
+                 * @brief Get the radio mode manager, e.g. to check how many driver calls mode changes took
+                 */
+                const RadioModeManager& getRadioModeManager() const;
+
             private:
 
+                enum class EventBaseIndex
+                {
+                    WiFi,
+                    IP
+                };
+
+                /**
+                 * @brief The steps of reusing a cached lease, guarded by _leaseMutex
+                 */
+                enum class LeaseState : uint8_t
+                {
+                    Unused,		///< the DHCP client of the adapter manages the address
+                    Probing,	///< an ARP probe for the cached address was sent
+                    Applied,	///< the cached address is set statically
+                    Renewing,	///< the lwIP DHCP client confirms the lease, the cached address stays set
+                    Bound		///< the lwIP DHCP client holds the lease
+                };
+
+                typedef void		(WiFi::*EventMethod)(void* eventData);
+
                 void				wifiEventHandler(		void* instance, esp_event_base_t eventBase, int32_t eventID, void* eventData);
+                static EventMethod	lookupEventMethod(EventBaseIndex eventBase, int32_t eventID);
+
+                void				dispatch(const HandlerNotification &notification);
+                void				notifyNetworkConnected(const IPInfo &ipInfo);
+                void				notifyNetworkDisconnected(void);
+                void				notifyAccessPointStarted(ip4_addr_t accessPointIPAddress);
+                void				notifyAccessPointStopped(void);
+                void				notifyScanFinished(int16_t apCount);
+                void				notifyReconnectFailed(DisconnectCategory category);
+
+                void				onIgnoredEvent(void* eventData);
+                void				onScanDone(void* eventData);
+                void				onStationStart(void* eventData);
+                void				onStationStop(void* eventData);
+                void				onStationConnected(void* eventData);
+                void				onStationDisconnected(void* eventData);
+                void				onAccessPointStart(void* eventData);
+                void				onAccessPointStop(void* eventData);
+                void				onStationGotIP(void* eventData);
+                void				onStationLostIP(void* eventData);
                 static void			wifiEventHandlerWrapper(void* instance, esp_event_base_t eventBase, int32_t eventID, void* eventData);
+                static void			reconnectTimerCallback(void* instance);
+                static void			roamingTimerCallback(void* instance);
+                static void			leaseTimerCallback(void* instance);
 
             protected:
 
                 /**
-                 * @brief Set the correct wifi mode for scanning according to the current mode
+                 * @brief Start the station and connect to a WPA protected WIFI
                  *
-                 * @param currentMode   the current set WIFI mode
+                 * @param ssid      the SSID of the WIFI
+                 * @param password  the password for the WIFI
+                 * @param bssid     the access point to join or \c nullptr to let the driver search the network
+                 * @param channel   the channel of the access point, ignored without bssid
+                 *
+                 * @return  \c false if the WIFI station mode coud not be started
+                 */
+				bool				connectStation(const char *ssid, const char *password, const uint8_t *bssid, uint8_t channel);
+
+                /**
+                 * @brief Enable the station interface for scanning and start the radio
                  *
                  * @return      \c false if mode could not be set for scanning
                  */
-				bool				prepareForScan(wifi_mode_t currentMode);
+				bool				prepareForScan(void);
+
+                /**
+                 * @brief Release the station interface after scanning
+                 *
+                 * @return      \c false if the mode could not be switched back
+                 */
+				bool				recoverFromScan(void);
+
+                /**
+                 * @brief Retry a failed fast reconnect with a scan over all channels
+                 *
+                 * @return      \c false if the connection could not be restarted
+                 */
+				bool				fallbackToFullScan(void);
+
+                /**
+                 * @brief Sample the RSSI and start a roaming scan if the link stayed weak
+                 */
+				void				checkRoaming(void);
+
+                /**
+                 * @brief Move to a clearly stronger access point found by a roaming scan
+                 *
+                 * @return      \c false if no better access point was found or roaming failed
+                 */
+				bool				roamToBestAccessPoint(void);
 
                 /**
-                 * @brief Recover the correct mode which was set before scanning
+                 * @brief Schedule the next reconnect attempt according to the reconnect policy
                  *
-                 * @param targetMode    the mode which was set before scanning
+                 * @param category  the category of the disconnect which triggered the reconnect
                  *
-                 * @return      \c false if targetMode could not be set
+                 * @return      \c false if no attempt was scheduled
                  */
-				bool				recoverFromScan(wifi_mode_t targetMode);
+				bool				scheduleReconnect(DisconnectCategory category);
 
+                /**
+                 * @brief Cancel a pending reconnect attempt and reset the backoff
+                 */
+				void				resetReconnect(void);
 
-				WiFiEventHandler*	_wiFiEventHandler = { nullptr };
+                /**
+                 * @brief Send an ARP probe for the cached address, the lease is applied by the lease timer
+                 *
+                 * @return      \c false if the probe could not be sent
+                 */
+				bool				probeCachedLease(void);
+
+                /**
+                 * @brief Stop the lease timer, also for the timer events still queued on the event loop
+                 */
+				void				stopLeaseTimer(void);
+
+                /**
+                 * @brief Advance the cached lease to the next step, runs on the default event loop when the lease timer fired
+                 *
+                 * @param generation    the value of _leaseTimerGeneration when the timer fired
+                 */
+				void				onLeaseTimer(uint32_t generation);
+
+                /**
+                 * @brief Let the default event loop write the changed connection and lease records after the current event
+                 */
+				void				schedulePersist(void);
+
+                /**
+                 * @brief Write the connection and lease records if they changed, runs on the default event loop
+                 */
+				void				onPersistRecords(void);
+
+                /**
+                 * @brief Stop the DHCP client and apply the cached lease unless another host answered the probe
+                 *
+                 * @return      \c false if the lease could not be applied
+                 */
+				bool				applyCachedLease(void);
+
+                /**
+                 * @brief Start the lwIP DHCP client, which keeps the cached address until it is bound to a lease
+                 *
+                 * @return      \c false if the client could not be started
+                 */
+				bool				renewCachedLease(void);
+
+                /**
+                 * @brief Poll the lwIP DHCP client and report the lease if it differs from the cached one
+                 */
+				void				checkLeaseRenewal(void);
+
+                /**
+                 * @brief Hand the station interface back to the DHCP client of the adapter
+                 *
+                 * @param discard   \c true to also forget the cached lease if DHCP did not confirm it yet
+                 */
+				void				releaseCachedLease(bool discard);
+
+                /**
+                 * @brief Take the scan slot, scan(), scanAsync() and probeSSID() never run side by side
+                 *
+                 * @return      \c false if another scan is running
+                 */
+				bool				claimScan(void);
+
+                /**
+                 * @brief Claim the scan slot and start a scan which is finished by onScanDone()
+                 *
+                 * @param ssid          only scan for the specified SSID
+                 * @param showHidden    also include hidden networks
+                 * @param roaming       \c true to pass the results to roamToBestAccessPoint() instead of the handler
+                 *
+                 * @return      \c false if the scan could not be started or another scan is running
+                 */
+				bool				startAsyncScan(const std::string &ssid, bool showHidden, bool roaming);
+
+                /**
+                 * @brief Prepare the adapter and start a scan
+                 *
+                 * @param ssid          only scan for the specified SSID
+                 * @param showHidden    also include hidden networks
+                 * @param block         \c true to wait until the scan is done
+                 *
+                 * @return      \c false if the scan could not be started
+                 */
+				bool				startScan(const std::string &ssid, bool showHidden, bool block);
+
+                /**
+                 * @brief Start the scan of the current channel, or of all channels without a channel plan
+                 *
+                 * @param block         \c true to wait until the scan is done
+                 *
+                 * @return      \c false if the scan could not be started
+                 */
+				bool				startChannelScan(bool block);
+
+                /**
+                 * @brief Collect the records of the finished scan and start the next channel of the channel plan
+                 *
+                 * @param block         \c true to wait until the next scan is done
+                 *
+                 * @return      \c true if the scan continues on the next channel
+                 */
+				bool				scanNextChannel(bool block);
+
+                /**
+                 * @brief Send directed probe requests for an SSID on a single channel
+                 *
+                 * @param ssid          the SSID to look for
+                 * @param channel       the channel to probe
+                 *
+                 * @return      Found if an access point answered
+                 */
+				ProbeResult			probeChannel(const std::string &ssid, uint8_t channel);
+
+                /**
+                 * @brief Add an AP record to the scan cache and remember its channel
+                 *
+                 * @return      \c false if the access point was already collected
+                 */
+				bool				addScanRecord(const wifi_ap_record_t &record);
+
+                /**
+                 * @brief Fetch the AP records of the finished scan into the scan cache
+                 *
+                 * @return      \c false if the records could not be fetched
+                 */
+				bool				collectScanResults(void);
+
+                /**
+                 * @brief Get the next channel of the current scan pass within the regulatory domain
+                 *
+                 * @param channel       the current channel, 0 to get the first channel
+                 *
+                 * @return      the next channel or 0 if there is none
+                 */
+				uint8_t				nextScanChannel(uint8_t channel) const;
+
+                /**
+                 * @brief Get the channels of the regulatory domain as a bit mask, bit n stands for channel n
+                 */
+				uint16_t			regulatoryChannels(void) const;
+
+                /**
+                 * @brief Check if a channel lies in the regulatory domain and in the channel plan, if there is a usable one
+                 */
+				bool				isScanChannel(uint8_t channel) const;
+
+                /**
+                 * @brief Apply the regulatory domain to the driver
+                 */
+				bool				applyRegulatoryDomain(void);
+
+                /**
+                 * @brief Commit the collected records and recover the mode which was set before scanning
+                 *
+                 * @return      the number of found networks or -1 on failure
+                 */
+				int16_t				finishScan(void);
+
+
+				WiFiEventHandlerRegistry	_eventHandlers;
+				WiFiEventDispatcher*	_eventDispatcher = { nullptr };
+				RadioModeManager	_radio;
 				bool				_isInitialized = { false };
+				uint32_t			_driverHeapUsage = { 0 };
 				bool				_stationInitialized = { false };
                 bool                _stationEventsRegistered = { false };
 
+				std::atomic<bool>	_scanPending = { false };
+				std::atomic<bool>	_scanAsync = { false };
+				std::atomic<uint16_t>	_blockingScanEvents = { 0 };	///< SCAN_DONE events of blocking scans not delivered yet
+				std::string			_scanSSID;
+				bool				_scanShowHidden = { true };
+				uint8_t				_scanChannel = { 0 };
+				uint16_t			_scanPassChannels = { 0 };
+				uint16_t			_scanHitChannels = { 0 };
+				bool				_scanRefining = { false };
+				ScanProfile			_scanProfile = { ScanProfile::Default };
+				uint16_t			_scanFoundCount = { 0 };
+				bool				_scanFailed = { false };
+				char				_countryCode[3] = { 'D', 'E', '\0' };
+				uint8_t				_firstChannel = { 1 };
+				uint8_t				_channelCount = { 13 };
+				uint16_t			_channelPlan = { 0 };
+				WiFiScanCache		_scanCache;
+				WiFiEventTrace		_eventTrace;
+				WiFiConnectionTimeline	_connectionTimeline;
+
+				std::vector<NetworkProfile>	_networkProfiles;
+
+				WiFiConnectionRecord	_connectionRecord;
+				bool				_fastReconnect = { false };
+				bool				_connectionRecordLoaded = { false };
+				bool				_fastConnectAttempt = { false };
+				bool				_bssidPinned = { false };
+
+				WiFiLeaseRecord		_leaseRecord;
+				esp_timer_handle_t	_leaseTimer = { nullptr };
+				SemaphoreHandle_t	_leaseMutex = { nullptr };
+				uint32_t			_leaseRenewDelay = { 5000 };
+				uint8_t				_connectedBSSID[6] = {};
+				bool				_leaseCaching = { false };
+				LeaseState			_leaseState = { LeaseState::Unused };
+				std::atomic<uint32_t>	_leaseTimerGeneration = { 0 };	///< counts the stops of the lease timer
+
+				PowerProfile		_powerProfile = { PowerProfile::Balanced };
+				int64_t				_powerProfileSince = { 0 };
+				std::array<uint64_t, 3>	_powerProfileTime = {};
+
+				ReconnectPolicy		_reconnectPolicy;
+				esp_timer_handle_t	_reconnectTimer = { nullptr };
+				uint16_t			_reconnectAttempts = { 0 };
+				bool				_stationRequested = { false };
+				uint8_t				_lastDisconnectReason = { 0 };
+				bool				_stationConnected = { false };
+
+				RoamingConfig		_roamingConfig;
+				esp_timer_handle_t	_roamingTimer = { nullptr };
+				RSSISampler			_rssiSampler;
+				uint8_t				_weakRSSISamples = { 0 };
+				bool				_roamingArmed = { true };
+				std::atomic<bool>	_roamingScanPending = { false };
+				bool				_roamingInProgress = { false };
+
                 #ifdef CONFIG_IDF_TARGET_ESP32
                     esp_netif_t*		_stationInterface = { nullptr };
                     esp_netif_t*		_accessPointInterface = { nullptr };
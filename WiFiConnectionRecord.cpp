@@ -0,0 +1,103 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WiFiConnectionRecord.h"
+
+extern "C"
+{
+    #include <string.h>
+}
+
+namespace
+{
+	const char*		NVS_NAMESPACE = "idfix-wifi";
+	const char*		NVS_KEY = "lastap";
+	const uint8_t	RECORD_VERSION = 1;
+	const size_t	SSID_MAX_LEN = 32;
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		WiFiConnectionRecord::WiFiConnectionRecord()
+			: _record(NVS_NAMESPACE, NVS_KEY, RECORD_VERSION)
+		{
+
+		}
+
+		bool WiFiConnectionRecord::load()
+		{
+			return _record.load();
+		}
+
+		bool WiFiConnectionRecord::remember(const uint8_t *ssid, size_t ssidLen, const uint8_t *bssid, uint8_t channel)
+		{
+			Data data = {};
+
+			data.channel = channel;
+			data.ssidHash = hashSSID(ssid, ssidLen);
+			memcpy(data.bssid, bssid, sizeof(data.bssid));
+
+			return _record.remember(data);
+		}
+
+		bool WiFiConnectionRecord::persist()
+		{
+			return _record.persist();
+		}
+
+		void WiFiConnectionRecord::clear()
+		{
+			_record.clear();
+		}
+
+		bool WiFiConnectionRecord::matches(const char *ssid) const
+		{
+			if ( ! _record.isValid() )
+			{
+				return false;
+			}
+
+			return _record.get().ssidHash == hashSSID( reinterpret_cast<const uint8_t*>(ssid), strnlen(ssid, SSID_MAX_LEN) );
+		}
+
+		const uint8_t *WiFiConnectionRecord::getBSSID() const
+		{
+			return _record.get().bssid;
+		}
+
+		uint8_t WiFiConnectionRecord::getChannel() const
+		{
+			return _record.get().channel;
+		}
+
+		uint32_t WiFiConnectionRecord::hashSSID(const uint8_t *ssid, size_t ssidLen)
+		{
+			// FNV-1a
+			uint32_t hash = 2166136261u;
+
+			for ( size_t index = 0; index < ssidLen && ssid[index] != '\0'; index++ )
+			{
+				hash ^= ssid[index];
+				hash *= 16777619u;
+			}
+
+			return hash;
+		}
+	}
+}
@@ -0,0 +1,101 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIFICONNECTIONRECORD_H
+#define WIFICONNECTIONRECORD_H
+
+#include "NVSBlobRecord.h"
+
+extern "C"
+{
+    #include <stdint.h>
+    #include <stddef.h>
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+        /**
+         * @brief The WiFiConnectionRecord class persists the access point of the last successful connection
+         *
+         * Only a hash of the SSID is stored together with the BSSID and the channel, so the record
+         * stays compact and does not leak the network name into the NVS.
+         */
+		class WiFiConnectionRecord
+		{
+			public:
+
+								WiFiConnectionRecord();
+
+                /**
+                 * @brief Load the record from the NVS
+                 *
+                 * @return \c false if no valid record is stored
+                 */
+				bool			load(void);
+
+                /**
+                 * @brief Remember the access point of a successful connection, persist() writes it if it changed
+                 *
+                 * @param ssid      the SSID of the network
+                 * @param ssidLen   the length of the SSID
+                 * @param bssid     the BSSID of the access point
+                 * @param channel   the primary channel of the access point
+                 *
+                 * @return \c true if the record changed
+                 */
+				bool			remember(const uint8_t *ssid, size_t ssidLen, const uint8_t *bssid, uint8_t channel);
+
+                /**
+                 * @brief Write the remembered access point to the NVS if it changed
+                 *
+                 * @return \c false if writing failed
+                 */
+				bool			persist(void);
+
+                /**
+                 * @brief Forget the stored access point and remove it from the NVS
+                 */
+				void			clear(void);
+
+                /**
+                 * @brief Check if the record holds an access point of the given network
+                 */
+				bool			matches(const char *ssid) const;
+
+				const uint8_t*	getBSSID(void) const;
+				uint8_t			getChannel(void) const;
+
+			protected:
+
+				static uint32_t	hashSSID(const uint8_t *ssid, size_t ssidLen);
+
+				struct Data
+				{
+					uint8_t		version;
+					uint8_t		channel;
+					uint8_t		bssid[6];
+					uint32_t	ssidHash;
+				};
+
+				NVSBlobRecord<Data>	_record;
+		};
+	}
+}
+
+#endif
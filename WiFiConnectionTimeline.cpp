@@ -0,0 +1,227 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WiFiConnectionTimeline.h"
+
+#include <algorithm>
+
+extern "C"
+{
+    #include <esp_log.h>
+    #include <esp_timer.h>
+    #include <esp_system.h>
+}
+
+namespace
+{
+	const char*	LOG_TAG = "IDFix::WiFiConnectionTimeline";
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		constexpr std::array<uint32_t, WiFiConnectionTimeline::BUCKET_COUNT - 1>	WiFiConnectionTimeline::BUCKET_LIMITS;
+
+		void WiFiConnectionTimeline::connectRequested(bool startingDriver)
+		{
+			_requested = esp_timer_get_time();
+			_started = _requested;
+			_startingDriver = startingDriver;
+			_events = 0;
+			_active = true;
+		}
+
+		void WiFiConnectionTimeline::eventReceived()
+		{
+			if ( _active && _events < UINT16_MAX )
+			{
+				_events++;
+			}
+		}
+
+		void WiFiConnectionTimeline::stationStarted()
+		{
+			if ( _active && _startingDriver )
+			{
+				_started = esp_timer_get_time();
+				_startingDriver = false;
+
+				record(PhaseDriverStart, _requested, _started);
+			}
+		}
+
+		void WiFiConnectionTimeline::stationConnected()
+		{
+			if ( _active )
+			{
+				_connected = esp_timer_get_time();
+
+				record(PhaseAssociation, _started, _connected);
+			}
+		}
+
+		void WiFiConnectionTimeline::gotIP()
+		{
+			if ( _active )
+			{
+				int64_t now = esp_timer_get_time();
+
+				record(PhaseDHCP, _connected, now);
+				record(PhaseTotal, _requested, now);
+
+				_lastEventCount = _events;
+				_minimumFreeHeap = esp_get_minimum_free_heap_size();
+				_active = false;
+			}
+		}
+
+		void WiFiConnectionTimeline::cancel()
+		{
+			_active = false;
+		}
+
+		const WiFiConnectionTimeline::Histogram& WiFiConnectionTimeline::getHistogram(Phase phase) const
+		{
+			return _histograms[phase < PHASE_COUNT ? phase : PhaseTotal];
+		}
+
+		uint32_t WiFiConnectionTimeline::getPercentile(Phase phase, uint8_t percent) const
+		{
+			const Histogram &histogram = getHistogram(phase);
+
+			if ( histogram.count == 0 )
+			{
+				return 0;
+			}
+
+			// rank of the sample the percentile points to, rounded up
+			uint32_t rank = ( static_cast<uint64_t>(histogram.count) * percent + 99 ) / 100;
+			uint32_t seen = 0;
+
+			for ( size_t bucket = 0; bucket < BUCKET_LIMITS.size(); bucket++ )
+			{
+				seen += histogram.buckets[bucket];
+
+				if ( seen >= rank )
+				{
+					return std::min(BUCKET_LIMITS[bucket], histogram.max);
+				}
+			}
+
+			return histogram.max;
+		}
+
+		uint16_t WiFiConnectionTimeline::getLastEventCount() const
+		{
+			return _lastEventCount;
+		}
+
+		uint32_t WiFiConnectionTimeline::getMinimumFreeHeap() const
+		{
+			return _minimumFreeHeap;
+		}
+
+		void WiFiConnectionTimeline::reset()
+		{
+			_histograms = {};
+		}
+
+		void WiFiConnectionTimeline::record(Phase phase, int64_t begin, int64_t end)
+		{
+			Histogram	&histogram = _histograms[phase];
+			uint32_t	duration = static_cast<uint32_t>( ( end - begin ) / 1000 );
+			size_t		bucket = 0;
+
+			while ( bucket < BUCKET_LIMITS.size() && duration > BUCKET_LIMITS[bucket] )
+			{
+				bucket++;
+			}
+
+			histogram.buckets[bucket]++;
+
+			if ( histogram.count == 0 || duration < histogram.min )
+			{
+				histogram.min = duration;
+			}
+
+			if ( duration > histogram.max )
+			{
+				histogram.max = duration;
+			}
+
+			histogram.last = duration;
+			histogram.sum += duration;
+			histogram.count++;
+		}
+
+		void WiFiConnectionTimeline::dump() const
+		{
+			for ( size_t phase = 0; phase < PHASE_COUNT; phase++ )
+			{
+				const Histogram &histogram = _histograms[phase];
+
+				if ( histogram.count == 0 )
+				{
+					ESP_LOGI(LOG_TAG, "%-12s  no samples", phaseToString(static_cast<Phase>(phase)));
+					continue;
+				}
+
+				ESP_LOGI(LOG_TAG, "%-12s  count %u  last %u ms  min %u ms  max %u ms  avg %u ms  p50 <= %u ms  p99 <= %u ms", phaseToString(static_cast<Phase>(phase)),
+						 static_cast<unsigned>(histogram.count), static_cast<unsigned>(histogram.last), static_cast<unsigned>(histogram.min),
+						 static_cast<unsigned>(histogram.max), static_cast<unsigned>(histogram.sum / histogram.count),
+						 static_cast<unsigned>(getPercentile(static_cast<Phase>(phase), 50)), static_cast<unsigned>(getPercentile(static_cast<Phase>(phase), 99)));
+
+				for ( size_t bucket = 0; bucket < BUCKET_COUNT; bucket++ )
+				{
+					if ( histogram.buckets[bucket] == 0 )
+					{
+						continue;
+					}
+
+					if ( bucket < BUCKET_LIMITS.size() )
+					{
+						ESP_LOGI(LOG_TAG, "    <= %5u ms: %u", static_cast<unsigned>(BUCKET_LIMITS[bucket]), static_cast<unsigned>(histogram.buckets[bucket]));
+					}
+					else
+					{
+						ESP_LOGI(LOG_TAG, "     > %5u ms: %u", static_cast<unsigned>(BUCKET_LIMITS.back()), static_cast<unsigned>(histogram.buckets[bucket]));
+					}
+				}
+			}
+
+			ESP_LOGI(LOG_TAG, "last connect: %u events, minimum free heap %u bytes", _lastEventCount, static_cast<unsigned>(_minimumFreeHeap));
+		}
+
+		const char* WiFiConnectionTimeline::phaseToString(Phase phase)
+		{
+			switch ( phase )
+			{
+				case PhaseDriverStart:
+					return "driver start";
+				case PhaseAssociation:
+					return "association";
+				case PhaseDHCP:
+					return "DHCP";
+				case PhaseTotal:
+					return "total";
+				default:
+					return "unknown";
+			}
+		}
+	}
+}
@@ -0,0 +1,159 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIFICONNECTIONTIMELINE_H
+#define WIFICONNECTIONTIMELINE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+        /**
+         * @brief The WiFiConnectionTimeline class measures how long the phases of a station connect take
+         *
+         * A connect runs through the following phases:
+         *
+         * - PhaseDriverStart:  connect requested until WIFI_EVENT_STA_START, only if the driver had to be started
+         * - PhaseAssociation:  driver started until WIFI_EVENT_STA_CONNECTED, this covers scan, association and authentication
+         * - PhaseDHCP:         WIFI_EVENT_STA_CONNECTED until IP_EVENT_STA_GOT_IP
+         * - PhaseTotal:        connect requested until IP_EVENT_STA_GOT_IP
+         *
+         * Every finished phase is added to a fixed bucket histogram of its own. For every successful
+         * connect the number of WiFi and IP events it took and the free heap low watermark are kept as well.
+         */
+		class WiFiConnectionTimeline
+		{
+			public:
+
+				enum Phase : uint8_t
+				{
+					PhaseDriverStart,
+					PhaseAssociation,
+					PhaseDHCP,
+					PhaseTotal,
+					PHASE_COUNT
+				};
+
+				static constexpr size_t		BUCKET_COUNT = 10;
+
+                /**
+                 * @brief The upper bounds of the histogram buckets in milliseconds, the last bucket takes everything above
+                 */
+				static constexpr std::array<uint32_t, BUCKET_COUNT - 1>	BUCKET_LIMITS = { 50, 100, 200, 500, 1000, 2000, 3000, 5000, 10000 };
+
+				struct Histogram
+				{
+					std::array<uint32_t, BUCKET_COUNT>	buckets;
+					uint32_t							count;
+					uint32_t							min;		///< milliseconds
+					uint32_t							max;		///< milliseconds
+					uint32_t							last;		///< milliseconds
+					uint64_t							sum;		///< milliseconds
+				};
+
+                /**
+                 * @brief A connect was requested
+                 *
+                 * @param startingDriver    \c true if the driver is started for this connect
+                 */
+				void				connectRequested(bool startingDriver);
+
+                /**
+                 * @brief Count a WiFi or IP event towards the running connect
+                 */
+				void				eventReceived(void);
+
+                /**
+                 * @brief The driver reported WIFI_EVENT_STA_START
+                 */
+				void				stationStarted(void);
+
+                /**
+                 * @brief The driver reported WIFI_EVENT_STA_CONNECTED
+                 */
+				void				stationConnected(void);
+
+                /**
+                 * @brief The driver reported IP_EVENT_STA_GOT_IP
+                 */
+				void				gotIP(void);
+
+                /**
+                 * @brief Forget the running connect without recording it, e.g. because it was canceled
+                 */
+				void				cancel(void);
+
+                /**
+                 * @brief Get the histogram of a phase
+                 */
+				const Histogram&	getHistogram(Phase phase) const;
+
+                /**
+                 * @brief Estimate a percentile of a phase from its histogram
+                 *
+                 * @param phase     the phase
+                 * @param percent   the percentile, e.g. 50 or 99
+                 *
+                 * @return the upper bound of the bucket the percentile falls into in milliseconds,
+                 *         the maximum duration for the last bucket or 0 without samples
+                 */
+				uint32_t			getPercentile(Phase phase, uint8_t percent) const;
+
+                /**
+                 * @brief Get the number of WiFi and IP events of the last successful connect
+                 */
+				uint16_t			getLastEventCount(void) const;
+
+                /**
+                 * @brief Get the lowest free heap since boot, as seen when the last connect succeeded
+                 */
+				uint32_t			getMinimumFreeHeap(void) const;
+
+                /**
+                 * @brief Clear all histograms
+                 */
+				void				reset(void);
+
+                /**
+                 * @brief Write the histograms to the log
+                 */
+				void				dump(void) const;
+
+				static const char*	phaseToString(Phase phase);
+
+			private:
+
+				void				record(Phase phase, int64_t begin, int64_t end);
+
+				std::array<Histogram, PHASE_COUNT>	_histograms = {};
+				int64_t								_requested = { 0 };		///< microseconds since boot
+				int64_t								_started = { 0 };
+				int64_t								_connected = { 0 };
+				uint16_t							_events = { 0 };
+				uint16_t							_lastEventCount = { 0 };
+				uint32_t							_minimumFreeHeap = { 0 };
+				bool								_active = { false };
+				bool								_startingDriver = { false };
+		};
+	}
+}
+
+#endif
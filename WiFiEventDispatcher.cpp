@@ -0,0 +1,137 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WiFiEventDispatcher.h"
+#include "WiFiEventHandler.h"
+#include "WiFiEventHandlerRegistry.h"
+
+extern "C"
+{
+    #include <esp_log.h>
+}
+
+namespace
+{
+	const char*	LOG_TAG = "IDFix::WiFiEventDispatcher";
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		void HandlerNotification::deliver(WiFiEventHandler &handler) const
+		{
+			switch (type)
+			{
+				case Type::NetworkConnected:		handler.networkConnected(ipInfo);					return;
+				case Type::NetworkDisconnected:		handler.networkDisconnected();						return;
+				case Type::AccessPointStarted:		handler.accessPointStarted(accessPointIPAddress);	return;
+				case Type::AccessPointStopped:		handler.accessPointStopped();						return;
+				case Type::ScanFinished:			handler.scanFinished(apCount);						return;
+				case Type::ReconnectFailed:			handler.reconnectFailed(category);					return;
+			}
+		}
+
+		WiFiEventDispatcher::WiFiEventDispatcher(WiFiEventHandlerRegistry *handlers) : _handlers(handlers)
+		{
+
+		}
+
+		bool WiFiEventDispatcher::start(uint32_t stackSize, UBaseType_t priority)
+		{
+			if ( _task != nullptr )
+			{
+				return true;
+			}
+
+			if ( xTaskCreate(&WiFiEventDispatcher::taskFunction, "wifi_dispatch", stackSize, static_cast<void*>(this), priority, &_task) != pdPASS )
+			{
+				ESP_LOGE(LOG_TAG, "start: xTaskCreate failed");
+				_task = nullptr;
+				return false;
+			}
+
+			return true;
+		}
+
+		bool WiFiEventDispatcher::post(const HandlerNotification &notification)
+		{
+			if ( _task == nullptr )
+			{
+				// nobody would ever take the notification out of the queue
+				_dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			size_t head = _head.load(std::memory_order_relaxed);
+			size_t next = ( head + 1 ) % CAPACITY;
+
+			if ( next == _tail.load(std::memory_order_acquire) )
+			{
+				_dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			_queue[head] = notification;
+			_head.store(next, std::memory_order_release);
+
+			xTaskNotifyGive(_task);
+
+			return true;
+		}
+
+		uint32_t WiFiEventDispatcher::getDroppedCount() const
+		{
+			return _dropped.load(std::memory_order_relaxed);
+		}
+
+		void WiFiEventDispatcher::taskFunction(void *instance)
+		{
+			static_cast<WiFiEventDispatcher*>(instance)->run();
+		}
+
+		void WiFiEventDispatcher::run()
+		{
+			HandlerNotification notification;
+
+			while ( true )
+			{
+				ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+				while ( pop(notification) )
+				{
+					_handlers->deliver(notification);
+				}
+			}
+		}
+
+		bool WiFiEventDispatcher::pop(HandlerNotification &notification)
+		{
+			size_t tail = _tail.load(std::memory_order_relaxed);
+
+			if ( tail == _head.load(std::memory_order_acquire) )
+			{
+				return false;
+			}
+
+			notification = _queue[tail];
+			_tail.store(( tail + 1 ) % CAPACITY, std::memory_order_release);
+
+			return true;
+		}
+	}
+}
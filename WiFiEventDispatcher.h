@@ -0,0 +1,127 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIFIEVENTDISPATCHER_H
+#define WIFIEVENTDISPATCHER_H
+
+#include "WiFi.h"
+#include "WiFiUtils.h"
+
+extern "C"
+{
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+}
+
+#include <array>
+#include <atomic>
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		class WiFiEventHandlerRegistry;
+		class WiFiEventHandler;
+
+        /**
+         * @brief The HandlerNotification struct carries one WiFiEventHandler callback and its argument
+         */
+        struct HandlerNotification
+        {
+            enum class Type : uint8_t
+            {
+                NetworkConnected,
+                NetworkDisconnected,
+                AccessPointStarted,
+                AccessPointStopped,
+                ScanFinished,
+                ReconnectFailed
+            };
+
+            Type    type;
+
+            union
+            {
+                IPInfo              ipInfo;
+                ip4_addr_t          accessPointIPAddress;
+                int16_t             apCount;
+                DisconnectCategory  category;
+            };
+
+            /**
+             * @brief Invoke the callback of the notification on a handler
+             *
+             * @param handler   the handler to notify
+             */
+            void    deliver(WiFiEventHandler &handler) const;
+        };
+
+        /**
+         * @brief The WiFiEventDispatcher class runs the WiFiEventHandler callbacks on its own task
+         *
+         * Notifications are posted in constant time into a preallocated single producer / single
+         * consumer queue. The producer must always be the same task, which is the default event loop.
+         */
+		class WiFiEventDispatcher
+		{
+			public:
+
+				static constexpr size_t	CAPACITY = 16;
+
+									WiFiEventDispatcher(WiFiEventHandlerRegistry *handlers);
+
+                /**
+                 * @brief Start the dispatcher task
+                 *
+                 * @param stackSize     the stack size of the task in bytes
+                 * @param priority      the priority of the task
+                 *
+                 * @return \c false if the task could not be created
+                 */
+				bool				start(uint32_t stackSize, UBaseType_t priority);
+
+                /**
+                 * @brief Queue a notification for the dispatcher task
+                 *
+                 * @param notification  the notification to deliver
+                 *
+                 * @return \c false if the task is not started or the queue is full and the notification was dropped
+                 */
+				bool				post(const HandlerNotification &notification);
+
+                /**
+                 * @brief Get the number of notifications dropped because the queue was full or the task was not started
+                 */
+				uint32_t			getDroppedCount(void) const;
+
+			private:
+
+				static void			taskFunction(void *instance);
+				void				run(void);
+				bool				pop(HandlerNotification &notification);
+
+				WiFiEventHandlerRegistry*					_handlers;
+				TaskHandle_t								_task = { nullptr };
+				std::array<HandlerNotification, CAPACITY>	_queue;
+				std::atomic<size_t>							_head = { 0 };
+				std::atomic<size_t>							_tail = { 0 };
+				std::atomic<uint32_t>						_dropped = { 0 };
+		};
+	}
+}
+
+#endif
@@ -47,5 +47,15 @@ namespace IDFix
 
 		}
 
+		void WiFiEventHandler::scanFinished(int16_t)
+		{
+
+		}
+
+		void WiFiEventHandler::reconnectFailed(DisconnectCategory)
+		{
+
+		}
+
 	}
 }
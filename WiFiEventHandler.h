@@ -59,6 +59,18 @@ namespace IDFix
                  * @brief This event is triggered if the access point is finally stopped.
                  */
 				virtual void	accessPointStopped(void);
+
+                /**
+                 * @brief This event is triggered if a scan started by WiFi::scanAsync() is done.
+                 * @param apCount   the number of found networks or -1 if the scan failed
+                 */
+				virtual void	scanFinished(int16_t apCount);
+
+                /**
+                 * @brief This event is triggered if the automatic reconnect gave up according to the WiFi's ReconnectPolicy.
+                 * @param lastCategory  the category of the disconnect which made the reconnect give up
+                 */
+				virtual void	reconnectFailed(DisconnectCategory lastCategory);
 		};
 	}
 }
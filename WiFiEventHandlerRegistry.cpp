@@ -0,0 +1,193 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WiFiEventHandlerRegistry.h"
+#include "WiFiEventHandler.h"
+#include "WiFiEventDispatcher.h"
+
+extern "C"
+{
+    #include <esp_log.h>
+}
+
+namespace
+{
+	const char* LOG_TAG = "IDFix::WiFiEventHandlerRegistry";
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		WiFiEventHandlerRegistry::WiFiEventHandlerRegistry()
+		{
+			// the mutex is recursive, so handlers may add or remove handlers while they are notified
+			_mutex = xSemaphoreCreateRecursiveMutex();
+
+			if ( _mutex == nullptr )
+			{
+				ESP_LOGE(LOG_TAG, "xSemaphoreCreateRecursiveMutex failed, handlers can't be added");
+			}
+		}
+
+		WiFiEventHandlerRegistry::~WiFiEventHandlerRegistry()
+		{
+			if ( _mutex != nullptr )
+			{
+				vSemaphoreDelete(_mutex);
+			}
+		}
+
+		bool WiFiEventHandlerRegistry::addHandler(WiFiEventHandler *handler, int8_t priority)
+		{
+			bool result = false;
+
+			if ( handler == nullptr || _mutex == nullptr )
+			{
+				return false;
+			}
+
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			if ( _count < CAPACITY && ! contains(handler) )
+			{
+				size_t position = _count;
+
+				// insert behind all handlers with the same or a higher priority
+				while ( position > 0 && _subscribers[position - 1].priority < priority )
+				{
+					_subscribers[position] = _subscribers[position - 1];
+					position--;
+				}
+
+				_subscribers[position] = Subscriber{ handler, priority };
+				_count++;
+				result = true;
+			}
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			return result;
+		}
+
+		bool WiFiEventHandlerRegistry::removeHandler(WiFiEventHandler *handler)
+		{
+			bool result = false;
+
+			if ( _mutex == nullptr )
+			{
+				return false;
+			}
+
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			for ( size_t index = 0; index < _count; index++ )
+			{
+				if ( _subscribers[index].handler == handler )
+				{
+					for ( size_t next = index + 1; next < _count; next++ )
+					{
+						_subscribers[next - 1] = _subscribers[next];
+					}
+
+					_count--;
+					result = true;
+					break;
+				}
+			}
+
+			// the caller may destroy the handler once we return, so wait for a running call on another task;
+			// a handler removing itself from within its callback must not wait for itself
+			while ( result && _calledHandler == handler && _callingTask != xTaskGetCurrentTaskHandle() )
+			{
+				xSemaphoreGiveRecursive(_mutex);
+				vTaskDelay(1);
+				xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+			}
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			return result;
+		}
+
+		void WiFiEventHandlerRegistry::deliver(const HandlerNotification &notification)
+		{
+			if ( _mutex == nullptr )
+			{
+				return;
+			}
+
+			// copy the handlers and call them without the lock, a handler may change the registry
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			std::array<Subscriber, CAPACITY>	subscribers = _subscribers;
+			size_t								count = _count;
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			for ( size_t index = 0; index < count; index++ )
+			{
+				if ( beginCall(subscribers[index].handler) )
+				{
+					notification.deliver(*subscribers[index].handler);
+					endCall();
+				}
+			}
+		}
+
+		bool WiFiEventHandlerRegistry::beginCall(WiFiEventHandler *handler)
+		{
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			// removed since the copy was taken
+			bool registered = contains(handler);
+
+			if ( registered )
+			{
+				_calledHandler = handler;
+				_callingTask = xTaskGetCurrentTaskHandle();
+			}
+
+			xSemaphoreGiveRecursive(_mutex);
+
+			return registered;
+		}
+
+		void WiFiEventHandlerRegistry::endCall()
+		{
+			xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+
+			_calledHandler = nullptr;
+			_callingTask = nullptr;
+
+			xSemaphoreGiveRecursive(_mutex);
+		}
+
+		bool WiFiEventHandlerRegistry::contains(WiFiEventHandler *handler) const
+		{
+			for ( size_t index = 0; index < _count; index++ )
+			{
+				if ( _subscribers[index].handler == handler )
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+	}
+}
@@ -0,0 +1,117 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIFIEVENTHANDLERREGISTRY_H
+#define WIFIEVENTHANDLERREGISTRY_H
+
+extern "C"
+{
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/semphr.h>
+    #include <freertos/task.h>
+}
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		class WiFiEventHandler;
+		struct HandlerNotification;
+
+        /**
+         * @brief The WiFiEventHandlerRegistry class fans out WiFi events to several WiFiEventHandlers
+         *
+         * Handlers are notified in order of descending priority, handlers with the same priority in
+         * the order they were added. The registry has a fixed capacity and never allocates after
+         * construction.
+         *
+         * Handlers may be added and removed from any task, also from within a handler callback.
+         * The handlers are called without holding the lock of the registry, so a slow handler does not
+         * block other tasks which add or remove handlers. Once removeHandler() returned, the removed
+         * handler is not called anymore: if it is just being called on another task, removeHandler()
+         * waits until the call returned.
+         *
+         * Notifications are delivered by one task at a time, the default event loop or the dispatcher.
+         */
+		class WiFiEventHandlerRegistry
+		{
+			public:
+
+				static constexpr size_t	CAPACITY = 8;
+
+									WiFiEventHandlerRegistry();
+									~WiFiEventHandlerRegistry();
+
+                /**
+                 * @brief Add a handler
+                 *
+                 * @param handler   the handler to add
+                 * @param priority  the priority of the handler, higher priorities are notified first
+                 *
+                 * @return \c false if the registry is full, the handler is already registered or the
+                 *         registry could not create its mutex
+                 */
+				bool				addHandler(WiFiEventHandler *handler, int8_t priority = 0);
+
+                /**
+                 * @brief Remove a handler, waits if the handler is just being called on another task
+                 *
+                 * @param handler   the handler to remove
+                 *
+                 * @return \c false if the handler is not registered
+                 */
+				bool				removeHandler(WiFiEventHandler *handler);
+
+                /**
+                 * @brief Deliver a notification to all registered handlers
+                 *
+                 * @param notification  the notification to deliver
+                 */
+				void				deliver(const HandlerNotification &notification);
+
+			private:
+
+				struct Subscriber
+				{
+					WiFiEventHandler*	handler;
+					int8_t				priority;
+				};
+
+				bool				contains(WiFiEventHandler *handler) const;
+
+                /**
+                 * @brief Mark the handler as being called, unless it was removed meanwhile
+                 *
+                 * @return \c false if the handler was removed
+                 */
+				bool				beginCall(WiFiEventHandler *handler);
+				void				endCall(void);
+
+				std::array<Subscriber, CAPACITY>	_subscribers = {};
+				size_t								_count = { 0 };
+				SemaphoreHandle_t					_mutex = { nullptr };
+				WiFiEventHandler*					_calledHandler = { nullptr };	///< the handler deliver() is calling, guarded by _mutex
+				TaskHandle_t						_callingTask = { nullptr };
+		};
+	}
+}
+
+#endif
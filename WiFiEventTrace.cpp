@@ -0,0 +1,147 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WiFiEventTrace.h"
+#include "WiFiUtils.h"
+
+#include <algorithm>
+
+extern "C"
+{
+    #include <esp_log.h>
+    #include <esp_timer.h>
+    #include <esp_wifi_types.h>
+    #include <esp_netif.h>
+}
+
+namespace
+{
+	const char*	LOG_TAG = "IDFix::WiFiEventTrace";
+
+	uint32_t macTail(const uint8_t *mac)
+	{
+		return ( static_cast<uint32_t>(mac[2]) << 24 ) | ( static_cast<uint32_t>(mac[3]) << 16 ) | ( static_cast<uint32_t>(mac[4]) << 8 ) | mac[5];
+	}
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		void WiFiEventTrace::record(esp_event_base_t eventBase, int32_t eventID, const void *eventData)
+		{
+			uint32_t	written = _written.load(std::memory_order_relaxed);
+			Entry		&entry = _entries[written % CAPACITY];
+
+			entry.timestamp = static_cast<uint32_t>( esp_timer_get_time() / 1000 );
+			entry.id = static_cast<uint8_t>(eventID);
+			entry.value = 0;
+			entry.data = 0;
+
+			if ( eventBase == WIFI_EVENT )
+			{
+				entry.base = BaseWiFi;
+
+				switch (eventID)
+				{
+					case WIFI_EVENT_SCAN_DONE:
+					{
+						const wifi_event_sta_scan_done_t* event = static_cast<const wifi_event_sta_scan_done_t*>(eventData);
+						entry.value = event->number;
+						entry.data = event->status;
+						break;
+					}
+
+					case WIFI_EVENT_STA_CONNECTED:
+					{
+						const wifi_event_sta_connected_t* event = static_cast<const wifi_event_sta_connected_t*>(eventData);
+						entry.value = event->channel;
+						entry.data = macTail(event->bssid);
+						break;
+					}
+
+					case WIFI_EVENT_STA_DISCONNECTED:
+					{
+						const wifi_event_sta_disconnected_t* event = static_cast<const wifi_event_sta_disconnected_t*>(eventData);
+						entry.value = event->reason;
+						entry.data = macTail(event->bssid);
+						break;
+					}
+
+					case WIFI_EVENT_AP_STACONNECTED:
+					{
+						const wifi_event_ap_staconnected_t* event = static_cast<const wifi_event_ap_staconnected_t*>(eventData);
+						entry.value = event->aid;
+						entry.data = macTail(event->mac);
+						break;
+					}
+
+					case WIFI_EVENT_AP_STADISCONNECTED:
+					{
+						const wifi_event_ap_stadisconnected_t* event = static_cast<const wifi_event_ap_stadisconnected_t*>(eventData);
+						entry.value = event->aid;
+						entry.data = macTail(event->mac);
+						break;
+					}
+				}
+			}
+			else
+			{
+				entry.base = BaseIP;
+
+				if ( eventID == IP_EVENT_STA_GOT_IP )
+				{
+					const ip_event_got_ip_t* event = static_cast<const ip_event_got_ip_t*>(eventData);
+					entry.value = event->ip_changed;
+					entry.data = event->ip_info.ip.addr;
+				}
+			}
+
+			_written.store(written + 1, std::memory_order_release);
+		}
+
+		size_t WiFiEventTrace::read(Entry *entries, size_t maxEntries) const
+		{
+			uint32_t	written = _written.load(std::memory_order_acquire);
+			size_t		count = std::min<size_t>( std::min<size_t>(written, CAPACITY), maxEntries );
+			uint32_t	first = written - count;
+
+			for ( size_t index = 0; index < count; index++ )
+			{
+				entries[index] = _entries[(first + index) % CAPACITY];
+			}
+
+			return count;
+		}
+
+		void WiFiEventTrace::dump() const
+		{
+			Entry	entries[CAPACITY];
+			size_t	count = read(entries, CAPACITY);
+
+			ESP_LOGI(LOG_TAG, "%u recorded events:", static_cast<unsigned>(count));
+
+			for ( size_t index = 0; index < count; index++ )
+			{
+				const Entry &entry = entries[index];
+				const char* name = entry.base == BaseWiFi ? WiFiUtils::wiFiEventTypeToString(entry.id) : WiFiUtils::ipEventTypeToString(entry.id);
+
+				ESP_LOGI(LOG_TAG, "%10u ms  %-32s  %5u  0x%08x", static_cast<unsigned>(entry.timestamp), name, entry.value, static_cast<unsigned>(entry.data));
+			}
+		}
+	}
+}
@@ -0,0 +1,106 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIFIEVENTTRACE_H
+#define WIFIEVENTTRACE_H
+
+extern "C"
+{
+    #include <esp_event.h>
+}
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Set to 1 to get a formatted log line for every WIFI and IP event in addition to the binary trace.
+ * Formatted logging is slow on the event loop, so it is compiled out by default.
+ */
+#ifndef IDFIX_WIFI_EVENT_LOGGING
+    #define IDFIX_WIFI_EVENT_LOGGING 0
+#endif
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+        /**
+         * @brief The WiFiEventTrace class records WIFI and IP events into a fixed size binary ring buffer
+         *
+         * Recording an event costs a few stores, decoding into a readable log happens on demand by dump().
+         * Only one task may record events, which is the default event loop task.
+         */
+		class WiFiEventTrace
+		{
+			public:
+
+                /**
+                 * @brief A recorded event, the meaning of value and data depends on the event
+                 *
+                 * - WIFI_EVENT_SCAN_DONE:          value: number of APs, data: status
+                 * - WIFI_EVENT_STA_CONNECTED:      value: channel, data: last 4 bytes of the BSSID
+                 * - WIFI_EVENT_STA_DISCONNECTED:   value: reason, data: last 4 bytes of the BSSID
+                 * - WIFI_EVENT_AP_STA(DIS)CONNECTED: value: AID, data: last 4 bytes of the MAC
+                 * - IP_EVENT_STA_GOT_IP:           value: IP changed, data: IP address
+                 */
+				struct Entry
+				{
+					uint32_t	timestamp;	///< milliseconds since boot
+					uint8_t		base;		///< one of the Base values
+					uint8_t		id;			///< the event ID
+					uint16_t	value;
+					uint32_t	data;
+				};
+
+				enum Base : uint8_t
+				{
+					BaseWiFi,
+					BaseIP
+				};
+
+				static constexpr size_t	CAPACITY = 64;
+
+                /**
+                 * @brief Record an event and its key payload fields
+                 */
+				void				record(esp_event_base_t eventBase, int32_t eventID, const void *eventData);
+
+                /**
+                 * @brief Copy the recorded events, oldest first
+                 *
+                 * @param entries       the buffer to copy to
+                 * @param maxEntries    the size of the buffer
+                 *
+                 * @return the number of copied entries
+                 */
+				size_t				read(Entry *entries, size_t maxEntries) const;
+
+                /**
+                 * @brief Decode the recorded events and write them to the log
+                 */
+				void				dump(void) const;
+
+			private:
+
+				std::array<Entry, CAPACITY>	_entries = {};
+				std::atomic<uint32_t>		_written = { 0 };
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WiFiLeaseRecord.h"
+
+extern "C"
+{
+    #include <string.h>
+}
+
+namespace
+{
+	const char*		NVS_NAMESPACE = "idfix-wifi";
+	const char*		NVS_KEY = "lease";
+	const uint8_t	RECORD_VERSION = 1;
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		WiFiLeaseRecord::WiFiLeaseRecord()
+			: _record(NVS_NAMESPACE, NVS_KEY, RECORD_VERSION)
+		{
+
+		}
+
+		bool WiFiLeaseRecord::load()
+		{
+			if ( _record.load() && _record.get().ip == 0 )
+			{
+				_record.invalidate();
+			}
+
+			return _record.isValid();
+		}
+
+		bool WiFiLeaseRecord::remember(const uint8_t *bssid, uint32_t ip, uint32_t netMask, uint32_t gateway)
+		{
+			Data data = {};
+
+			data.ip = ip;
+			data.netMask = netMask;
+			data.gateway = gateway;
+			memcpy(data.bssid, bssid, sizeof(data.bssid));
+
+			return _record.remember(data);
+		}
+
+		bool WiFiLeaseRecord::persist()
+		{
+			return _record.persist();
+		}
+
+		void WiFiLeaseRecord::clear()
+		{
+			_record.clear();
+		}
+
+		bool WiFiLeaseRecord::matches(const uint8_t *bssid) const
+		{
+			return _record.isValid() && memcmp(_record.get().bssid, bssid, sizeof(_record.get().bssid)) == 0;
+		}
+
+		uint32_t WiFiLeaseRecord::getIP() const
+		{
+			return _record.get().ip;
+		}
+
+		uint32_t WiFiLeaseRecord::getNetMask() const
+		{
+			return _record.get().netMask;
+		}
+
+		uint32_t WiFiLeaseRecord::getGateway() const
+		{
+			return _record.get().gateway;
+		}
+	}
+}
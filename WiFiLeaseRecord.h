@@ -0,0 +1,99 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIFILEASERECORD_H
+#define WIFILEASERECORD_H
+
+#include "NVSBlobRecord.h"
+
+extern "C"
+{
+    #include <stdint.h>
+    #include <stddef.h>
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+        /**
+         * @brief The WiFiLeaseRecord class persists the last DHCP lease together with the access point it was obtained from
+         */
+		class WiFiLeaseRecord
+		{
+			public:
+
+								WiFiLeaseRecord();
+
+                /**
+                 * @brief Load the record from the NVS
+                 *
+                 * @return \c false if no valid record is stored
+                 */
+				bool			load(void);
+
+                /**
+                 * @brief Remember a lease, persist() writes it if it changed
+                 *
+                 * @param bssid     the BSSID of the access point the lease was obtained from
+                 * @param ip        the leased address
+                 * @param netMask   the network mask
+                 * @param gateway   the gateway
+                 *
+                 * @return \c true if the record changed
+                 */
+				bool			remember(const uint8_t *bssid, uint32_t ip, uint32_t netMask, uint32_t gateway);
+
+                /**
+                 * @brief Write the remembered lease to the NVS if it changed
+                 *
+                 * @return \c false if writing failed
+                 */
+				bool			persist(void);
+
+                /**
+                 * @brief Forget the stored lease and remove it from the NVS
+                 */
+				void			clear(void);
+
+                /**
+                 * @brief Check if the record holds a lease obtained from the given access point
+                 */
+				bool			matches(const uint8_t *bssid) const;
+
+				uint32_t		getIP(void) const;
+				uint32_t		getNetMask(void) const;
+				uint32_t		getGateway(void) const;
+
+			protected:
+
+				struct Data
+				{
+					uint8_t		version;
+					uint8_t		reserved;
+					uint8_t		bssid[6];
+					uint32_t	ip;
+					uint32_t	netMask;
+					uint32_t	gateway;
+				};
+
+				NVSBlobRecord<Data>	_record;
+		};
+	}
+}
+
+#endif
@@ -33,6 +33,7 @@ namespace
 	const char* INVALID_MESSAGE		= "{ \"error\": \"invalid message\"}\r\n";
 	const char* INVALID_COMMAND		= "{ \"error\": \"invalid command\"}\r\n";
     const char* SETCONFIG_ACK_MSG	= "{ \"cmd\":\"setconfig\",\"status\":1}\r\n";
+    const uint32_t CONFIG_PROBE_TIME	= 400;
 }
 
 namespace IDFix
@@ -54,16 +55,32 @@ namespace IDFix
 				return false;
 			}
 
-			int16_t	scanResult;
+			ProbeResult	probeResult = ProbeResult::Error;
+			bool		covered;
 
-			scanResult = scan(ssid);
-			if ( scanResult < 0 )
+			getScanResults().lock();
+
+			covered = getScanResults().covers(ssid);
+			if ( covered )
+			{
+				probeResult = getScanResults().count(ssid) > 0 ? ProbeResult::Found : ProbeResult::NotFound;
+			}
+
+			getScanResults().unlock();
+
+			if ( ! covered )
+			{
+				// we only need to know if anybody else advertises the SSID, a full scan would take seconds
+				probeResult = probeSSID(ssid, CONFIG_PROBE_TIME);
+			}
+
+			if ( probeResult == ProbeResult::Error )
 			{
 				ESP_LOGE(LOG_TAG, "Faild to scan for existing configuration network");
 				return false;
 			}
 
-			if ( scanResult > 0 )
+			if ( probeResult == ProbeResult::Found )
 			{
 				ESP_LOGE(LOG_TAG, "There's already a device in config mode!");
 				return false;
@@ -207,6 +224,22 @@ namespace IDFix
 			}
 		}
 
+		void WiFiManager::scanFinished(int16_t apCount)
+		{
+			if ( _managerEventHandler != nullptr )
+			{
+				_managerEventHandler->scanFinished(apCount);
+			}
+		}
+
+		void WiFiManager::reconnectFailed(DisconnectCategory lastCategory)
+		{
+			if ( _managerEventHandler != nullptr )
+			{
+				_managerEventHandler->reconnectFailed(lastCategory);
+			}
+		}
+
 		void WiFiManager::tlsNewConnection(TLSSocket_weakPtr tlsSocket)
 		{
 			ESP_LOGI(LOG_TAG, "New config device connected!");
@@ -222,6 +255,7 @@ namespace IDFix
 			{
 				_configState = ConfigurationState::Running;
 				_configSocket = tlsSocket;
+				_messageFramer.reset();
 				sharedSocket->setEventHandler(this);
 			}
 			else
@@ -235,14 +269,37 @@ namespace IDFix
 
 		void WiFiManager::socketBytesReceived(TLSSocket& tlsSocket, ByteArray &bytes)
 		{
-			ESP_LOGV(LOG_TAG, "socketBytesReceived: %s", reinterpret_cast<char*>( bytes.data() ) );
+			const uint8_t*	data = bytes.data();
+			size_t			remaining = bytes.size();
+
+			// TLS records neither have to carry a complete message nor a single one, so frame the messages by line
+			while ( remaining > 0 )
+			{
+				size_t consumed = _messageFramer.feed(data, remaining);
+
+				data += consumed;
+				remaining -= consumed;
+
+				char *message;
+
+				while ( _messageFramer.nextLine(message) )
+				{
+					handleMessage(tlsSocket, message);
+				}
+			}
+		}
+
+		void WiFiManager::handleMessage(TLSSocket &tlsSocket, const char *message)
+		{
+			ESP_LOGV(LOG_TAG, "handleMessage: %s", message );
 
-			cJSON *jsonMessage = cJSON_Parse( reinterpret_cast<char*>( bytes.data() ));
+			cJSON *jsonMessage = cJSON_Parse(message);
 
 			if ( jsonMessage == nullptr || ! cJSON_IsObject(jsonMessage) )
 			{
 				ESP_LOGE(LOG_TAG, "Invalid json message received");
                 tlsSocket.write(INVALID_MESSAGE);
+                cJSON_Delete(jsonMessage);
 				return;
 			}
 
@@ -264,6 +321,9 @@ namespace IDFix
 
 			// reset weak pointer to socket to release all memory
 			_configSocket.reset();
+
+			// a partial message is worthless without its connection
+			_messageFramer.reset();
 		}
 
 		void WiFiManager::handleJSONConfigMessage(cJSON *root)
@@ -23,6 +23,7 @@
 #include "TLSServerEventHandler.h"
 #include "TLSSocketEventHandler.h"
 #include "SimpleDNSResponder.h"
+#include "LineFramer.h"
 #include <string>
 #include <map>
 #include "auxiliary.h"
@@ -138,6 +139,22 @@ namespace IDFix
                  */
 				virtual void	accessPointStopped(void) override;
 
+				/**
+                 * @brief The WiFiManager acts as WiFiEventHandler for the WiFi base class.
+                 *
+                 * All WiFI events are catched by the WiFiManager and will be dispatched to the
+                 * according WiFiManagerEventHandler if appropriate.
+                 */
+				virtual void	scanFinished(int16_t apCount) override;
+
+				/**
+                 * @brief The WiFiManager acts as WiFiEventHandler for the WiFi base class.
+                 *
+                 * All WiFI events are catched by the WiFiManager and will be dispatched to the
+                 * according WiFiManagerEventHandler if appropriate.
+                 */
+				virtual void	reconnectFailed(DisconnectCategory lastCategory) override;
+
                 /**
                  * @brief Handle an incomming TLS connection from a configuration client
                  * @param socket the TLS client socket
@@ -157,6 +174,12 @@ namespace IDFix
                  */
 				virtual void	socketDisconnected(TLSSocket& tlsSocket) override;
 
+                /**
+                 * @brief Parse and handle a single message from a configuration client
+                 * @param tlsSocket the TLS client socket
+                 * @param message   the NUL-terminated message without its line end
+                 */
+				void			handleMessage(TLSSocket& tlsSocket, const char *message);
 
 				void			handleJSONConfigMessage(cJSON *root);
 				bool			sendConfigWelcomeMessage(void);
@@ -182,6 +205,7 @@ namespace IDFix
 				TLSServer*					_configurationServer = { nullptr };
 				SimpleDNSResponder*			_dnsResponder = { nullptr };
 				TLSSocket_weakPtr			_configSocket;
+				LineFramer					_messageFramer;
 
 				ConfigurationState			_configState = { ConfigurationState::Inactive };
 
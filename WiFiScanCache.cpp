@@ -0,0 +1,314 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WiFiScanCache.h"
+
+#include <algorithm>
+
+extern "C"
+{
+    #include <esp_log.h>
+    #include <esp_timer.h>
+    #include <string.h>
+}
+
+namespace
+{
+	const char* LOG_TAG = "IDFix::WiFiScanCache";
+
+	// heap order which keeps the weakest record on top, so it can be replaced by a stronger one
+	bool isStronger(const wifi_ap_record_t &left, const wifi_ap_record_t &right)
+	{
+		return left.rssi > right.rssi;
+	}
+}
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+		WiFiScanCache::WiFiScanCache()
+		{
+			_mutex = xSemaphoreCreateRecursiveMutex();
+
+			if ( _mutex == nullptr )
+			{
+				ESP_LOGE(LOG_TAG, "xSemaphoreCreateRecursiveMutex failed, the scan results are not protected");
+			}
+		}
+
+		WiFiScanCache::~WiFiScanCache()
+		{
+			if ( _mutex != nullptr )
+			{
+				vSemaphoreDelete(_mutex);
+			}
+		}
+
+		void WiFiScanCache::begin(const std::string &filterSSID)
+		{
+			_stagingTruncated = false;
+			_stagingCount = 0;
+
+			strncpy(_stagingFilterSSID, filterSSID.c_str(), sizeof(_stagingFilterSSID) - 1);
+			_stagingFilterSSID[sizeof(_stagingFilterSSID) - 1] = '\0';
+		}
+
+		bool WiFiScanCache::insert(const wifi_ap_record_t &record)
+		{
+			for ( size_t index = 0; index < _stagingCount; index++ )
+			{
+				if ( memcmp(_staging[index].bssid, record.bssid, sizeof(record.bssid)) == 0 )
+				{
+					if ( record.rssi > _staging[index].rssi )
+					{
+						_staging[index] = record;
+						std::make_heap(_staging.begin(), _staging.begin() + _stagingCount, isStronger);
+					}
+
+					return false;
+				}
+			}
+
+			if ( _stagingCount < CAPACITY )
+			{
+				_staging[_stagingCount++] = record;
+				std::push_heap(_staging.begin(), _staging.begin() + _stagingCount, isStronger);
+				return true;
+			}
+
+			// the weaker records are lost, the cache is not complete anymore
+			_stagingTruncated = true;
+
+			if ( record.rssi > _staging.front().rssi )
+			{
+				std::pop_heap(_staging.begin(), _staging.end(), isStronger);
+				_staging.back() = record;
+				std::push_heap(_staging.begin(), _staging.end(), isStronger);
+			}
+
+			return true;
+		}
+
+		void WiFiScanCache::commit()
+		{
+			// sort before publishing, readers never see the heap order
+			std::sort_heap(_staging.begin(), _staging.begin() + _stagingCount, isStronger);
+
+			lock();
+
+			std::copy(_staging.begin(), _staging.begin() + _stagingCount, _records.begin());
+			_count = _stagingCount;
+			_truncated = _stagingTruncated;
+			memcpy(_filterSSID, _stagingFilterSSID, sizeof(_filterSSID));
+			_timestamp = esp_timer_get_time();
+			_valid = true;
+
+			unlock();
+		}
+
+		void WiFiScanCache::markTruncated()
+		{
+			_stagingTruncated = true;
+		}
+
+		void WiFiScanCache::invalidate()
+		{
+			lock();
+
+			_count = 0;
+			_valid = false;
+
+			unlock();
+		}
+
+		void WiFiScanCache::lock() const
+		{
+			if ( _mutex != nullptr )
+			{
+				xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+			}
+		}
+
+		void WiFiScanCache::unlock() const
+		{
+			if ( _mutex != nullptr )
+			{
+				xSemaphoreGiveRecursive(_mutex);
+			}
+		}
+
+		void WiFiScanCache::setTimeToLive(uint32_t timeToLive)
+		{
+			lock();
+
+			_timeToLive = timeToLive;
+
+			unlock();
+		}
+
+		uint32_t WiFiScanCache::getTimeToLive() const
+		{
+			return _timeToLive;
+		}
+
+		bool WiFiScanCache::isFresh() const
+		{
+			lock();
+
+			bool fresh = _valid && _timeToLive != 0 && ( esp_timer_get_time() - _timestamp ) < static_cast<int64_t>(_timeToLive) * 1000;
+
+			unlock();
+
+			return fresh;
+		}
+
+		bool WiFiScanCache::covers(const std::string &ssid) const
+		{
+			lock();
+
+			// records were dropped, only a hit proves that the SSID was seen
+			bool covered = isFresh()
+				&& ( _filterSSID[0] == '\0' || ssid == _filterSSID )
+				&& ( ! _truncated || count(ssid) > 0 );
+
+			unlock();
+
+			return covered;
+		}
+
+		size_t WiFiScanCache::size() const
+		{
+			lock();
+
+			size_t count = _count;
+
+			unlock();
+
+			return count;
+		}
+
+		std::string WiFiScanCache::getSSID(size_t index) const
+		{
+			lock();
+
+			const char* ssid = reinterpret_cast<const char*>( _records[index].ssid );
+			std::string result( ssid, strnlen(ssid, sizeof(_records[index].ssid)) );
+
+			unlock();
+
+			return result;
+		}
+
+		const uint8_t *WiFiScanCache::getBSSID(size_t index) const
+		{
+			return _records[index].bssid;
+		}
+
+		uint8_t WiFiScanCache::getChannel(size_t index) const
+		{
+			lock();
+
+			uint8_t channel = _records[index].primary;
+
+			unlock();
+
+			return channel;
+		}
+
+		int8_t WiFiScanCache::getRSSI(size_t index) const
+		{
+			lock();
+
+			int8_t rssi = _records[index].rssi;
+
+			unlock();
+
+			return rssi;
+		}
+
+		wifi_auth_mode_t WiFiScanCache::getAuthMode(size_t index) const
+		{
+			lock();
+
+			wifi_auth_mode_t authMode = _records[index].authmode;
+
+			unlock();
+
+			return authMode;
+		}
+
+		uint16_t WiFiScanCache::count(const std::string &ssid) const
+		{
+			uint16_t matches = 0;
+
+			lock();
+
+			for ( size_t index = 0; index < _count; index++ )
+			{
+				if ( getSSID(index) == ssid )
+				{
+					matches++;
+				}
+			}
+
+			unlock();
+
+			return matches;
+		}
+
+		int WiFiScanCache::findStrongest(const std::string &ssid) const
+		{
+			int strongest = -1;
+
+			lock();
+
+			for ( size_t index = 0; index < _count; index++ )
+			{
+				if ( getSSID(index) != ssid )
+				{
+					continue;
+				}
+
+				if ( strongest < 0 || _records[index].rssi > _records[strongest].rssi )
+				{
+					strongest = static_cast<int>(index);
+				}
+			}
+
+			unlock();
+
+			return strongest;
+		}
+
+		bool WiFiScanCache::findStrongest(const std::string &ssid, wifi_ap_record_t &record) const
+		{
+			lock();
+
+			int strongest = findStrongest(ssid);
+
+			if ( strongest >= 0 )
+			{
+				record = _records[strongest];
+			}
+
+			unlock();
+
+			return strongest >= 0;
+		}
+	}
+}
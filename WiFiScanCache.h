@@ -0,0 +1,190 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIFISCANCACHE_H
+#define WIFISCANCACHE_H
+
+extern "C"
+{
+    #include <esp_wifi_types.h>
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/semphr.h>
+}
+
+#include <string>
+#include <array>
+
+namespace IDFix
+{
+	namespace WiFi
+	{
+        /**
+         * @brief The WiFiScanCache class keeps the access point records of the last scan
+         *
+         * The records are considered fresh for a configurable time to live, so subsequent
+         * operations can reuse them instead of sweeping all channels again.
+         *
+         * The cache never allocates: it keeps the CAPACITY strongest records of a scan in a
+         * fixed staging array which is organized as a min-heap while the records are collected.
+         * commit() sorts them and replaces the published records, so readers keep seeing the
+         * results of the previous scan until the next one finished.
+         *
+         * The collection runs on the task which scans, the published records may be read from
+         * any task. Every reading method locks the cache on its own, a caller which combines
+         * several calls, e.g. size() and getSSID(), holds lock() around them.
+         *
+         * It can only choose among the records it is given. With IDF 5.1 and later WiFi feeds all
+         * records of a scan, older drivers hand out a single chunk of CAPACITY records in their
+         * own order and free the rest, which the cache notes by markTruncated().
+         */
+		class WiFiScanCache
+		{
+			public:
+
+				static constexpr size_t	CAPACITY = 16;
+
+									WiFiScanCache();
+									~WiFiScanCache();
+
+									WiFiScanCache(const WiFiScanCache&) = delete;
+				WiFiScanCache&		operator=(const WiFiScanCache&) = delete;
+
+                /**
+                 * @brief Start collecting the records of a new scan, the published records stay until commit()
+                 *
+                 * @param filterSSID    the SSID the scan was restricted to or an empty string
+                 */
+				void				begin(const std::string &filterSSID);
+
+                /**
+                 * @brief Add a record of the running collection, only the strongest CAPACITY records are kept
+                 *
+                 * An access point which was already collected is not added twice, its record is only
+                 * replaced if the new one is stronger.
+                 *
+                 * @param record    the access point record reported by the driver
+                 *
+                 * @return \c false if the access point was already collected
+                 */
+				bool				insert(const wifi_ap_record_t &record);
+
+                /**
+                 * @brief Finish the collection, sort the records by descending RSSI and publish them
+                 */
+				void				commit(void);
+
+                /**
+                 * @brief Note that the scan saw more access points than could be collected
+                 */
+				void				markTruncated(void);
+
+                /**
+                 * @brief Drop all published records
+                 */
+				void				invalidate(void);
+
+                /**
+                 * @brief Keep the published records from being replaced across several calls
+                 *
+                 * The lock is recursive. Don't hold it while waiting for a scan, the scan publishes
+                 * its records with commit(), which waits for the lock.
+                 */
+				void				lock(void) const;
+				void				unlock(void) const;
+
+                /**
+                 * @brief Set the time the cached records are considered fresh
+                 *
+                 * @param timeToLive    the time to live in milliseconds, 0 disables the cache
+                 */
+				void				setTimeToLive(uint32_t timeToLive);
+				uint32_t			getTimeToLive(void) const;
+
+                /**
+                 * @brief Check if the cache holds results of a scan younger than the time to live
+                 */
+				bool				isFresh(void) const;
+
+                /**
+                 * @brief Check if the cache holds fresh results which are complete for the given SSID
+                 *
+                 * @param ssid  the SSID to look up
+                 *
+                 * @return \c true if the last scan was not restricted or restricted to the same SSID and,
+                 *         in case records were dropped because the scan saw more than CAPACITY access points,
+                 *         at least one record of the SSID was kept
+                 */
+				bool				covers(const std::string &ssid) const;
+
+                /**
+                 * @brief Get the number of cached records
+                 */
+				size_t				size(void) const;
+
+				std::string			getSSID(size_t index) const;
+
+                /**
+                 * @brief Get the BSSID of a cached record, it points into the records, so hold lock() while using it
+                 */
+				const uint8_t*		getBSSID(size_t index) const;
+
+				uint8_t				getChannel(size_t index) const;
+				int8_t				getRSSI(size_t index) const;
+				wifi_auth_mode_t	getAuthMode(size_t index) const;
+
+                /**
+                 * @brief Get the number of cached access points advertising the given SSID
+                 */
+				uint16_t			count(const std::string &ssid) const;
+
+                /**
+                 * @brief Find the strongest cached access point advertising the given SSID
+                 *
+                 * @return the index of the record or -1 if no record matches
+                 */
+				int					findStrongest(const std::string &ssid) const;
+
+                /**
+                 * @brief Copy the record of the strongest cached access point advertising the given SSID
+                 *
+                 * Unlike the index returned by findStrongest(ssid), the copy stays valid when the next
+                 * scan replaces the records.
+                 *
+                 * @return \c false if no record matches
+                 */
+				bool				findStrongest(const std::string &ssid, wifi_ap_record_t &record) const;
+
+			private:
+
+				std::array<wifi_ap_record_t, CAPACITY>	_staging;
+				size_t									_stagingCount = { 0 };
+				char									_stagingFilterSSID[sizeof(wifi_ap_record_t::ssid)] = {};
+				bool									_stagingTruncated = { false };	///< records were dropped during the collection
+
+				SemaphoreHandle_t						_mutex = { nullptr };
+				std::array<wifi_ap_record_t, CAPACITY>	_records;
+				size_t									_count = { 0 };
+				char									_filterSSID[sizeof(wifi_ap_record_t::ssid)] = {};
+				int64_t									_timestamp = { 0 };
+				uint32_t								_timeToLive = { 10000 };
+				bool									_valid = { false };
+				bool									_truncated = { false };
+		};
+	}
+}
+
+#endif
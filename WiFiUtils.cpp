@@ -17,57 +17,133 @@
 
 #include "WiFiUtils.h"
 
+#include <array>
+
 extern "C"
 {
 	#include "esp_wifi_types.h"
 	#include "esp_netif.h"
 }
 
+namespace
+{
+    using IDFix::WiFi::WiFiUtils;
+
+    constexpr std::array<const char*, WiFiUtils::WIFI_EVENT_COUNT> WIFI_EVENT_NAMES = []()
+    {
+        std::array<const char*, WiFiUtils::WIFI_EVENT_COUNT> names = {};
+
+        names[WIFI_EVENT_WIFI_READY]            = "WIFI_EVENT_WIFI_READY";
+        names[WIFI_EVENT_SCAN_DONE]             = "WIFI_EVENT_SCAN_DONE";
+        names[WIFI_EVENT_STA_START]             = "WIFI_EVENT_STA_START";
+        names[WIFI_EVENT_STA_STOP]              = "WIFI_EVENT_STA_STOP";
+        names[WIFI_EVENT_STA_CONNECTED]         = "WIFI_EVENT_STA_CONNECTED";
+        names[WIFI_EVENT_STA_DISCONNECTED]      = "WIFI_EVENT_STA_DISCONNECTED";
+        names[WIFI_EVENT_STA_AUTHMODE_CHANGE]   = "WIFI_EVENT_STA_AUTHMODE_CHANGE";
+        names[WIFI_EVENT_STA_WPS_ER_SUCCESS]    = "WIFI_EVENT_STA_WPS_ER_SUCCESS";
+        names[WIFI_EVENT_STA_WPS_ER_FAILED]     = "WIFI_EVENT_STA_WPS_ER_FAILED";
+        names[WIFI_EVENT_STA_WPS_ER_TIMEOUT]    = "WIFI_EVENT_STA_WPS_ER_TIMEOUT";
+        names[WIFI_EVENT_STA_WPS_ER_PIN]        = "WIFI_EVENT_STA_WPS_ER_PIN";
+        names[WIFI_EVENT_AP_START]              = "WIFI_EVENT_AP_START";
+        names[WIFI_EVENT_AP_STOP]               = "WIFI_EVENT_AP_STOP";
+        names[WIFI_EVENT_AP_STACONNECTED]       = "WIFI_EVENT_AP_STACONNECTED";
+        names[WIFI_EVENT_AP_STADISCONNECTED]    = "WIFI_EVENT_AP_STADISCONNECTED";
+        names[WIFI_EVENT_AP_PROBEREQRECVED]     = "WIFI_EVENT_AP_PROBEREQRECVED";
+        #ifdef CONFIG_IDF_TARGET_ESP32
+            names[WIFI_EVENT_STA_WPS_ER_PBC_OVERLAP]    = "WIFI_EVENT_STA_WPS_ER_PBC_OVERLAP";
+            names[WIFI_EVENT_MAX]                       = "WIFI_EVENT_MAX";
+        #endif
+
+        return names;
+    }();
+
+    constexpr std::array<const char*, WiFiUtils::IP_EVENT_COUNT> IP_EVENT_NAMES = []()
+    {
+        std::array<const char*, WiFiUtils::IP_EVENT_COUNT> names = {};
+
+        names[IP_EVENT_STA_GOT_IP]          = "IP_EVENT_STA_GOT_IP";
+        names[IP_EVENT_STA_LOST_IP]         = "IP_EVENT_STA_LOST_IP";
+        names[IP_EVENT_AP_STAIPASSIGNED]    = "IP_EVENT_AP_STAIPASSIGNED";
+        names[IP_EVENT_GOT_IP6]             = "IP_EVENT_GOT_IP6";
+        #ifdef CONFIG_IDF_TARGET_ESP32
+            names[IP_EVENT_ETH_GOT_IP]          = "IP_EVENT_ETH_GOT_IP";
+        #endif
+
+        return names;
+    }();
+}
+
 namespace IDFix
 {
 	namespace WiFi
 	{
         const char *WiFiUtils::wiFiEventTypeToString(int32_t eventType)
         {
-            switch (eventType)
+            if ( eventType < 0 || static_cast<size_t>(eventType) >= WIFI_EVENT_NAMES.size() || WIFI_EVENT_NAMES[eventType] == nullptr )
             {
-                case WIFI_EVENT_WIFI_READY:				return "WIFI_EVENT_WIFI_READY";
-                case WIFI_EVENT_SCAN_DONE:				return "WIFI_EVENT_SCAN_DONE";
-                case WIFI_EVENT_STA_START:				return "WIFI_EVENT_STA_START";
-                case WIFI_EVENT_STA_STOP:				return "WIFI_EVENT_STA_STOP";
-                case WIFI_EVENT_STA_CONNECTED:			return "WIFI_EVENT_STA_CONNECTED";
-                case WIFI_EVENT_STA_DISCONNECTED:		return "WIFI_EVENT_STA_DISCONNECTED";
-                case WIFI_EVENT_STA_AUTHMODE_CHANGE:	return "WIFI_EVENT_STA_AUTHMODE_CHANGE";
-                case WIFI_EVENT_STA_WPS_ER_SUCCESS:		return "WIFI_EVENT_STA_WPS_ER_SUCCESS";
-                case WIFI_EVENT_STA_WPS_ER_FAILED:		return "WIFI_EVENT_STA_WPS_ER_FAILED";
-                case WIFI_EVENT_STA_WPS_ER_TIMEOUT:		return "WIFI_EVENT_STA_WPS_ER_TIMEOUT";
-                case WIFI_EVENT_STA_WPS_ER_PIN:			return "WIFI_EVENT_STA_WPS_ER_PIN";
-                case WIFI_EVENT_AP_START:				return "WIFI_EVENT_AP_START";
-                case WIFI_EVENT_AP_STOP:				return "WIFI_EVENT_AP_STOP";
-                case WIFI_EVENT_AP_STACONNECTED:		return "WIFI_EVENT_AP_STACONNECTED";
-                case WIFI_EVENT_AP_STADISCONNECTED:		return "WIFI_EVENT_AP_STADISCONNECTED";
-                case WIFI_EVENT_AP_PROBEREQRECVED:		return "WIFI_EVENT_AP_PROBEREQRECVED";
-                #ifdef CONFIG_IDF_TARGET_ESP32
-                    case WIFI_EVENT_STA_WPS_ER_PBC_OVERLAP:	return "WIFI_EVENT_STA_WPS_ER_PBC_OVERLAP";
-                    case WIFI_EVENT_MAX:					return "WIFI_EVENT_MAX";
-                #endif
+                return "NULL";
             }
 
-            return "NULL";
+            return WIFI_EVENT_NAMES[eventType];
         }
 
-
 		const char *WiFiUtils::ipEventTypeToString(int32_t eventType)
 		{
-			switch (eventType)
+            if ( eventType < 0 || static_cast<size_t>(eventType) >= IP_EVENT_NAMES.size() || IP_EVENT_NAMES[eventType] == nullptr )
+            {
+                return "NULL";
+            }
+
+            return IP_EVENT_NAMES[eventType];
+		}
+
+		DisconnectCategory WiFiUtils::classifyDisconnectReason(uint8_t reason)
+		{
+			switch (reason)
 			{
-				case IP_EVENT_STA_GOT_IP:			return "IP_EVENT_STA_GOT_IP";
-				case IP_EVENT_STA_LOST_IP:			return "IP_EVENT_STA_LOST_IP";
-				case IP_EVENT_AP_STAIPASSIGNED:		return "IP_EVENT_AP_STAIPASSIGNED";
-				case IP_EVENT_GOT_IP6:				return "IP_EVENT_GOT_IP6";
+				case WIFI_REASON_AUTH_FAIL:
+				case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+				case WIFI_REASON_HANDSHAKE_TIMEOUT:
+				case WIFI_REASON_802_1X_AUTH_FAILED:
+					return DisconnectCategory::AuthFailure;
+
+				case WIFI_REASON_NO_AP_FOUND:
+					return DisconnectCategory::NetworkNotFound;
+
+				case WIFI_REASON_BEACON_TIMEOUT:
+				case WIFI_REASON_AUTH_EXPIRE:
+				case WIFI_REASON_AUTH_LEAVE:
+				case WIFI_REASON_ASSOC_EXPIRE:
+				case WIFI_REASON_NOT_AUTHED:
+				case WIFI_REASON_NOT_ASSOCED:
+				// TKIP countermeasures of the access point, the credentials were fine
+				case WIFI_REASON_MIC_FAILURE:
+					return DisconnectCategory::LinkLost;
+
+				case WIFI_REASON_ASSOC_TOOMANY:
+				case WIFI_REASON_ASSOC_FAIL:
                 #ifdef CONFIG_IDF_TARGET_ESP32
-                    case IP_EVENT_ETH_GOT_IP:			return "IP_EVENT_ETH_GOT_IP";
+                    case WIFI_REASON_CONNECTION_FAIL:
                 #endif
+					return DisconnectCategory::AssociationFailure;
+
+				case WIFI_REASON_ASSOC_LEAVE:
+					return DisconnectCategory::LocalRequest;
+			}
+
+			return DisconnectCategory::Other;
+		}
+
+		const char *WiFiUtils::disconnectCategoryToString(DisconnectCategory category)
+		{
+			switch (category)
+			{
+				case DisconnectCategory::AuthFailure:			return "AuthFailure";
+				case DisconnectCategory::NetworkNotFound:		return "NetworkNotFound";
+				case DisconnectCategory::LinkLost:				return "LinkLost";
+				case DisconnectCategory::AssociationFailure:	return "AssociationFailure";
+				case DisconnectCategory::LocalRequest:			return "LocalRequest";
+				case DisconnectCategory::Other:					return "Other";
 			}
 
 			return "NULL";
@@ -21,21 +21,55 @@
 extern "C"
 {
     #include "stdint.h"
+    #include "esp_wifi_types.h"
+    #include "esp_netif.h"
 }
 
+#include <cstddef>
+
 namespace IDFix
 {
     namespace WiFi
     {
         /**
-         * @brief The WiFiUtils class provides a debugging helper to convert WIFI event consts to a string representation
+         * @brief The DisconnectCategory enum groups the driver's disconnect reason codes by how to react on them
+         */
+        enum class DisconnectCategory
+        {
+            AuthFailure,            ///< the credentials were rejected, retrying won't help
+            NetworkNotFound,        ///< no access point with the SSID was found
+            LinkLost,               ///< an established link was lost, e.g. by a beacon timeout
+            AssociationFailure,     ///< the access point refused or failed the association
+            LocalRequest,           ///< the station itself left the network
+            Other
+        };
+
+        /**
+         * @brief The WiFiUtils class provides helpers to convert and classify WIFI event consts
          */
         class WiFiUtils
         {
             public:
 
+                /**
+                 * @brief Size of the tables indexed by WIFI_EVENT IDs
+                 */
+                #ifdef CONFIG_IDF_TARGET_ESP32
+                    static constexpr size_t WIFI_EVENT_COUNT = WIFI_EVENT_MAX + 1;
+                #else
+                    static constexpr size_t WIFI_EVENT_COUNT = WIFI_EVENT_AP_PROBEREQRECVED + 1;
+                #endif
+
+                /**
+                 * @brief Size of the tables indexed by IP_EVENT IDs, IP_EVENT has no terminating _MAX ID
+                 */
+                static constexpr size_t IP_EVENT_COUNT = 16;
+
                 static const char* wiFiEventTypeToString(int32_t eventType);
                 static const char* ipEventTypeToString(int32_t eventType);
+
+                static DisconnectCategory   classifyDisconnectReason(uint8_t reason);
+                static const char*          disconnectCategoryToString(DisconnectCategory category);
         };
     }
 }
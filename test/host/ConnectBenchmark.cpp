@@ -0,0 +1,279 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "HeapTracker.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+/*
+ * Every scenario connects RUNS times with randomized timings of the simulated network. The time-to-IP
+ * is simulated time, so the results are deterministic and the budgets catch regressions of the connect
+ * logic, not of the host running the tests.
+ *
+ * The heap peak is measured by counting the real allocations of the run above the allocations at its start,
+ * including the bookkeeping of the fake IDF. The driver's own buffers are not simulated.
+ */
+
+namespace
+{
+	const uint32_t	RUNS = 500;
+
+	struct ScenarioResult
+	{
+		std::vector<uint32_t>	times;			///< ms from the start of a run until networkConnected() or the reported failure
+		uint32_t				maxEvents = { 0 };
+		size_t					peakHeap = { 0 };		///< bytes
+	};
+
+	size_t	runHeapBaseline = 0;
+
+	uint32_t percentile(std::vector<uint32_t> times, uint8_t percent)
+	{
+		std::sort(times.begin(), times.end());
+
+		return times[( times.size() - 1 ) * percent / 100];
+	}
+
+	void report(const char *scenario, const ScenarioResult &result)
+	{
+		printf("%-18s p50 %5u ms, p99 %5u ms, max %3u events, heap peak %6zu bytes\n", scenario, percentile(result.times, 50), percentile(result.times, 99), result.maxEvents, result.peakHeap);
+	}
+
+	void recordRun(ScenarioResult &result, uint64_t start)
+	{
+		// before the vector of the results grows
+		result.peakHeap = std::max(result.peakHeap, HeapTracker::peak() - runHeapBaseline);
+		result.maxEvents = std::max<uint32_t>(result.maxEvents, FakeIDF::counters().eventsPosted);
+		result.times.push_back( static_cast<uint32_t>( FakeIDF::now() - start ) );
+	}
+
+	FakeIDF::AccessPoint homeNetwork(std::mt19937 &random)
+	{
+		FakeIDF::AccessPoint accessPoint;
+
+		accessPoint.ssid = "home";
+		accessPoint.password = "secret123";
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x06 };
+		accessPoint.channel = static_cast<uint8_t>( 1 + random() % 13 );
+		accessPoint.rssi = static_cast<int8_t>( -40 - random() % 40 );
+		accessPoint.associationTime = 20 + random() % 60;
+		accessPoint.dhcpTime = 50 + random() % 250;
+
+		return accessPoint;
+	}
+
+	// a fresh device for every run
+	template<typename Scenario>
+	void runScenario(Scenario scenario)
+	{
+		for ( uint32_t run = 0; run < RUNS; run++ )
+		{
+			std::mt19937	random(run);
+
+			FakeIDF::reset();
+			FakeIDF::setRandomSeed(run);
+
+			runHeapBaseline = HeapTracker::current();
+			HeapTracker::resetPeak();
+
+			scenario(random);
+		}
+	}
+}
+
+HOST_TEST(cleanAccessPoint)
+{
+	ScenarioResult result;
+
+	runScenario([&](std::mt19937 &random)
+	{
+		RecordingEventHandler	handler;
+		WiFi					wifi(&handler);
+
+		FakeIDF::addAccessPoint( homeNetwork(random) );
+
+		uint64_t start = FakeIDF::now();
+
+		CHECK( wifi.init() );
+		CHECK( wifi.connectWPA("home", "secret123") );
+		CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 30000) );
+
+		recordRun(result, start);
+	});
+
+	report("clean AP", result);
+
+	CHECK( percentile(result.times, 50) <= 1800 );
+	CHECK( percentile(result.times, 99) <= 2000 );
+	CHECK( result.maxEvents <= 3 );
+	CHECK( result.peakHeap <= 1024 );
+}
+
+HOST_TEST(denseScan)
+{
+	ScenarioResult result;
+
+	runScenario([&](std::mt19937 &random)
+	{
+		RecordingEventHandler	handler;
+		WiFi					wifi(&handler);
+		FakeIDF::AccessPoint	neighbour;
+
+		// 40 neighbours on all channels, some answer probes slowly
+		for ( uint8_t index = 0; index < 40; index++ )
+		{
+			neighbour.ssid = "neighbour" + std::to_string(index);
+			neighbour.bssid = { 0x02, 0x00, 0x00, 0x00, 0x01, index };
+			neighbour.channel = static_cast<uint8_t>( 1 + random() % 13 );
+			neighbour.rssi = static_cast<int8_t>( -30 - random() % 60 );
+			neighbour.probeResponseTime = 5 + random() % 100;
+			FakeIDF::addAccessPoint(neighbour);
+		}
+
+		FakeIDF::addAccessPoint( homeNetwork(random) );
+
+		uint64_t start = FakeIDF::now();
+
+		CHECK( wifi.init() );
+		CHECK( wifi.scanAndConnect("home", "secret123") );
+		CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 30000) );
+
+		recordRun(result, start);
+	});
+
+	report("dense scan", result);
+
+	CHECK( percentile(result.times, 50) <= 2200 );
+	CHECK( percentile(result.times, 99) <= 2400 );
+	CHECK( result.maxEvents <= 6 );
+	CHECK( result.peakHeap <= 16384 );
+}
+
+HOST_TEST(wrongCredentials)
+{
+	ScenarioResult result;
+
+	runScenario([&](std::mt19937 &random)
+	{
+		RecordingEventHandler	handler;
+		WiFi					wifi(&handler);
+		ReconnectPolicy			policy;
+
+		policy.enabled = true;
+		FakeIDF::addAccessPoint( homeNetwork(random) );
+
+		uint64_t start = FakeIDF::now();
+
+		CHECK( wifi.init() );
+		CHECK( wifi.setReconnectPolicy(policy) );
+		CHECK( wifi.connectWPA("home", "wrong") );
+
+		// the handler has to learn quickly that retrying won't help
+		CHECK( FakeIDF::runUntil([&]() { return handler.reconnectsFailed > 0; }, 30000) );
+		CHECK( handler.lastCategory == DisconnectCategory::AuthFailure );
+
+		recordRun(result, start);
+	});
+
+	report("wrong credentials", result);
+
+	CHECK( percentile(result.times, 50) <= 2200 );
+	CHECK( percentile(result.times, 99) <= 2300 );
+	CHECK( result.maxEvents <= 3 );
+	CHECK( result.peakHeap <= 1024 );
+}
+
+HOST_TEST(flappingAccessPoint)
+{
+	ScenarioResult result;
+
+	runScenario([&](std::mt19937 &random)
+	{
+		RecordingEventHandler	handler;
+		WiFi					wifi(&handler);
+		ReconnectPolicy			policy;
+
+		policy.enabled = true;
+		FakeIDF::addAccessPoint( homeNetwork(random) );
+
+		CHECK( wifi.init() );
+		CHECK( wifi.setReconnectPolicy(policy) );
+		CHECK( wifi.connectWPA("home", "secret123") );
+		CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 30000) );
+
+		// the link drops a few times, measure until the IP is back
+		for ( int drop = 1; drop <= 3; drop++ )
+		{
+			FakeIDF::runFor( 1000 + random() % 5000 );
+			FakeIDF::resetCounters();
+
+			uint64_t start = FakeIDF::now();
+
+			FakeIDF::dropLink();
+			CHECK( FakeIDF::runUntil([&]() { return handler.connected > drop; }, 30000) );
+
+			recordRun(result, start);
+		}
+	});
+
+	report("flapping AP", result);
+
+	CHECK( percentile(result.times, 50) <= 1900 );
+	CHECK( percentile(result.times, 99) <= 2100 );
+	CHECK( result.maxEvents <= 3 );
+	CHECK( result.peakHeap <= 12288 );
+}
+
+HOST_TEST(slowDHCPServer)
+{
+	ScenarioResult result;
+
+	runScenario([&](std::mt19937 &random)
+	{
+		RecordingEventHandler	handler;
+		WiFi					wifi(&handler);
+		FakeIDF::AccessPoint	accessPoint = homeNetwork(random);
+
+		accessPoint.dhcpTime = 2000 + random() % 3000;
+		FakeIDF::addAccessPoint(accessPoint);
+
+		uint64_t start = FakeIDF::now();
+
+		CHECK( wifi.init() );
+		CHECK( wifi.connectWPA("home", "secret123") );
+		CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 30000) );
+
+		recordRun(result, start);
+	});
+
+	report("slow DHCP", result);
+
+	CHECK( percentile(result.times, 50) <= 5500 );
+	CHECK( percentile(result.times, 99) <= 7000 );
+	CHECK( result.maxEvents <= 3 );
+	CHECK( result.peakHeap <= 1024 );
+}
@@ -0,0 +1,216 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	FakeIDF::AccessPoint homeNetwork(uint8_t channel = 6, int8_t rssi = -55)
+	{
+		FakeIDF::AccessPoint accessPoint;
+
+		accessPoint.ssid = "home";
+		accessPoint.password = "secret123";
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, channel };
+		accessPoint.channel = channel;
+		accessPoint.rssi = rssi;
+
+		return accessPoint;
+	}
+}
+
+HOST_TEST(connectsToAccessPoint)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	size_t accessPoint = FakeIDF::addAccessPoint( homeNetwork() );
+
+	CHECK( wifi.init() );
+	CHECK( wifi.connectWPA("home", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+
+	CHECK( FakeIDF::isConnected() );
+	CHECK_EQUAL( 1, handler.connected.load() );
+	CHECK_EQUAL( 0, handler.disconnected.load() );
+	CHECK_EQUAL( FakeIDF::ipAddress(10, 0, accessPoint + 1, 100), handler.lastIPInfo.ip.addr );
+	CHECK_EQUAL( FakeIDF::accessPoint(accessPoint).rssi, wifi.getRSSILevel() );
+}
+
+HOST_TEST(wrongPasswordGivesUp)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	ReconnectPolicy			policy;
+
+	FakeIDF::addAccessPoint( homeNetwork() );
+	policy.enabled = true;
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setReconnectPolicy(policy) );
+	CHECK( wifi.connectWPA("home", "wrong") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.reconnectsFailed > 0; }, 10000) );
+
+	CHECK_EQUAL( 0, handler.connected.load() );
+	CHECK( handler.lastCategory == DisconnectCategory::AuthFailure );
+	CHECK_EQUAL( WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT, wifi.getLastDisconnectReason() );
+	CHECK_EQUAL( 1u, FakeIDF::counters().connect );
+}
+
+HOST_TEST(missingNetworkIsRetried)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	ReconnectPolicy			policy;
+
+	policy.enabled = true;
+	policy.maxAttempts = 3;
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setReconnectPolicy(policy) );
+	CHECK( wifi.connectWPA("home", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.reconnectsFailed > 0; }, 60000) );
+
+	CHECK( handler.lastCategory == DisconnectCategory::NetworkNotFound );
+	CHECK_EQUAL( 4u, FakeIDF::counters().connect );
+	CHECK_EQUAL( 4, handler.disconnected.load() );
+}
+
+HOST_TEST(reconnectsAfterLostLink)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	ReconnectPolicy			policy;
+
+	FakeIDF::addAccessPoint( homeNetwork() );
+	policy.enabled = true;
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setReconnectPolicy(policy) );
+	CHECK( wifi.connectWPA("home", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+
+	FakeIDF::dropLink();
+
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 1; }, 5000) );
+	CHECK_EQUAL( 1, handler.disconnected.load() );
+	CHECK_EQUAL( WIFI_REASON_BEACON_TIMEOUT, wifi.getLastDisconnectReason() );
+}
+
+HOST_TEST(reconnectsAfterMICFailure)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	ReconnectPolicy			policy;
+
+	FakeIDF::addAccessPoint( homeNetwork() );
+	policy.enabled = true;
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setReconnectPolicy(policy) );
+	CHECK( wifi.connectWPA("home", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+
+	// a MIC failure does not mean the password is wrong, so the station must not give up
+	FakeIDF::dropLink(WIFI_REASON_MIC_FAILURE);
+
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 1; }, 5000) );
+	CHECK( WiFiUtils::classifyDisconnectReason(WIFI_REASON_MIC_FAILURE) == DisconnectCategory::LinkLost );
+	CHECK_EQUAL( 0, handler.reconnectsFailed.load() );
+	CHECK_EQUAL( WIFI_REASON_MIC_FAILURE, wifi.getLastDisconnectReason() );
+}
+
+HOST_TEST(connectAfterScanStartsDriverAgain)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	FakeIDF::addAccessPoint( homeNetwork() );
+
+	CHECK( wifi.init() );
+	CHECK_EQUAL( 1, wifi.scan() );
+
+	// the scan released the radio, so the driver was stopped
+	FakeIDF::runFor(1000);
+	CHECK_EQUAL( WIFI_MODE_NULL, wifi.getRadioModeManager().getMode() );
+	CHECK_EQUAL( 1u, FakeIDF::counters().stop );
+
+	CHECK( wifi.connectWPA("home", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+
+	CHECK_EQUAL( 2u, FakeIDF::counters().start );
+	CHECK_EQUAL( 1u, wifi.getConnectionTimeline().getHistogram(WiFiConnectionTimeline::PhaseDriverStart).count );
+}
+
+HOST_TEST(scanReportsVisibleAccessPoints)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	FakeIDF::addAccessPoint( homeNetwork(1, -70) );
+	FakeIDF::addAccessPoint( homeNetwork(6, -50) );
+
+	FakeIDF::AccessPoint slow = homeNetwork(11);
+	slow.probeResponseTime = FakeIDF::NEVER;
+	FakeIDF::addAccessPoint(slow);
+
+	CHECK( wifi.init() );
+	CHECK_EQUAL( 2, wifi.scan() );
+	CHECK_EQUAL( 2u, wifi.getScanResults().size() );
+	CHECK_EQUAL( 6, wifi.getScanResults().getChannel(0) );
+
+	// the scan released the radio again
+	CHECK_EQUAL( WIFI_MODE_NULL, wifi.getRadioModeManager().getMode() );
+}
+
+HOST_TEST(scanAsyncReportsToHandler)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	FakeIDF::addAccessPoint( homeNetwork(1, -70) );
+	FakeIDF::addAccessPoint( homeNetwork(6, -50) );
+
+	CHECK( wifi.init() );
+	CHECK( wifi.scanAsync() );
+	CHECK( ! wifi.scanAsync() );
+	CHECK( FakeIDF::runUntil([&]() { return handler.scansFinished > 0; }, 5000) );
+	CHECK_EQUAL( 2, handler.lastAPCount );
+
+	// the scan released the radio again
+	CHECK_EQUAL( WIFI_MODE_NULL, wifi.getRadioModeManager().getMode() );
+}
+
+HOST_TEST(scanAndConnectJoinsStrongestAccessPoint)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	FakeIDF::addAccessPoint( homeNetwork(1, -70) );
+	size_t strongest = FakeIDF::addAccessPoint( homeNetwork(11, -45) );
+
+	CHECK( wifi.init() );
+	CHECK( wifi.scanAndConnect("home", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+	CHECK_EQUAL( FakeIDF::ipAddress(10, 0, strongest + 1, 100), handler.lastIPInfo.ip.addr );
+}
@@ -0,0 +1,269 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+#include "WiFiEventDispatcher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	const std::chrono::microseconds	HANDLER_TIME(1000);
+	const size_t					POSTS = 200;
+
+	class SlowEventHandler : public RecordingEventHandler
+	{
+		public:
+
+			void networkDisconnected() override
+			{
+				std::this_thread::sleep_for(HANDLER_TIME);
+				RecordingEventHandler::networkDisconnected();
+			}
+	};
+
+	/**
+	 * @brief Adds another handler from a second thread while it is notified
+	 */
+	class RegisteringEventHandler : public RecordingEventHandler
+	{
+		public:
+
+			explicit RegisteringEventHandler(WiFiEventHandlerRegistry &registry) : _registry(registry) {}
+
+			void networkDisconnected() override
+			{
+				result = std::async(std::launch::async, [this]() { return _registry.addHandler(&other); });
+
+				// the registry is locked while the handlers run if this times out
+				added = result.wait_for( std::chrono::seconds(1) ) == std::future_status::ready && result.get();
+				RecordingEventHandler::networkDisconnected();
+			}
+
+			RecordingEventHandler	other;
+			std::future<bool>		result;
+			bool					added = { false };
+
+		private:
+
+			WiFiEventHandlerRegistry&	_registry;
+	};
+
+	/**
+	 * @brief Stays in its callback until released
+	 */
+	class BlockingEventHandler : public RecordingEventHandler
+	{
+		public:
+
+			void networkDisconnected() override
+			{
+				entered = true;
+
+				while ( ! released )
+				{
+					std::this_thread::sleep_for( std::chrono::milliseconds(1) );
+				}
+
+				RecordingEventHandler::networkDisconnected();
+				left = true;
+			}
+
+			std::atomic<bool>	entered = { false };
+			std::atomic<bool>	released = { false };
+			std::atomic<bool>	left = { false };
+	};
+
+	bool waitFor(const std::function<bool()> &condition)
+	{
+		for ( int attempt = 0; attempt < 5000; attempt++ )
+		{
+			if ( condition() )
+			{
+				return true;
+			}
+
+			std::this_thread::sleep_for( std::chrono::milliseconds(1) );
+		}
+
+		return condition();
+	}
+}
+
+HOST_TEST(failedStartFallsBackToDirectDelivery)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	FakeIDF::AccessPoint accessPoint;
+	accessPoint.ssid = "home";
+	FakeIDF::addAccessPoint(accessPoint);
+
+	FakeIDF::setTaskCreateFailure(true);
+
+	CHECK( wifi.init() );
+	CHECK( ! wifi.enableEventDispatcher() );
+	CHECK( wifi.connectWPA("home", "") );
+
+	// the handler is notified on the event loop, nothing is queued for a task which does not exist
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+
+	FakeIDF::setTaskCreateFailure(false);
+	CHECK( wifi.enableEventDispatcher() );
+}
+
+HOST_TEST(postWithoutTaskIsRejected)
+{
+	WiFiEventHandlerRegistry	registry;
+	WiFiEventDispatcher			dispatcher(&registry);
+	HandlerNotification			notification;
+
+	notification.type = HandlerNotification::Type::NetworkDisconnected;
+
+	CHECK( ! dispatcher.post(notification) );
+	CHECK_EQUAL( 1u, dispatcher.getDroppedCount() );
+}
+
+HOST_TEST(enqueueLatencyDoesNotDependOnHandler)
+{
+	// the task outlives the test, so neither the dispatcher nor the handler may go out of scope
+	static SlowEventHandler				handler;
+	static WiFiEventHandlerRegistry		registry;
+	static WiFiEventDispatcher			dispatcher(&registry);
+
+	std::vector<std::chrono::nanoseconds>	latencies;
+	HandlerNotification						notification;
+
+	notification.type = HandlerNotification::Type::NetworkDisconnected;
+
+	CHECK( registry.addHandler(&handler) );
+	CHECK( dispatcher.start(4096, 5) );
+
+	for ( size_t index = 0; index < POSTS; index++ )
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		dispatcher.post(notification);
+		latencies.push_back( std::chrono::steady_clock::now() - start );
+
+		// post a little faster than the handler consumes, so the queue runs full now and then
+		std::this_thread::sleep_for(HANDLER_TIME / 2);
+	}
+
+	CHECK( waitFor([&]() { return handler.disconnected + dispatcher.getDroppedCount() == POSTS; }) );
+
+	std::sort(latencies.begin(), latencies.end());
+
+	auto median = std::chrono::duration_cast<std::chrono::microseconds>( latencies[POSTS / 2] );
+	auto p99 = std::chrono::duration_cast<std::chrono::microseconds>( latencies[POSTS * 99 / 100] );
+
+	printf("post latency: median %lld us, p99 %lld us, %u of %zu dropped\n", static_cast<long long>(median.count()), static_cast<long long>(p99.count()), dispatcher.getDroppedCount(), POSTS);
+
+	// the event loop must never wait for a handler
+	CHECK( p99 < HANDLER_TIME / 2 );
+	CHECK( handler.disconnected > 0 );
+}
+
+HOST_TEST(handlersRunWithoutRegistryLock)
+{
+	WiFiEventHandlerRegistry	registry;
+	RegisteringEventHandler		handler(registry);
+	HandlerNotification			notification;
+
+	notification.type = HandlerNotification::Type::NetworkDisconnected;
+
+	CHECK( registry.addHandler(&handler) );
+	registry.deliver(notification);
+
+	CHECK( handler.added );
+	CHECK_EQUAL( 1, handler.disconnected.load() );
+
+	// the handler added during the delivery gets the next notification
+	registry.deliver(notification);
+	CHECK_EQUAL( 1, handler.other.disconnected.load() );
+}
+
+HOST_TEST(removeWaitsForRunningCall)
+{
+	struct Removal
+	{
+		WiFiEventHandlerRegistry	registry;
+		BlockingEventHandler		handler;
+		std::atomic<bool>			removed = { false };
+		std::atomic<bool>			callLeftBeforeRemoval = { false };
+	};
+
+	// the task outlives the test if it fails, so the state may not go out of scope
+	static Removal removal;
+
+	HandlerNotification notification;
+	notification.type = HandlerNotification::Type::NetworkDisconnected;
+
+	CHECK( removal.registry.addHandler(&removal.handler) );
+
+	std::thread delivery([&]() { removal.registry.deliver(notification); });
+	CHECK( waitFor([&]() { return removal.handler.entered.load(); }) );
+
+	// removing from another task must wait until the handler returned
+	xTaskCreate([](void *parameter)
+	{
+		Removal *state = static_cast<Removal*>(parameter);
+
+		state->registry.removeHandler(&state->handler);
+		state->callLeftBeforeRemoval = state->handler.left.load();
+		state->removed = true;
+	}, "remove", 4096, &removal, 5, nullptr);
+
+	std::this_thread::sleep_for( std::chrono::milliseconds(20) );
+	CHECK( ! removal.removed );
+
+	removal.handler.released = true;
+	delivery.join();
+
+	CHECK( waitFor([&]() { return removal.removed.load(); }) );
+	CHECK( removal.callLeftBeforeRemoval );
+}
+
+HOST_TEST(registryWithoutMutexRejectsHandlers)
+{
+	FakeIDF::setSemaphoreCreateFailure(true);
+
+	WiFiEventHandlerRegistry	registry;
+	RecordingEventHandler		handler;
+	HandlerNotification			notification;
+
+	FakeIDF::setSemaphoreCreateFailure(false);
+
+	notification.type = HandlerNotification::Type::NetworkDisconnected;
+
+	// the kernel would assert on the missing mutex
+	CHECK( ! registry.addHandler(&handler) );
+	CHECK( ! registry.removeHandler(&handler) );
+	registry.deliver(notification);
+	CHECK_EQUAL( 0, handler.disconnected.load() );
+}
@@ -0,0 +1,145 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+
+using namespace IDFix::WiFi;
+
+HOST_TEST(defaultTuningKeepsDriverDefaults)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	wifi_init_config_t		defaults = WIFI_INIT_CONFIG_DEFAULT();
+
+	CHECK( wifi.init() );
+
+	const wifi_init_config_t &config = FakeIDF::lastInitConfig();
+
+	CHECK_EQUAL( defaults.static_rx_buf_num, config.static_rx_buf_num );
+	CHECK_EQUAL( defaults.dynamic_rx_buf_num, config.dynamic_rx_buf_num );
+	CHECK_EQUAL( defaults.dynamic_tx_buf_num, config.dynamic_tx_buf_num );
+	CHECK_EQUAL( defaults.ampdu_rx_enable, config.ampdu_rx_enable );
+	CHECK_EQUAL( defaults.ampdu_tx_enable, config.ampdu_tx_enable );
+	CHECK_EQUAL( defaults.rx_ba_win, config.rx_ba_win );
+	CHECK_EQUAL( defaults.magic, config.magic );
+}
+
+HOST_TEST(throughputTuningIsMapped)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	CHECK( wifi.init(DriverTuning::throughput()) );
+
+	const wifi_init_config_t &config = FakeIDF::lastInitConfig();
+
+	CHECK_EQUAL( 16, config.static_rx_buf_num );
+	CHECK_EQUAL( 64, config.dynamic_rx_buf_num );
+	CHECK_EQUAL( 64, config.dynamic_tx_buf_num );
+	CHECK_EQUAL( 1, config.ampdu_rx_enable );
+	CHECK_EQUAL( 1, config.ampdu_tx_enable );
+	CHECK_EQUAL( 16, config.rx_ba_win );
+}
+
+HOST_TEST(minRAMTuningIsMapped)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	wifi_init_config_t		defaults = WIFI_INIT_CONFIG_DEFAULT();
+
+	CHECK( wifi.init(DriverTuning::minRAM()) );
+
+	const wifi_init_config_t &config = FakeIDF::lastInitConfig();
+
+	CHECK_EQUAL( 4, config.static_rx_buf_num );
+	CHECK_EQUAL( 8, config.dynamic_rx_buf_num );
+	CHECK_EQUAL( 8, config.dynamic_tx_buf_num );
+	CHECK_EQUAL( 0, config.ampdu_rx_enable );
+	CHECK_EQUAL( 0, config.ampdu_tx_enable );
+
+	// the default block ack window of 6 does not fit into 4 static buffers
+	CHECK( defaults.rx_ba_win > 4 );
+	CHECK_EQUAL( 4, config.rx_ba_win );
+}
+
+HOST_TEST(blockAckWindowIsClampedToStaticBuffers)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	DriverTuning			tuning;
+
+	tuning.staticRxBuffers = 8;
+	tuning.rxBAWindow = 32;
+
+	CHECK( wifi.init(tuning) );
+
+	const wifi_init_config_t &config = FakeIDF::lastInitConfig();
+
+	CHECK_EQUAL( 8, config.static_rx_buf_num );
+	CHECK_EQUAL( 8, config.rx_ba_win );
+}
+
+HOST_TEST(partialTuningKeepsOtherDefaults)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	DriverTuning			tuning;
+	wifi_init_config_t		defaults = WIFI_INIT_CONFIG_DEFAULT();
+
+	tuning.dynamicTxBuffers = 16;
+	tuning.ampduTx = 0;
+
+	CHECK( wifi.init(tuning) );
+
+	const wifi_init_config_t &config = FakeIDF::lastInitConfig();
+
+	CHECK_EQUAL( 16, config.dynamic_tx_buf_num );
+	CHECK_EQUAL( 0, config.ampdu_tx_enable );
+	CHECK_EQUAL( defaults.static_rx_buf_num, config.static_rx_buf_num );
+	CHECK_EQUAL( defaults.dynamic_rx_buf_num, config.dynamic_rx_buf_num );
+	CHECK_EQUAL( defaults.ampdu_rx_enable, config.ampdu_rx_enable );
+	CHECK_EQUAL( defaults.rx_ba_win, config.rx_ba_win );
+}
+
+HOST_TEST(driverHeapUsageIsMeasured)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	CHECK_EQUAL( 0u, wifi.getDriverHeapUsage() );
+
+	FakeIDF::setDriverHeap(42000);
+
+	CHECK( wifi.init() );
+	CHECK_EQUAL( 42000u, wifi.getDriverHeapUsage() );
+}
+
+HOST_TEST(driverHeapUsageDoesNotWrap)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	// another task released memory while the driver was initialized
+	FakeIDF::setDriverHeap(-1000);
+
+	CHECK( wifi.init() );
+	CHECK_EQUAL( 0u, wifi.getDriverHeapUsage() );
+}
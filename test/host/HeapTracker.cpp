@@ -0,0 +1,147 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HeapTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	// keeps the size in front of every block, aligned for any type
+	const size_t	HEADER_SIZE = alignof(std::max_align_t);
+
+	std::atomic<size_t>	allocated = { 0 };
+	std::atomic<size_t>	peakAllocated = { 0 };
+
+	void* allocate(size_t size)
+	{
+		unsigned char* block = static_cast<unsigned char*>( malloc(size + HEADER_SIZE) );
+
+		if ( block == nullptr )
+		{
+			throw std::bad_alloc();
+		}
+
+		*reinterpret_cast<size_t*>(block) = size;
+
+		size_t now = allocated.fetch_add(size) + size;
+		size_t peak = peakAllocated.load();
+
+		while ( now > peak && ! peakAllocated.compare_exchange_weak(peak, now) )
+		{
+		}
+
+		return block + HEADER_SIZE;
+	}
+
+	void release(void* pointer)
+	{
+		if ( pointer == nullptr )
+		{
+			return;
+		}
+
+		unsigned char* block = static_cast<unsigned char*>(pointer) - HEADER_SIZE;
+
+		allocated.fetch_sub( *reinterpret_cast<size_t*>(block) );
+		free(block);
+	}
+}
+
+namespace HeapTracker
+{
+	size_t current()
+	{
+		return allocated.load();
+	}
+
+	size_t peak()
+	{
+		return peakAllocated.load();
+	}
+
+	void resetPeak()
+	{
+		peakAllocated.store( allocated.load() );
+	}
+}
+
+void* operator new(size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	release(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	release(pointer);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return allocate(size);
+	}
+	catch ( const std::bad_alloc& )
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return allocate(size);
+	}
+	catch ( const std::bad_alloc& )
+	{
+		return nullptr;
+	}
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	release(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	release(pointer);
+}
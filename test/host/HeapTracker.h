@@ -0,0 +1,47 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HEAPTRACKER_H
+#define HEAPTRACKER_H
+
+#include <cstddef>
+
+/**
+ * @brief Counts the heap allocated through operator new in the test binary
+ *
+ * Only tests which link HeapTracker.cpp replace the global operator new and delete, see
+ * add_host_test() in CMakeLists.txt. The counts cover the whole process, i.e. the fake IDF as well.
+ */
+namespace HeapTracker
+{
+	/**
+	 * @brief Get the bytes currently allocated
+	 */
+	size_t		current(void);
+
+	/**
+	 * @brief Get the most bytes allocated at once since the last resetPeak()
+	 */
+	size_t		peak(void);
+
+	/**
+	 * @brief Start a new measurement of the peak from the current allocation
+	 */
+	void		resetPeak(void);
+}
+
+#endif
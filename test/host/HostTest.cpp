@@ -0,0 +1,77 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+
+#include <cstring>
+
+namespace
+{
+	int		failures = 0;
+}
+
+namespace HostTest
+{
+	std::vector<TestCase>& testCases()
+	{
+		static std::vector<TestCase> cases;
+		return cases;
+	}
+
+	bool registerTest(const char *name, std::function<void()> function)
+	{
+		testCases().push_back( TestCase{ name, std::move(function) } );
+		return true;
+	}
+
+	void fail(const char *file, int line, const char *expression)
+	{
+		fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", file, line, expression);
+		failures++;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int failedTests = 0;
+
+	for ( const HostTest::TestCase &testCase : HostTest::testCases() )
+	{
+		// an optional argument selects the tests by name
+		if ( argc > 1 && strstr(testCase.name, argv[1]) == nullptr )
+		{
+			continue;
+		}
+
+		int previousFailures = failures;
+
+		FakeIDF::reset();
+		testCase.function();
+
+		bool passed = failures == previousFailures;
+
+		printf("%s %s\n", passed ? "[ OK ]" : "[FAIL]", testCase.name);
+
+		if ( ! passed )
+		{
+			failedTests++;
+		}
+	}
+
+	return failedTests == 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOSTTEST_H
+#define HOSTTEST_H
+
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief A minimal test runner for the host tests
+ *
+ * Each HOST_TEST() is run on a freshly reset FakeIDF. A failed CHECK() reports the location and
+ * fails the test, but the test goes on, so one run shows all broken expectations.
+ */
+namespace HostTest
+{
+	struct TestCase
+	{
+		const char*				name;
+		std::function<void()>	function;
+	};
+
+	std::vector<TestCase>&	testCases(void);
+	bool					registerTest(const char *name, std::function<void()> function);
+	void					fail(const char *file, int line, const char *expression);
+}
+
+#define HOST_TEST(name)																		\
+	static void name(void);																	\
+	static const bool name##Registered = HostTest::registerTest(#name, &name);				\
+	static void name(void)
+
+#define CHECK(expression)																	\
+	do																						\
+	{																						\
+		if ( ! (expression) )																\
+		{																					\
+			HostTest::fail(__FILE__, __LINE__, #expression);								\
+		}																					\
+	} while (0)
+
+#define CHECK_EQUAL(expected, actual)														\
+	do																						\
+	{																						\
+		auto expectedValue_ = (expected);													\
+		auto actualValue_ = (actual);														\
+		if ( ! ( expectedValue_ == actualValue_ ) )											\
+		{																					\
+			fprintf(stderr, "  expected %lld, got %lld\n", static_cast<long long>(expectedValue_), static_cast<long long>(actualValue_));	\
+			HostTest::fail(__FILE__, __LINE__, #expected " == " #actual);					\
+		}																					\
+	} while (0)
+
+#endif
@@ -0,0 +1,289 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	const uint32_t	RENEW_DELAY = 1000;
+	const uint32_t	DHCP_TIME = 2000;
+
+	size_t addSlowDHCPNetwork()
+	{
+		FakeIDF::AccessPoint accessPoint;
+
+		accessPoint.ssid = "home";
+		accessPoint.password = "secret123";
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x06 };
+		accessPoint.channel = 6;
+		accessPoint.dhcpTime = DHCP_TIME;
+
+		return FakeIDF::addAccessPoint(accessPoint);
+	}
+
+	bool connect(WiFi &wifi, RecordingEventHandler &handler, int connections)
+	{
+		return wifi.connectWPA("home", "secret123") && FakeIDF::runUntil([&]() { return handler.connected >= connections; }, 10000);
+	}
+
+	/**
+	 * @brief Records the context every networkConnected() is delivered in
+	 */
+	class ContextRecordingHandler : public RecordingEventHandler
+	{
+		public:
+
+			void networkConnected(const IPInfo &ipInfo) override
+			{
+				contexts.push_back( FakeIDF::currentContext() );
+				RecordingEventHandler::networkConnected(ipInfo);
+			}
+
+			std::vector<FakeIDF::Context>	contexts;
+	};
+
+	/**
+	 * @brief Records how often the NVS was written when networkConnected() is delivered
+	 */
+	class WriteRecordingHandler : public RecordingEventHandler
+	{
+		public:
+
+			void networkConnected(const IPInfo &ipInfo) override
+			{
+				nvsWrites.push_back( FakeIDF::counters().nvsWrites );
+				RecordingEventHandler::networkConnected(ipInfo);
+			}
+
+			std::vector<uint32_t>	nvsWrites;
+	};
+
+	// keeps the default event loop busy, so the lease timer fires while events are posted
+	void postEventsEveryMillisecond(uint32_t duration)
+	{
+		for ( uint32_t delay = 0; delay < duration; delay++ )
+		{
+			FakeIDF::schedule(delay, []()
+			{
+				wifi_event_ap_staconnected_t event = {};
+
+				esp_event_post(WIFI_EVENT, WIFI_EVENT_AP_STACONNECTED, &event, sizeof(event), 0);
+			});
+		}
+	}
+
+	// the first connect waits for DHCP and caches the lease, the second one reuses it
+	bool reconnect(WiFi &wifi, RecordingEventHandler &handler, int connections)
+	{
+		FakeIDF::dropLink(WIFI_REASON_ASSOC_LEAVE);
+		FakeIDF::runFor(100);
+
+		return connect(wifi, handler, connections);
+	}
+}
+
+HOST_TEST(cachedLeaseIsAppliedAfterProbe)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	size_t					accessPoint = addSlowDHCPNetwork();
+	uint32_t				lease = FakeIDF::ipAddress(10, 0, accessPoint + 1, 100);
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setDHCPLeaseCaching(true, RENEW_DELAY) );
+	CHECK( connect(wifi, handler, 1) );
+	CHECK_EQUAL( 0u, FakeIDF::counters().arpProbes );
+
+	uint64_t start = FakeIDF::now();
+
+	CHECK( reconnect(wifi, handler, 2) );
+	CHECK( FakeIDF::now() - start < DHCP_TIME );
+	CHECK_EQUAL( 1u, FakeIDF::counters().arpProbes );
+	CHECK_EQUAL( lease, handler.lastIPInfo.ip.addr );
+	CHECK_EQUAL( lease, FakeIDF::stationAddress() );
+}
+
+HOST_TEST(renewalKeepsCachedAddress)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	size_t					accessPoint = addSlowDHCPNetwork();
+	uint32_t				lease = FakeIDF::ipAddress(10, 0, accessPoint + 1, 100);
+	int						lostAddress = 0;
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setDHCPLeaseCaching(true, RENEW_DELAY) );
+	CHECK( connect(wifi, handler, 1) );
+	CHECK( reconnect(wifi, handler, 2) );
+
+	FakeIDF::resetCounters();
+
+	// the renewal starts after RENEW_DELAY and takes DHCP_TIME, the address must stay usable all the time
+	for ( uint32_t elapsed = 0; elapsed < RENEW_DELAY + DHCP_TIME + 1000; elapsed += 10 )
+	{
+		FakeIDF::runFor(10);
+
+		if ( FakeIDF::stationAddress() != lease )
+		{
+			lostAddress++;
+		}
+	}
+
+	CHECK_EQUAL( 0, lostAddress );
+	CHECK_EQUAL( 0u, FakeIDF::counters().addressCleared );
+	CHECK_EQUAL( 1u, FakeIDF::counters().dhcpStart );
+	CHECK_EQUAL( 2, handler.connected.load() );
+	CHECK_EQUAL( 1, handler.disconnected.load() );
+}
+
+HOST_TEST(changedLeaseIsReportedAfterRenewal)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	size_t					accessPoint = addSlowDHCPNetwork();
+	uint32_t				lease = FakeIDF::ipAddress(10, 0, accessPoint + 1, 100);
+	uint32_t				newLease = FakeIDF::ipAddress(10, 0, accessPoint + 1, 101);
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setDHCPLeaseCaching(true, RENEW_DELAY) );
+	CHECK( connect(wifi, handler, 1) );
+
+	FakeIDF::accessPoint(accessPoint).address = newLease;
+
+	CHECK( reconnect(wifi, handler, 2) );
+	CHECK_EQUAL( lease, handler.lastIPInfo.ip.addr );
+
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected == 3; }, RENEW_DELAY + DHCP_TIME + 1000) );
+	CHECK_EQUAL( newLease, handler.lastIPInfo.ip.addr );
+	CHECK_EQUAL( newLease, FakeIDF::stationAddress() );
+
+	// the new lease is cached for the next connect
+	CHECK( reconnect(wifi, handler, 4) );
+	CHECK_EQUAL( newLease, handler.lastIPInfo.ip.addr );
+}
+
+HOST_TEST(addressInUseIsNotReused)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	size_t					accessPoint = addSlowDHCPNetwork();
+	uint32_t				lease = FakeIDF::ipAddress(10, 0, accessPoint + 1, 100);
+	uint32_t				newLease = FakeIDF::ipAddress(10, 0, accessPoint + 1, 101);
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setDHCPLeaseCaching(true, RENEW_DELAY) );
+	CHECK( connect(wifi, handler, 1) );
+
+	// the lease expired while we were away and the server gave the address to another host
+	FakeIDF::accessPoint(accessPoint).address = newLease;
+	FakeIDF::addLANHost(lease);
+
+	uint64_t start = FakeIDF::now();
+
+	CHECK( reconnect(wifi, handler, 2) );
+	CHECK( FakeIDF::now() - start >= DHCP_TIME );
+	CHECK_EQUAL( 1u, FakeIDF::counters().arpProbes );
+	CHECK_EQUAL( newLease, handler.lastIPInfo.ip.addr );
+	CHECK_EQUAL( newLease, FakeIDF::stationAddress() );
+}
+
+HOST_TEST(unconfirmedLeaseIsDroppedWhenLinkFails)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	addSlowDHCPNetwork();
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setDHCPLeaseCaching(true, RENEW_DELAY) );
+	CHECK( connect(wifi, handler, 1) );
+	CHECK( reconnect(wifi, handler, 2) );
+
+	// kicked before the lease was confirmed, the cached lease may be the reason
+	FakeIDF::dropLink(WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT);
+	FakeIDF::runFor(100);
+	FakeIDF::resetCounters();
+
+	uint64_t start = FakeIDF::now();
+
+	CHECK( connect(wifi, handler, 3) );
+	CHECK( FakeIDF::now() - start >= DHCP_TIME );
+	CHECK_EQUAL( 0u, FakeIDF::counters().arpProbes );
+}
+
+HOST_TEST(renewedLeaseIsReportedOnEventLoop)
+{
+	ContextRecordingHandler	handler;
+	WiFi					wifi(&handler);
+	size_t					accessPoint = addSlowDHCPNetwork();
+	uint32_t				newLease = FakeIDF::ipAddress(10, 0, accessPoint + 1, 101);
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setDHCPLeaseCaching(true, RENEW_DELAY) );
+	CHECK( connect(wifi, handler, 1) );
+
+	FakeIDF::accessPoint(accessPoint).address = newLease;
+
+	CHECK( reconnect(wifi, handler, 2) );
+
+	// the lease timer fires during the probe, the renewal and every poll of the renewal
+	postEventsEveryMillisecond(RENEW_DELAY + DHCP_TIME + 1000);
+
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected == 3; }, RENEW_DELAY + DHCP_TIME + 1000) );
+	CHECK_EQUAL( newLease, handler.lastIPInfo.ip.addr );
+	CHECK_EQUAL( 3u, handler.contexts.size() );
+
+	for ( FakeIDF::Context context : handler.contexts )
+	{
+		// the timer task must not notify the handlers or post to the dispatcher
+		CHECK( context == FakeIDF::Context::EventLoop );
+	}
+}
+
+HOST_TEST(leaseIsWrittenAfterConnectionIsReported)
+{
+	WriteRecordingHandler	handler;
+	WiFi					wifi(&handler);
+
+	addSlowDHCPNetwork();
+
+	CHECK( wifi.init() );
+	CHECK( wifi.setDHCPLeaseCaching(true, RENEW_DELAY) );
+	FakeIDF::resetCounters();
+
+	CHECK( connect(wifi, handler, 1) );
+
+	// the flash write must not delay the notification
+	CHECK_EQUAL( 1u, handler.nvsWrites.size() );
+	CHECK_EQUAL( 0u, handler.nvsWrites.front() );
+
+	FakeIDF::runFor(10);
+	CHECK_EQUAL( 1u, FakeIDF::counters().nvsWrites );
+
+	// the same lease again is not written twice
+	CHECK( reconnect(wifi, handler, 2) );
+	FakeIDF::runFor(RENEW_DELAY + DHCP_TIME + 1000);
+	CHECK_EQUAL( 1u, FakeIDF::counters().nvsWrites );
+}
@@ -0,0 +1,243 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+
+#include "LineFramer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	struct Output
+	{
+		std::vector<std::string>	lines;
+		uint32_t					dropped = { 0 };
+	};
+
+	// feed the stream in the given fragments like socketBytesReceived() does
+	Output frame(LineFramer &framer, const std::string &stream, const std::vector<size_t> &fragments)
+	{
+		Output	output;
+		size_t	position = 0;
+
+		for ( size_t fragment : fragments )
+		{
+			const uint8_t*	data = reinterpret_cast<const uint8_t*>( stream.data() + position );
+			size_t			remaining = std::min(fragment, stream.size() - position);
+
+			position += remaining;
+
+			while ( remaining > 0 )
+			{
+				size_t consumed = framer.feed(data, remaining);
+				data += consumed;
+				remaining -= consumed;
+
+				char *line;
+				while ( framer.nextLine(line) )
+				{
+					output.lines.push_back(line);
+				}
+			}
+		}
+
+		output.dropped = framer.getDroppedCount();
+
+		return output;
+	}
+
+	Output frame(const std::string &stream, size_t fragment)
+	{
+		LineFramer framer;
+
+		return frame(framer, stream, std::vector<size_t>( stream.size() / fragment + 1, fragment ));
+	}
+}
+
+HOST_TEST(splitsCoalescedAndFragmentedLines)
+{
+	Output output = frame("{\"a\":1}\r\n{\"b\":2}\n{\"c\"", 5);
+
+	CHECK_EQUAL( 2u, output.lines.size() );
+	CHECK( output.lines[0] == "{\"a\":1}" );
+	CHECK( output.lines[1] == "{\"b\":2}" );
+
+	// the unterminated rest stays buffered
+	output = frame("{\"a\":1}\r\n{\"b\":2}\n{\"c\"", 1);
+	CHECK_EQUAL( 2u, output.lines.size() );
+}
+
+HOST_TEST(lineEndSplitAcrossReads)
+{
+	LineFramer	framer;
+	Output		output = frame(framer, "abc\r\n\r", { 4, 1, 1 });
+
+	CHECK_EQUAL( 1u, output.lines.size() );
+	CHECK( output.lines[0] == "abc" );
+
+	// the CR of the next line end arrived alone, its line is empty
+	output = frame(framer, "\ndef\n", { 5 });
+	CHECK_EQUAL( 1u, output.lines.size() );
+	CHECK( output.lines[0] == "def" );
+}
+
+HOST_TEST(emptyLinesAreSkipped)
+{
+	Output output = frame("\n\r\n\n{}\r\n\r\n", 3);
+
+	CHECK_EQUAL( 1u, output.lines.size() );
+	CHECK( output.lines[0] == "{}" );
+	CHECK_EQUAL( 0u, output.dropped );
+}
+
+HOST_TEST(linesLongerThanBufferAreDropped)
+{
+	std::string longest( LineFramer::CAPACITY - 1, 'x' );
+	std::string tooLong( LineFramer::CAPACITY, 'y' );
+	std::string huge( 5 * LineFramer::CAPACITY, 'z' );
+
+	Output output = frame(longest + "\n" + tooLong + "\n" + huge + "\r\nok\r\n" + longest + "\r\n", 700);
+
+	// the terminator has to fit as well, so the CRLF variant of the longest line is dropped too
+	CHECK_EQUAL( 2u, output.lines.size() );
+	CHECK( output.lines[0] == longest );
+	CHECK( output.lines[1] == "ok" );
+	CHECK_EQUAL( 3u, output.dropped );
+}
+
+HOST_TEST(fuzzRandomFragments)
+{
+	const uint32_t	ROUNDS = 2000;
+
+	for ( uint32_t round = 0; round < ROUNDS; round++ )
+	{
+		std::mt19937				random(round);
+		std::string					stream;
+		std::vector<std::string>	expected;
+		uint32_t					expectedDropped = 0;
+
+		for ( int message = random() % 40; message > 0; message-- )
+		{
+			// mostly short messages, now and then empty ones and ones around or beyond the buffer size
+			size_t		length;
+			uint32_t	kind = random() % 10;
+
+			if ( kind == 0 )
+			{
+				length = 0;
+			}
+			else if ( kind == 1 )
+			{
+				length = LineFramer::CAPACITY - 3 + random() % 6;
+			}
+			else if ( kind == 2 )
+			{
+				length = LineFramer::CAPACITY + random() % 3000;
+			}
+			else
+			{
+				length = 1 + random() % 200;
+			}
+
+			std::string text(length, ' ');
+			for ( char &character : text )
+			{
+				character = static_cast<char>( '!' + random() % 90 );
+			}
+
+			const char *lineEnd = random() % 2 ? "\r\n" : "\n";
+
+			stream += text + lineEnd;
+
+			if ( length == 0 )
+			{
+				continue;
+			}
+
+			if ( length + strlen(lineEnd) <= LineFramer::CAPACITY )
+			{
+				expected.push_back(text);
+			}
+			else
+			{
+				expectedDropped++;
+			}
+		}
+
+		std::vector<size_t> fragments;
+		for ( size_t total = 0; total < stream.size(); )
+		{
+			// single bytes up to several TLS records at once
+			size_t fragment = random() % 4 == 0 ? 1 : 1 + random() % 3000;
+
+			fragments.push_back(fragment);
+			total += fragment;
+		}
+
+		LineFramer	framer;
+		Output		output = frame(framer, stream, fragments);
+
+		CHECK_EQUAL( expected.size(), output.lines.size() );
+		CHECK_EQUAL( expectedDropped, output.dropped );
+		CHECK( output.lines == expected );
+
+		if ( output.lines != expected )
+		{
+			printf("round %u differs\n", round);
+			return;
+		}
+	}
+}
+
+HOST_TEST(throughput)
+{
+	const size_t	STREAM_SIZE = 64 * 1024 * 1024;
+	const size_t	RECORD_SIZE = 1460;
+
+	std::string		stream;
+	std::string		message = "{\"cmd\":\"setWiFi\",\"ssid\":\"home\",\"password\":\"secret123\",\"uuid\":\"0b0c3e4e-8a17-4bd5-a7a3-3f1b7d6f0c11\"}";
+	size_t			messages = 0;
+
+	while ( stream.size() < STREAM_SIZE )
+	{
+		stream += message + ( messages++ % 2 ? "\r\n" : "\n" );
+	}
+
+	LineFramer framer;
+
+	auto	start = std::chrono::steady_clock::now();
+	Output	output = frame(framer, stream, std::vector<size_t>( stream.size() / RECORD_SIZE + 1, RECORD_SIZE ));
+	auto	elapsed = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start );
+
+	double megabytesPerSecond = static_cast<double>(stream.size()) / static_cast<double>(elapsed.count());
+
+	printf("line framer: %.0f MB/s, %.0f ns per line\n", megabytesPerSecond, elapsed.count() * 1000.0 / static_cast<double>(messages));
+
+	CHECK_EQUAL( messages, output.lines.size() );
+	CHECK_EQUAL( 0u, output.dropped );
+
+	// far beyond any TLS link of the device, even on a slow host
+	CHECK( megabytesPerSecond > 20 );
+}
@@ -0,0 +1,127 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+
+#include "WiFiConnectionRecord.h"
+#include "WiFiLeaseRecord.h"
+
+extern "C"
+{
+    #include <nvs.h>
+}
+
+#include <cstdint>
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	const uint8_t BSSID[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x06 };
+
+	void writeBlob(const char *key, const std::vector<uint8_t> &blob)
+	{
+		nvs_handle_t handle;
+
+		nvs_open("idfix-wifi", NVS_READWRITE, &handle);
+		nvs_set_blob(handle, key, blob.data(), blob.size());
+		nvs_commit(handle);
+		nvs_close(handle);
+	}
+
+	bool hasBlob(const char *key)
+	{
+		nvs_handle_t	handle;
+		size_t			length = 0;
+
+		if ( nvs_open("idfix-wifi", NVS_READONLY, &handle) != ESP_OK )
+		{
+			return false;
+		}
+
+		esp_err_t result = nvs_get_blob(handle, key, nullptr, &length);
+		nvs_close(handle);
+
+		return result == ESP_OK;
+	}
+}
+
+HOST_TEST(clearOfAbsentRecordSparesNVS)
+{
+	WiFiConnectionRecord record;
+
+	CHECK( ! record.load() );
+	FakeIDF::resetCounters();
+
+	record.clear();
+	CHECK_EQUAL( 0u, FakeIDF::counters().nvsWrites );
+
+	// remembered but never written, the NVS still holds nothing
+	CHECK( record.remember(reinterpret_cast<const uint8_t*>("home"), 4, BSSID, 6) );
+	record.clear();
+	CHECK_EQUAL( 0u, FakeIDF::counters().nvsWrites );
+}
+
+HOST_TEST(clearErasesStaleRecord)
+{
+	// a record of an older version with another layout
+	writeBlob("lastap", std::vector<uint8_t>(6, 0));
+
+	WiFiConnectionRecord record;
+
+	CHECK( ! record.load() );
+	CHECK( ! record.matches("home") );
+
+	record.clear();
+	CHECK( ! hasBlob("lastap") );
+
+	// a lease without an address is unusable as well
+	std::vector<uint8_t> lease(20, 0);
+	lease[0] = 1;
+	writeBlob("lease", lease);
+
+	WiFiLeaseRecord leaseRecord;
+
+	CHECK( ! leaseRecord.load() );
+	leaseRecord.clear();
+	CHECK( ! hasBlob("lease") );
+}
+
+HOST_TEST(persistedRecordIsLoadedAndCleared)
+{
+	WiFiConnectionRecord record;
+
+	CHECK( ! record.load() );
+	CHECK( record.remember(reinterpret_cast<const uint8_t*>("home"), 4, BSSID, 6) );
+	CHECK( record.persist() );
+
+	WiFiConnectionRecord loaded;
+
+	CHECK( loaded.load() );
+	CHECK( loaded.matches("home") );
+	CHECK_EQUAL( 6, loaded.getChannel() );
+
+	loaded.clear();
+	CHECK( ! hasBlob("lastap") );
+
+	// the record knows the key is gone now
+	FakeIDF::resetCounters();
+	loaded.clear();
+	CHECK_EQUAL( 0u, FakeIDF::counters().nvsWrites );
+}
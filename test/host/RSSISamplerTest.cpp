@@ -0,0 +1,233 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+#include "RSSISampler.h"
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+HOST_TEST(emptySamplerHasNoStatistics)
+{
+	RSSISampler sampler;
+
+	CHECK_EQUAL( 0u, sampler.getStatistics().count );
+}
+
+HOST_TEST(statisticsOfRamp)
+{
+	RSSISampler	sampler;
+	double		ewma = -90;
+
+	for ( int rssi = -90; rssi < -90 + static_cast<int>(RSSISampler::CAPACITY); rssi++ )
+	{
+		sampler.record( static_cast<int8_t>(rssi) );
+		ewma += ( rssi - ewma ) / 8;
+	}
+
+	RSSIStatistics statistics = sampler.getStatistics();
+
+	CHECK_EQUAL( RSSISampler::CAPACITY, statistics.count );
+	CHECK_EQUAL( -59, statistics.last );
+	CHECK_EQUAL( -90, statistics.min );
+	CHECK_EQUAL( -59, statistics.max );
+	CHECK_EQUAL( -87, statistics.p10 );
+	CHECK_EQUAL( -75, statistics.p50 );
+	CHECK_EQUAL( -63, statistics.p90 );
+
+	// the fixed point average may lag the exact one by rounding only
+	CHECK( std::fabs(statistics.ewma - ewma) <= 1 );
+}
+
+HOST_TEST(ringKeepsNewestSamples)
+{
+	RSSISampler sampler;
+
+	for ( int sample = 0; sample < 100; sample++ )
+	{
+		sampler.record(-80);
+	}
+
+	for ( size_t sample = 0; sample < RSSISampler::CAPACITY; sample++ )
+	{
+		sampler.record(-40);
+	}
+
+	RSSIStatistics statistics = sampler.getStatistics();
+
+	CHECK_EQUAL( RSSISampler::CAPACITY, statistics.count );
+	CHECK_EQUAL( -40, statistics.min );
+	CHECK_EQUAL( -40, statistics.p10 );
+	CHECK_EQUAL( -40, statistics.max );
+}
+
+HOST_TEST(ewmaFollowsStepAndIgnoresOutlier)
+{
+	RSSISampler sampler;
+
+	for ( int sample = 0; sample < 20; sample++ )
+	{
+		sampler.record(-80);
+	}
+
+	// a single outlier moves the average by 1/8 of the jump only
+	sampler.record(-40);
+	CHECK( sampler.getEWMA() <= -74 );
+
+	for ( int sample = 0; sample < 8; sample++ )
+	{
+		sampler.record(-50);
+	}
+
+	CHECK( sampler.getEWMA() >= -62 && sampler.getEWMA() <= -57 );
+
+	for ( int sample = 0; sample < 32; sample++ )
+	{
+		sampler.record(-50);
+	}
+
+	CHECK( sampler.getEWMA() >= -51 && sampler.getEWMA() <= -50 );
+}
+
+HOST_TEST(resetDropsSamples)
+{
+	RSSISampler sampler;
+
+	sampler.record(-30);
+	sampler.record(-35);
+	sampler.reset();
+
+	CHECK_EQUAL( 0u, sampler.getStatistics().count );
+
+	// the average starts over as well
+	sampler.record(-70);
+
+	RSSIStatistics statistics = sampler.getStatistics();
+
+	CHECK_EQUAL( 1u, statistics.count );
+	CHECK_EQUAL( -70, statistics.ewma );
+	CHECK_EQUAL( -70, statistics.min );
+}
+
+HOST_TEST(concurrentWritersKeepEverySample)
+{
+	const size_t	WRITERS = 4;
+
+	RSSISampler					sampler;
+	std::vector<std::thread>	writers;
+	std::atomic<bool>			go = { false };
+
+	// the writers fill the buffer exactly, a lost slot would leave a gap or overwrite a sample
+	for ( size_t writer = 0; writer < WRITERS; writer++ )
+	{
+		writers.emplace_back([&sampler, &go, writer]()
+		{
+			while ( ! go )
+			{
+			}
+
+			for ( size_t sample = 0; sample < RSSISampler::CAPACITY / WRITERS; sample++ )
+			{
+				sampler.record( static_cast<int8_t>( -40 - 10 * writer ) );
+			}
+		});
+	}
+
+	go = true;
+
+	for ( std::thread &writer : writers )
+	{
+		writer.join();
+	}
+
+	RSSIStatistics statistics = sampler.getStatistics();
+
+	CHECK_EQUAL( RSSISampler::CAPACITY, statistics.count );
+	CHECK_EQUAL( -70, statistics.min );
+	CHECK_EQUAL( -40, statistics.max );
+	CHECK_EQUAL( -70, statistics.p10 );
+	CHECK_EQUAL( -60, statistics.p50 );
+	CHECK_EQUAL( -40, statistics.p90 );
+	CHECK( statistics.ewma >= -70 && statistics.ewma <= -40 );
+}
+
+HOST_TEST(sampleRSSIOfStation)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	FakeIDF::AccessPoint	accessPoint;
+
+	accessPoint.ssid = "home";
+	accessPoint.password = "secret123";
+	accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x06 };
+	accessPoint.channel = 6;
+	accessPoint.rssi = -67;
+	size_t index = FakeIDF::addAccessPoint(accessPoint);
+
+	CHECK( wifi.init() );
+	CHECK_EQUAL( WiFi::INVALID_RSSI, wifi.sampleRSSI() );
+	CHECK_EQUAL( 0u, wifi.getRSSIStatistics().count );
+
+	CHECK( wifi.connectWPA("home", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+
+	CHECK_EQUAL( -67, wifi.sampleRSSI() );
+	FakeIDF::setRSSI(index, -71);
+	CHECK_EQUAL( -71, wifi.sampleRSSI() );
+
+	RSSIStatistics statistics = wifi.getRSSIStatistics();
+
+	CHECK_EQUAL( 2u, statistics.count );
+	CHECK_EQUAL( -71, statistics.last );
+	CHECK_EQUAL( -71, statistics.min );
+	CHECK_EQUAL( -67, statistics.max );
+
+	// a new connection starts new statistics
+	FakeIDF::dropLink(WIFI_REASON_ASSOC_LEAVE);
+	CHECK( wifi.connectWPA("home", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 1; }, 5000) );
+	CHECK_EQUAL( 0u, wifi.getRSSIStatistics().count );
+}
+
+HOST_TEST(ewmaIsRounded)
+{
+	RSSISampler sampler;
+
+	// -50 + (-56 + 50) / 8 is -50.75
+	sampler.record(-50);
+	sampler.record(-56);
+	CHECK_EQUAL( -51, sampler.getEWMA() );
+
+	// truncated steps stop short of a step by 1 dBm
+	sampler.reset();
+	sampler.record(-50);
+
+	for ( int sample = 0; sample < 100; sample++ )
+	{
+		sampler.record(-51);
+	}
+
+	CHECK_EQUAL( -51, sampler.getEWMA() );
+}
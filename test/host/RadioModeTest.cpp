@@ -0,0 +1,167 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+#include "RadioModeManager.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	void initDriver()
+	{
+		wifi_init_config_t config = WIFI_INIT_CONFIG_DEFAULT();
+
+		esp_wifi_init(&config);
+		FakeIDF::resetCounters();
+	}
+
+	uint32_t driverCalls()
+	{
+		const FakeIDF::Counters &counters = FakeIDF::counters();
+
+		return counters.setMode + counters.start + counters.stop;
+	}
+}
+
+HOST_TEST(scanWhileStationRunsCostsNoDriverCall)
+{
+	RadioModeManager radio;
+
+	initDriver();
+
+	CHECK( radio.acquire(RadioModeManager::UserStation) );
+	CHECK( radio.start() );
+	CHECK_EQUAL( 1u, FakeIDF::counters().setMode );
+	CHECK_EQUAL( 1u, FakeIDF::counters().start );
+
+	CHECK( radio.acquire(RadioModeManager::UserScan) );
+	CHECK( radio.start() );
+	CHECK( radio.release(RadioModeManager::UserScan) );
+
+	CHECK_EQUAL( 2u, driverCalls() );
+	CHECK_EQUAL( driverCalls(), radio.getDriverCallCount() );
+	CHECK( radio.getMode() == WIFI_MODE_STA );
+}
+
+HOST_TEST(modeFollowsUsers)
+{
+	RadioModeManager radio;
+
+	initDriver();
+
+	CHECK( radio.acquire(RadioModeManager::UserStation) );
+	CHECK( radio.start() );
+	CHECK( radio.acquire(RadioModeManager::UserAccessPoint) );
+	CHECK( radio.getMode() == WIFI_MODE_APSTA );
+
+	CHECK( radio.release(RadioModeManager::UserStation) );
+	CHECK( radio.getMode() == WIFI_MODE_AP );
+	CHECK_EQUAL( 0u, FakeIDF::counters().stop );
+
+	// the last user stops the driver
+	CHECK( radio.release(RadioModeManager::UserAccessPoint) );
+	CHECK( radio.getMode() == WIFI_MODE_NULL );
+	CHECK( ! radio.release(RadioModeManager::UserAccessPoint) );
+
+	CHECK_EQUAL( 4u, FakeIDF::counters().setMode );
+	CHECK_EQUAL( 1u, FakeIDF::counters().start );
+	CHECK_EQUAL( 1u, FakeIDF::counters().stop );
+	CHECK_EQUAL( driverCalls(), radio.getDriverCallCount() );
+}
+
+HOST_TEST(scanOfConnectedStationCostsNoDriverCall)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	FakeIDF::AccessPoint	accessPoint;
+
+	accessPoint.ssid = "home";
+	accessPoint.password = "secret123";
+	accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x06 };
+	accessPoint.channel = 6;
+	FakeIDF::addAccessPoint(accessPoint);
+
+	CHECK( wifi.init() );
+	CHECK( wifi.connectWPA("home", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+
+	FakeIDF::resetCounters();
+	uint32_t before = wifi.getRadioModeManager().getDriverCallCount();
+
+	CHECK_EQUAL( 1, wifi.scan() );
+	CHECK( wifi.scanAsync() );
+	CHECK( FakeIDF::runUntil([&]() { return handler.scansFinished > 0; }, 5000) );
+
+	CHECK_EQUAL( 0u, driverCalls() );
+	CHECK_EQUAL( before, wifi.getRadioModeManager().getDriverCallCount() );
+	CHECK( FakeIDF::isConnected() );
+}
+
+HOST_TEST(concurrentUsersKeepCountsConsistent)
+{
+	const size_t	TASKS = 4;
+	const size_t	ROUNDS = 200000;
+
+	RadioModeManager			radio;
+	std::vector<std::thread>	tasks;
+	std::atomic<bool>			go = { false };
+
+	initDriver();
+
+	// the station keeps the mode, so the scans running from several tasks never touch the driver
+	CHECK( radio.acquire(RadioModeManager::UserStation) );
+	CHECK( radio.start() );
+
+	for ( size_t task = 0; task < TASKS; task++ )
+	{
+		tasks.emplace_back([&radio, &go, ROUNDS]()
+		{
+			while ( ! go )
+			{
+			}
+
+			for ( size_t round = 0; round < ROUNDS; round++ )
+			{
+				radio.acquire(RadioModeManager::UserScan);
+				radio.release(RadioModeManager::UserScan);
+			}
+		});
+	}
+
+	go = true;
+
+	for ( std::thread &task : tasks )
+	{
+		task.join();
+	}
+
+	CHECK( ! radio.isUsedBy(RadioModeManager::UserScan) );
+	CHECK( ! radio.release(RadioModeManager::UserScan) );
+	CHECK_EQUAL( 2u, radio.getDriverCallCount() );
+
+	CHECK( radio.release(RadioModeManager::UserStation) );
+	CHECK_EQUAL( 1u, FakeIDF::counters().stop );
+}
@@ -0,0 +1,132 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+
+#include "WiFi.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	ReconnectPolicy withoutJitter()
+	{
+		ReconnectPolicy policy;
+
+		policy.enabled = true;
+		policy.jitter = 0;
+
+		return policy;
+	}
+}
+
+HOST_TEST(backoffGrowsUpToCap)
+{
+	ReconnectPolicy policy = withoutJitter();
+
+	CHECK_EQUAL( 500u, reconnectDelay(policy, DisconnectCategory::NetworkNotFound, 0, 0) );
+	CHECK_EQUAL( 1000u, reconnectDelay(policy, DisconnectCategory::NetworkNotFound, 1, 0) );
+	CHECK_EQUAL( 32000u, reconnectDelay(policy, DisconnectCategory::NetworkNotFound, 6, 0) );
+
+	// 64 s would exceed the cap
+	CHECK_EQUAL( 60000u, reconnectDelay(policy, DisconnectCategory::NetworkNotFound, 7, 0) );
+	CHECK_EQUAL( 60000u, reconnectDelay(policy, DisconnectCategory::NetworkNotFound, 1000, 0) );
+	CHECK_EQUAL( 60000u, reconnectDelay(policy, DisconnectCategory::NetworkNotFound, UINT16_MAX, 0) );
+
+	// a factor which would overflow 32 bit after a few attempts
+	policy.backoffFactor = 255;
+	policy.maxDelay = UINT32_MAX;
+	CHECK_EQUAL( UINT32_MAX, reconnectDelay(policy, DisconnectCategory::Other, 10, 0) );
+}
+
+HOST_TEST(lostLinkIsRetriedRightAway)
+{
+	ReconnectPolicy policy = withoutJitter();
+
+	CHECK_EQUAL( 100u, reconnectDelay(policy, DisconnectCategory::LinkLost, 0, 0) );
+
+	// once the first attempt failed, the access point is treated like any other failure
+	CHECK_EQUAL( 1000u, reconnectDelay(policy, DisconnectCategory::LinkLost, 1, 0) );
+}
+
+HOST_TEST(jitterStaysWithinShare)
+{
+	ReconnectPolicy policy;
+
+	policy.jitter = 50;
+
+	for ( uint32_t random : { 0u, 1u, 1000u, 2000u, 2001u, UINT32_MAX } )
+	{
+		uint32_t delay = reconnectDelay(policy, DisconnectCategory::NetworkNotFound, 3, random);
+
+		CHECK( delay >= 2000 && delay <= 4000 );
+	}
+
+	// the cap holds including the jitter
+	for ( uint32_t random : { 0u, UINT32_MAX / 2, UINT32_MAX } )
+	{
+		CHECK( reconnectDelay(policy, DisconnectCategory::NetworkNotFound, 20, random) <= policy.maxDelay );
+	}
+
+	// more than 100 percent are taken as 100 percent
+	policy.jitter = 200;
+	CHECK( reconnectDelay(policy, DisconnectCategory::NetworkNotFound, 3, UINT32_MAX) <= 4000 );
+}
+
+HOST_TEST(jitterSpreadsFleet)
+{
+	const size_t	DEVICES = 1000;
+	const size_t	SLOTS = 10;
+
+	ReconnectPolicy			policy;
+	std::mt19937			random(42);
+	std::vector<uint32_t>	delays;
+
+	// an access point reboots and the whole fleet fails its third attempt at the same time
+	for ( size_t device = 0; device < DEVICES; device++ )
+	{
+		delays.push_back( reconnectDelay(policy, DisconnectCategory::NetworkNotFound, 3, random()) );
+	}
+
+	std::sort(delays.begin(), delays.end());
+
+	uint32_t lowest = delays.front();
+	uint32_t highest = delays.back();
+
+	// the attempts use the whole jitter window evenly
+	std::array<uint32_t, SLOTS> slots = {};
+	for ( uint32_t delay : delays )
+	{
+		slots[std::min<size_t>( ( delay - 2000 ) * SLOTS / 2000, SLOTS - 1 )]++;
+	}
+
+	uint32_t busiest = *std::max_element(slots.begin(), slots.end());
+	uint32_t quietest = *std::min_element(slots.begin(), slots.end());
+
+	printf("fleet: attempts between %u and %u ms, %u to %u devices per 200 ms\n", lowest, highest, quietest, busiest);
+
+	CHECK( lowest >= 2000 && lowest < 2050 );
+	CHECK( highest <= 4000 && highest > 3950 );
+	CHECK( busiest < DEVICES / SLOTS * 3 / 2 );
+	CHECK( quietest > DEVICES / SLOTS / 2 );
+}
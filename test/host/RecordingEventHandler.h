@@ -0,0 +1,76 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECORDINGEVENTHANDLER_H
+#define RECORDINGEVENTHANDLER_H
+
+#include "WiFiEventHandler.h"
+
+#include <atomic>
+
+/**
+ * @brief Counts the WiFiEventHandler callbacks and keeps the arguments of the last ones
+ */
+class RecordingEventHandler : public IDFix::WiFi::WiFiEventHandler
+{
+	public:
+
+		void networkConnected(const IDFix::WiFi::IPInfo &ipInfo) override
+		{
+			lastIPInfo = ipInfo;
+			connected++;
+		}
+
+		void networkDisconnected() override
+		{
+			disconnected++;
+		}
+
+		void accessPointStarted(ip4_addr_t) override
+		{
+			accessPointsStarted++;
+		}
+
+		void accessPointStopped() override
+		{
+			accessPointsStopped++;
+		}
+
+		void scanFinished(int16_t apCount) override
+		{
+			lastAPCount = apCount;
+			scansFinished++;
+		}
+
+		void reconnectFailed(IDFix::WiFi::DisconnectCategory category) override
+		{
+			lastCategory = category;
+			reconnectsFailed++;
+		}
+
+		std::atomic<int>					connected = { 0 };
+		std::atomic<int>					disconnected = { 0 };
+		std::atomic<int>					accessPointsStarted = { 0 };
+		std::atomic<int>					accessPointsStopped = { 0 };
+		std::atomic<int>					scansFinished = { 0 };
+		std::atomic<int>					reconnectsFailed = { 0 };
+		IDFix::WiFi::IPInfo					lastIPInfo = {};
+		int16_t								lastAPCount = { 0 };
+		IDFix::WiFi::DisconnectCategory		lastCategory = { IDFix::WiFi::DisconnectCategory::Other };
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	FakeIDF::AccessPoint officeNetwork(uint8_t channel, int8_t rssi)
+	{
+		FakeIDF::AccessPoint accessPoint;
+
+		accessPoint.ssid = "office";
+		accessPoint.password = "secret123";
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, channel };
+		accessPoint.channel = channel;
+		accessPoint.rssi = rssi;
+
+		return accessPoint;
+	}
+
+	RoamingConfig fastRoaming()
+	{
+		RoamingConfig config;
+
+		config.interval = 1000;
+		config.samplesBelow = 3;
+
+		return config;
+	}
+}
+
+HOST_TEST(roamsToStrongerAccessPoint)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	size_t weak = FakeIDF::addAccessPoint( officeNetwork(1, -60) );
+	size_t strong = FakeIDF::addAccessPoint( officeNetwork(11, -50) );
+
+	FakeIDF::removeAccessPoint(strong);
+
+	CHECK( wifi.init() );
+	CHECK( wifi.connectWPA("office", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+	CHECK( wifi.enableRoaming( fastRoaming() ) );
+
+	FakeIDF::addAccessPoint( officeNetwork(11, -50) );
+	FakeIDF::setRSSI(weak, -85);
+
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 1; }, 20000) );
+	CHECK_EQUAL( -50, wifi.getRSSILevel() );
+
+	// the roaming scan is not reported to the handler
+	CHECK_EQUAL( 0, handler.scansFinished.load() );
+}
+
+HOST_TEST(roamingCheckDoesNotTakeOverScanOfApplication)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	size_t weak = FakeIDF::addAccessPoint( officeNetwork(1, -60) );
+	size_t strong = FakeIDF::addAccessPoint( officeNetwork(11, -70) );
+
+	CHECK( wifi.init() );
+	CHECK( wifi.connectWPA("office", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+
+	FakeIDF::setRSSI(weak, -85);
+	FakeIDF::setRSSI(strong, -50);
+	CHECK( wifi.enableRoaming( fastRoaming() ) );
+
+	// the roaming monitor gets weak samples while the scan of the application runs
+	FakeIDF::runFor(2500);
+	CHECK( wifi.scanAsync() );
+	CHECK( FakeIDF::runUntil([&]() { return handler.scansFinished > 0; }, 10000) );
+
+	CHECK_EQUAL( 1, handler.scansFinished.load() );
+	CHECK_EQUAL( 2, handler.lastAPCount );
+
+	// the roaming scan follows once the slot is free again
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 1; }, 20000) );
+	CHECK_EQUAL( -50, wifi.getRSSILevel() );
+	CHECK_EQUAL( 1, handler.scansFinished.load() );
+}
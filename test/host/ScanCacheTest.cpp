@@ -0,0 +1,326 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "HeapTracker.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+#include "WiFiScanCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	wifi_ap_record_t makeRecord(const char *ssid, uint8_t id, int8_t rssi)
+	{
+		wifi_ap_record_t record = {};
+
+		snprintf(reinterpret_cast<char*>(record.ssid), sizeof(record.ssid), "%s", ssid);
+		record.bssid[0] = 0x02;
+		record.bssid[5] = id;
+		record.primary = 1;
+		record.rssi = rssi;
+
+		return record;
+	}
+}
+
+HOST_TEST(completeCacheCoversMissingSSID)
+{
+	WiFiScanCache cache;
+
+	cache.begin("");
+	CHECK( cache.insert( makeRecord("office", 1, -50) ) );
+	CHECK( cache.insert( makeRecord("guest", 2, -60) ) );
+	cache.commit();
+
+	// every AP around was collected, so an SSID which is not cached is out of range
+	CHECK( cache.covers("office") );
+	CHECK( cache.covers("absent") );
+}
+
+HOST_TEST(truncatedCacheDoesNotCoverMissingSSID)
+{
+	WiFiScanCache cache;
+
+	cache.begin("");
+
+	for ( uint8_t id = 0; id < WiFiScanCache::CAPACITY + 4; id++ )
+	{
+		char ssid[8];
+
+		snprintf(ssid, sizeof(ssid), "ap%u", id);
+		cache.insert( makeRecord(ssid, id, static_cast<int8_t>( -40 - id )) );
+	}
+
+	cache.commit();
+
+	CHECK_EQUAL( WiFiScanCache::CAPACITY, cache.size() );
+	CHECK( cache.covers("ap0") );
+	CHECK( ! cache.covers("ap19") );
+	CHECK( ! cache.covers("absent") );
+
+	// a new scan starts complete again
+	cache.begin("");
+	CHECK( cache.insert( makeRecord("office", 1, -50) ) );
+	cache.commit();
+	CHECK( cache.covers("absent") );
+}
+
+HOST_TEST(recordsDroppedByDriverMarkCacheTruncated)
+{
+	WiFiScanCache cache;
+
+	cache.begin("");
+	CHECK( cache.insert( makeRecord("office", 1, -50) ) );
+	cache.markTruncated();
+	cache.commit();
+
+	CHECK( cache.covers("office") );
+	CHECK( ! cache.covers("absent") );
+}
+
+HOST_TEST(collectionKeepsPublishedRecords)
+{
+	WiFiScanCache cache;
+
+	cache.begin("");
+	CHECK( cache.insert( makeRecord("office", 1, -50) ) );
+	CHECK( cache.insert( makeRecord("guest", 2, -60) ) );
+	cache.commit();
+
+	// readers see the last scan until the next one is committed
+	cache.begin("guest");
+	CHECK( cache.insert( makeRecord("guest", 3, -40) ) );
+	CHECK_EQUAL( 2u, cache.size() );
+	CHECK( cache.covers("office") );
+	CHECK_EQUAL( -50, cache.getRSSI(0) );
+
+	cache.commit();
+	CHECK_EQUAL( 1u, cache.size() );
+	CHECK( ! cache.covers("office") );
+	CHECK_EQUAL( -40, cache.getRSSI(0) );
+}
+
+HOST_TEST(resultsStayReadableWhileScanning)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	FakeIDF::AccessPoint	accessPoint;
+
+	accessPoint.ssid = "guest";
+	accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	accessPoint.channel = 1;
+	accessPoint.rssi = -70;
+	FakeIDF::addAccessPoint(accessPoint);
+
+	accessPoint.ssid = "office";
+	accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x06 };
+	accessPoint.channel = 6;
+	accessPoint.rssi = -50;
+	FakeIDF::addAccessPoint(accessPoint);
+
+	CHECK( wifi.init() );
+	wifi.setChannelPlan({ 1, 6 });
+	CHECK_EQUAL( 2, wifi.scan() );
+
+	const WiFiScanCache &cache = wifi.getScanResults();
+	uint32_t channelScans = 0;
+	bool consistent = true;
+
+	// with a channel plan every channel is scanned separately, so look at the results between two of them
+	FakeIDF::setScanStartHook([&](const wifi_scan_config_t&)
+	{
+		cache.lock();
+		consistent = consistent && cache.size() == 2 && cache.getRSSI(0) == -50 && cache.getRSSI(1) == -70;
+		cache.unlock();
+
+		channelScans++;
+	});
+
+	FakeIDF::removeAccessPoint(1);
+	CHECK_EQUAL( 1, wifi.scan() );
+
+	CHECK_EQUAL( 2u, channelScans );
+	CHECK( consistent );
+	CHECK_EQUAL( 1u, cache.size() );
+	CHECK( cache.count("office") == 0 );
+}
+
+HOST_TEST(connectScansAgainForSSIDDroppedFromCrowdedScan)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	FakeIDF::AccessPoint	accessPoint;
+
+	accessPoint.ssid = "crowd";
+	accessPoint.rssi = -50;
+
+	for ( uint8_t id = 0; id < WiFiScanCache::CAPACITY + 4; id++ )
+	{
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x01, id };
+		FakeIDF::addAccessPoint(accessPoint);
+	}
+
+	accessPoint.ssid = "office";
+	accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	accessPoint.channel = 11;
+	accessPoint.rssi = -85;
+	accessPoint.password = "secret123";
+	size_t office = FakeIDF::addAccessPoint(accessPoint);
+
+	CHECK( wifi.init() );
+	CHECK( wifi.scan() > static_cast<int>(WiFiScanCache::CAPACITY) );
+
+	// the weak office AP did not fit into the cache, so it must be looked up again instead of given up
+	CHECK( wifi.scanAndConnect("office", "secret123") );
+	CHECK( FakeIDF::runUntil([&]() { return handler.connected > 0; }, 5000) );
+	CHECK_EQUAL( FakeIDF::ipAddress(10, 0, office + 1, 100), handler.lastIPInfo.ip.addr );
+}
+
+HOST_TEST(scanKeepsStrongestAccessPoints)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	FakeIDF::AccessPoint	accessPoint;
+
+	// the driver reports channel by channel, so the weak access points come first
+	accessPoint.ssid = "weak";
+	accessPoint.channel = 1;
+	accessPoint.rssi = -85;
+
+	for ( uint8_t id = 0; id < 2 * WiFiScanCache::CAPACITY; id++ )
+	{
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x01, id };
+		FakeIDF::addAccessPoint(accessPoint);
+	}
+
+	accessPoint.ssid = "strong";
+	accessPoint.channel = 11;
+	accessPoint.rssi = -40;
+
+	for ( uint8_t id = 0; id < 4; id++ )
+	{
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x02, id };
+		FakeIDF::addAccessPoint(accessPoint);
+	}
+
+	CHECK( wifi.init() );
+	CHECK_EQUAL( 2 * WiFiScanCache::CAPACITY + 4, wifi.scan() );
+
+	const WiFiScanCache &cache = wifi.getScanResults();
+
+	CHECK_EQUAL( WiFiScanCache::CAPACITY, cache.size() );
+	CHECK_EQUAL( 4, cache.count("strong") );
+	CHECK_EQUAL( -40, cache.getRSSI(0) );
+}
+
+/*
+ * Compares collecting the records of a scan into the cache with the allocating path it replaced,
+ * which fetched all records into new wifi_ap_record_t[apCount] and copied them into a vector.
+ */
+HOST_TEST(collectBenchmark)
+{
+	const size_t		SCANS = 20000;
+	const uint8_t		APS_PER_SCAN = 40;
+
+	WiFiScanCache					cache;
+	std::vector<wifi_ap_record_t>	legacyCache;
+	wifi_ap_record_t				chunk[WiFiScanCache::CAPACITY];
+	std::mt19937					random(1);
+	std::vector<wifi_ap_record_t>	records;
+
+	// a dense environment: more APs than the cache holds, some reported twice
+	for ( uint8_t id = 0; id < APS_PER_SCAN; id++ )
+	{
+		records.push_back( makeRecord("dense", id % ( APS_PER_SCAN - 4 ), static_cast<int8_t>( -30 - random() % 60 )) );
+	}
+
+	size_t heapBefore = HeapTracker::current();
+	HeapTracker::resetPeak();
+
+	auto start = std::chrono::steady_clock::now();
+
+	for ( size_t scan = 0; scan < SCANS; scan++ )
+	{
+		std::shuffle(records.begin(), records.end(), random);
+
+		cache.begin("");
+
+		for ( size_t first = 0; first < records.size(); first += WiFiScanCache::CAPACITY )
+		{
+			size_t chunkCount = std::min(records.size() - first, WiFiScanCache::CAPACITY);
+
+			// the driver copies a chunk of records
+			std::copy(records.begin() + first, records.begin() + first + chunkCount, chunk);
+
+			for ( size_t index = 0; index < chunkCount; index++ )
+			{
+				cache.insert(chunk[index]);
+			}
+		}
+
+		cache.commit();
+	}
+
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	size_t peakHeap = HeapTracker::peak() - heapBefore;
+
+	heapBefore = HeapTracker::current();
+	HeapTracker::resetPeak();
+
+	auto legacyStart = std::chrono::steady_clock::now();
+
+	for ( size_t scan = 0; scan < SCANS; scan++ )
+	{
+		std::shuffle(records.begin(), records.end(), random);
+
+		wifi_ap_record_t *apList = new wifi_ap_record_t[records.size()];
+
+		std::copy(records.begin(), records.end(), apList);
+		legacyCache.assign(apList, apList + records.size());
+
+		delete[] apList;
+	}
+
+	auto legacyElapsed = std::chrono::steady_clock::now() - legacyStart;
+	size_t legacyPeakHeap = HeapTracker::peak() - heapBefore;
+
+	long long perScan = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / static_cast<long long>(SCANS);
+	long long legacyPerScan = std::chrono::duration_cast<std::chrono::nanoseconds>(legacyElapsed).count() / static_cast<long long>(SCANS);
+
+	printf("scan of %u records: cache %lld ns, %zu bytes heap peak; allocating path %lld ns, %zu bytes heap peak\n",
+		   APS_PER_SCAN, perScan, peakHeap, legacyPerScan, legacyPeakHeap);
+
+	CHECK_EQUAL( WiFiScanCache::CAPACITY, cache.size() );
+	CHECK( ! cache.covers("absent") );
+
+	// the cache must not touch the heap, the allocating path needs two copies of all records
+	CHECK_EQUAL( 0u, peakHeap );
+	CHECK( legacyPeakHeap >= 2 * APS_PER_SCAN * sizeof(wifi_ap_record_t) );
+
+	// collecting a scan must stay negligible compared to the scan itself, even on a slow host
+	CHECK( perScan < 200000 );
+}
@@ -0,0 +1,296 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+#include "RecordingEventHandler.h"
+
+#include "WiFi.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	void addAccessPoints()
+	{
+		FakeIDF::AccessPoint accessPoint;
+
+		accessPoint.ssid = "office";
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+		accessPoint.channel = 1;
+		FakeIDF::addAccessPoint(accessPoint);
+
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x06 };
+		accessPoint.channel = 6;
+		FakeIDF::addAccessPoint(accessPoint);
+
+		accessPoint.ssid = "guest";
+		accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0b };
+		accessPoint.channel = 11;
+		FakeIDF::addAccessPoint(accessPoint);
+	}
+
+	struct ScanRun
+	{
+		size_t		found = { 0 };
+		uint64_t	duration = { 0 };
+	};
+
+	ScanRun timedScan(WiFi &wifi, ScanProfile profile)
+	{
+		ScanRun run;
+
+		wifi.setScanProfile(profile);
+
+		uint64_t start = FakeIDF::now();
+		int found = wifi.scan();
+
+		run.duration = FakeIDF::now() - start;
+		run.found = found > 0 ? static_cast<size_t>(found) : 0;
+
+		return run;
+	}
+}
+
+HOST_TEST(asyncScanIsRejectedDuringBlockingScan)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	bool					asyncStarted = true;
+	ProbeResult				probeResult = ProbeResult::Found;
+
+	addAccessPoints();
+	CHECK( wifi.init() );
+
+	// the roaming timer or another task tries to scan while scan() waits for the driver
+	FakeIDF::schedule(50, [&]()
+	{
+		asyncStarted = wifi.scanAsync("office");
+		probeResult = wifi.probeSSID("office");
+	});
+
+	CHECK_EQUAL( 3, wifi.scan() );
+	CHECK( ! asyncStarted );
+	CHECK( probeResult == ProbeResult::Error );
+	CHECK_EQUAL( 0u, FakeIDF::counters().scanRejected );
+	CHECK_EQUAL( 3u, wifi.getScanResults().size() );
+
+	FakeIDF::runFor(10000);
+
+	CHECK_EQUAL( 0, handler.scansFinished.load() );
+	CHECK_EQUAL( 3u, wifi.getScanResults().size() );
+}
+
+HOST_TEST(blockingScanIsRejectedDuringAsyncScan)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	addAccessPoints();
+	CHECK( wifi.init() );
+
+	CHECK( wifi.scanAsync() );
+	CHECK_EQUAL( -1, wifi.scan("office") );
+	CHECK( wifi.probeSSID("office") == ProbeResult::Error );
+	CHECK( FakeIDF::runUntil([&]() { return handler.scansFinished > 0; }, 10000) );
+
+	CHECK_EQUAL( 3, handler.lastAPCount );
+	CHECK_EQUAL( 3u, wifi.getScanResults().size() );
+	CHECK_EQUAL( 0u, FakeIDF::counters().scanRejected );
+}
+
+HOST_TEST(staleScanDoneOfBlockingScanIsIgnored)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	addAccessPoints();
+	CHECK( wifi.init() );
+
+	// the SCAN_DONE of the blocking scan is still queued when the async scan starts
+	wifi.setChannelPlan({ 1, 6 });
+	CHECK_EQUAL( 2, wifi.scan("office") );
+
+	wifi.setChannelPlan({});
+	CHECK( wifi.scanAsync() );
+
+	FakeIDF::runFor(0);
+	CHECK_EQUAL( 0, handler.scansFinished.load() );
+
+	CHECK( FakeIDF::runUntil([&]() { return handler.scansFinished > 0; }, 10000) );
+	CHECK_EQUAL( 3, handler.lastAPCount );
+	CHECK_EQUAL( 3u, wifi.getScanResults().size() );
+
+	FakeIDF::runFor(10000);
+	CHECK_EQUAL( 1, handler.scansFinished.load() );
+}
+
+HOST_TEST(staleScanDoneOfProbeIsIgnored)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+
+	addAccessPoints();
+	CHECK( wifi.init() );
+
+	CHECK( wifi.probeSSID("guest") == ProbeResult::Found );
+	CHECK( wifi.scanAsync() );
+	CHECK( FakeIDF::runUntil([&]() { return handler.scansFinished > 0; }, 10000) );
+	CHECK_EQUAL( 3, handler.lastAPCount );
+
+	// the radio is released once all scans are done
+	FakeIDF::runFor(1000);
+	CHECK_EQUAL( WIFI_MODE_NULL, wifi.getRadioModeManager().getMode() );
+}
+
+HOST_TEST(adaptiveScanRefinesHitChannels)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	FakeIDF::AccessPoint	accessPoint;
+
+	accessPoint.ssid = "office";
+	accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	accessPoint.channel = 1;
+	FakeIDF::addAccessPoint(accessPoint);
+
+	accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x06 };
+	accessPoint.channel = 6;
+	FakeIDF::addAccessPoint(accessPoint);
+
+	// too slow for the fast pass, but it shares a channel with an access point which answered
+	accessPoint.ssid = "printer";
+	accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x01, 0x06 };
+	accessPoint.probeResponseTime = 150;
+	FakeIDF::addAccessPoint(accessPoint);
+
+	CHECK( wifi.init() );
+
+	ScanRun fast = timedScan(wifi, ScanProfile::FastActive);
+	ScanRun thorough = timedScan(wifi, ScanProfile::Thorough);
+	ScanRun adaptive = timedScan(wifi, ScanProfile::Adaptive);
+
+	CHECK_EQUAL( 2u, fast.found );
+	CHECK_EQUAL( 3u, thorough.found );
+	CHECK_EQUAL( 3u, adaptive.found );
+	CHECK_EQUAL( 3u, wifi.getScanResults().size() );
+	CHECK( adaptive.duration < thorough.duration );
+}
+
+HOST_TEST(adaptiveScanAccuracy)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	std::mt19937			random(1234);
+	std::vector<size_t>		accessPoints;
+	size_t					thoroughFound = 0;
+	size_t					adaptiveFound = 0;
+	uint64_t				thoroughDuration = 0;
+	uint64_t				adaptiveDuration = 0;
+
+	CHECK( wifi.init() );
+
+	// most access points answer probe requests quickly, a few are slow and need the longer dwell time
+	for ( int layout = 0; layout < 100; layout++ )
+	{
+		for ( size_t index : accessPoints )
+		{
+			FakeIDF::removeAccessPoint(index);
+		}
+
+		accessPoints.clear();
+
+		for ( uint8_t id = 0; id < 8; id++ )
+		{
+			FakeIDF::AccessPoint accessPoint;
+
+			accessPoint.ssid = "net" + std::to_string(id);
+			accessPoint.bssid = { 0x02, 0x00, 0x00, static_cast<uint8_t>(layout), 0x00, id };
+			accessPoint.channel = std::uniform_int_distribution<int>(1, 13)(random);
+			accessPoint.probeResponseTime = random() % 5 == 0 ? std::uniform_int_distribution<uint32_t>(80, 180)(random) : std::uniform_int_distribution<uint32_t>(5, 15)(random);
+
+			accessPoints.push_back( FakeIDF::addAccessPoint(accessPoint) );
+		}
+
+		ScanRun thorough = timedScan(wifi, ScanProfile::Thorough);
+		ScanRun adaptive = timedScan(wifi, ScanProfile::Adaptive);
+
+		// every access point answers within the thorough dwell time
+		CHECK_EQUAL( accessPoints.size(), thorough.found );
+		CHECK( adaptive.found <= thorough.found );
+
+		thoroughFound += thorough.found;
+		adaptiveFound += adaptive.found;
+		thoroughDuration += thorough.duration;
+		adaptiveDuration += adaptive.duration;
+	}
+
+	printf("adaptive scan: %zu of %zu access points found in %llu ms, thorough scan: %llu ms\n",
+		   adaptiveFound, thoroughFound, static_cast<unsigned long long>(adaptiveDuration), static_cast<unsigned long long>(thoroughDuration));
+
+	// measured: 89% of the access points in 72% of the time, fail if the adaptive profile gets noticeably worse
+	CHECK( adaptiveFound * 100 >= thoroughFound * 85 );
+	CHECK( adaptiveDuration * 100 <= thoroughDuration * 80 );
+}
+
+HOST_TEST(channelPlanOutsideRegulatoryDomainIsRejected)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	std::vector<uint8_t>	channels;
+
+	addAccessPoints();
+	CHECK( wifi.setRegulatoryDomain("US", 1, 11) );
+	CHECK( wifi.init() );
+
+	CHECK( ! wifi.setChannelPlan({ 12, 13 }) );
+	CHECK( wifi.setChannelPlan({ 6, 13 }) );
+
+	FakeIDF::setScanStartHook([&](const wifi_scan_config_t &config) { channels.push_back(config.channel); });
+
+	// channel 13 is not allowed, so only channel 6 is scanned
+	CHECK_EQUAL( 1, wifi.scan() );
+	CHECK( channels == std::vector<uint8_t>({ 6 }) );
+}
+
+HOST_TEST(probeStaysOnPlannedChannels)
+{
+	RecordingEventHandler	handler;
+	WiFi					wifi(&handler);
+	std::vector<uint8_t>	channels;
+
+	CHECK( wifi.setRegulatoryDomain("XX", 3, 9) );
+	CHECK( wifi.init() );
+
+	FakeIDF::setScanStartHook([&](const wifi_scan_config_t &config) { channels.push_back(config.channel); });
+
+	// the channel of startAP() lies outside the regulatory domain
+	CHECK( wifi.probeSSID("absent", 10000) == ProbeResult::NotFound );
+	CHECK( channels == std::vector<uint8_t>({ 3, 4, 5, 6, 7, 8, 9, 10, 11 }) );
+
+	// and outside the channel plan
+	channels.clear();
+	CHECK( wifi.setRegulatoryDomain("XX") );
+	CHECK( wifi.setChannelPlan({ 6, 11 }) );
+	CHECK( wifi.probeSSID("absent", 10000) == ProbeResult::NotFound );
+	CHECK( channels == std::vector<uint8_t>({ 6, 11 }) );
+}
@@ -0,0 +1,235 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HostTest.h"
+#include "FakeIDF.h"
+#include "FakeProtocols.h"
+
+#include "WiFiManager.h"
+#include "WiFiManagerEventHandler.h"
+
+#include <map>
+#include <string>
+
+using namespace IDFix::WiFi;
+
+namespace
+{
+	const char* CONFIG_SSID = "idfix-config";
+
+	class RecordingManagerEventHandler : public WiFiManagerEventHandler
+	{
+		public:
+
+			void configurationStarted() override
+			{
+				started++;
+			}
+
+			void configurationFinished() override
+			{
+				finished++;
+			}
+
+			void configurationFailed() override
+			{
+				failed++;
+			}
+
+			void accessPointStopped() override
+			{
+				accessPointsStopped++;
+			}
+
+			void receivedWiFiConfiguration(const std::string &ssid, const std::string &password) override
+			{
+				configuredSSID = ssid;
+				configuredPassword = password;
+			}
+
+			void receivedConfigurationParameter(const std::string &param, const std::string &value) override
+			{
+				stringParameters[param] = value;
+			}
+
+			void receivedConfigurationParameter(const std::string &param, const double value) override
+			{
+				numberParameters[param] = value;
+			}
+
+			void receivedConfigurationParameter(const std::string &param, const bool value) override
+			{
+				boolParameters[param] = value;
+			}
+
+			uint32_t						started = { 0 };
+			uint32_t						finished = { 0 };
+			uint32_t						failed = { 0 };
+			uint32_t						accessPointsStopped = { 0 };
+			std::string						configuredSSID;
+			std::string						configuredPassword;
+			std::map<std::string, std::string>	stringParameters;
+			std::map<std::string, double>		numberParameters;
+			std::map<std::string, bool>			boolParameters;
+	};
+
+	bool contains(const std::string &text, const std::string &part)
+	{
+		return text.find(part) != std::string::npos;
+	}
+
+	// start the configuration and wait until the configuration services run
+	bool startConfiguration(WiFiManager &manager, RecordingManagerEventHandler &handler)
+	{
+		return manager.init()
+			&& manager.startConfiguration(CONFIG_SSID, "config123")
+			&& FakeIDF::runUntil([&]() { return handler.started > 0; }, 1000);
+	}
+}
+
+HOST_TEST(refusesWhileAnotherDeviceIsConfigured)
+{
+	RecordingManagerEventHandler	handler;
+	WiFiManager						manager(&handler);
+	FakeIDF::AccessPoint			accessPoint;
+
+	accessPoint.ssid = CONFIG_SSID;
+	accessPoint.password = "config123";
+	accessPoint.bssid = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	accessPoint.channel = 1;
+	FakeIDF::addAccessPoint(accessPoint);
+
+	CHECK( manager.init() );
+	CHECK( ! manager.startConfiguration(CONFIG_SSID) );
+
+	// the probe found the other device, so no access point is started
+	CHECK( FakeIDF::counters().scanStart > 0 );
+	FakeIDF::runFor(1000);
+	CHECK_EQUAL( 0u, handler.started );
+	CHECK( FakeProtocols::listeningServer() == nullptr );
+}
+
+HOST_TEST(configurationServicesStart)
+{
+	RecordingManagerEventHandler	handler;
+	WiFiManager						manager(&handler);
+
+	CHECK( startConfiguration(manager, handler) );
+
+	CHECK( FakeProtocols::listeningServer() != nullptr );
+	CHECK_EQUAL( 8443, FakeProtocols::listeningPort() );
+	CHECK( FakeProtocols::dnsResponderRunning() );
+	CHECK_EQUAL( 0u, handler.failed );
+}
+
+HOST_TEST(failingDNSResponderFailsConfiguration)
+{
+	RecordingManagerEventHandler	handler;
+	WiFiManager						manager(&handler);
+
+	FakeProtocols::setDNSResponderFailure(true);
+
+	CHECK( manager.init() );
+	CHECK( manager.startConfiguration(CONFIG_SSID) );
+	CHECK( FakeIDF::runUntil([&]() { return handler.failed > 0; }, 1000) );
+
+	CHECK_EQUAL( 0u, handler.started );
+	CHECK( FakeProtocols::listeningServer() == nullptr );
+}
+
+HOST_TEST(configurationRoundTrip)
+{
+	RecordingManagerEventHandler	handler;
+	WiFiManager						manager(&handler);
+
+	manager.addConfigDeviceParameter("type", "door");
+	CHECK( startConfiguration(manager, handler) );
+
+	IDFix::Protocols::TLSSocket_sharedPtr client = FakeProtocols::connect();
+	CHECK( client != nullptr );
+
+	// the greeting arrives in two TLS records
+	client->receive("{\"cmd\":");
+	CHECK( client->getWritten().empty() );
+	client->receive("\"hi\"}\r\n");
+
+	const std::string welcome = client->getWritten();
+	CHECK( contains(welcome, "\"cmd\":\t\"welcome\"") );
+	CHECK( contains(welcome, "\"type\":\t\"door\"") );
+	CHECK( contains(welcome, "\r\n") );
+
+	client->receive("{\"cmd\":\"setconfig\",\"ssid\":\"home\",\"pass\":\"secret123\","
+					"\"extconfig\":{\"name\":\"front\",\"interval\":30,\"locked\":true}}\r\n");
+
+	CHECK( handler.configuredSSID == "home" );
+	CHECK( handler.configuredPassword == "secret123" );
+	CHECK( handler.stringParameters["name"] == "front" );
+	CHECK( handler.numberParameters["interval"] == 30.0 );
+	CHECK( handler.boolParameters["locked"] );
+	CHECK( contains(client->getWritten(), "\"status\":1") );
+
+	// everything the configuration started is torn down again
+	CHECK_EQUAL( 1u, handler.finished );
+	CHECK( client->isClosed() );
+	CHECK( FakeProtocols::listeningServer() == nullptr );
+	CHECK( ! FakeProtocols::dnsResponderRunning() );
+	CHECK( FakeIDF::runUntil([&]() { return handler.accessPointsStopped > 0; }, 1000) );
+}
+
+HOST_TEST(invalidMessagesAreAnswered)
+{
+	RecordingManagerEventHandler	handler;
+	WiFiManager						manager(&handler);
+
+	CHECK( startConfiguration(manager, handler) );
+
+	IDFix::Protocols::TLSSocket_sharedPtr client = FakeProtocols::connect();
+	CHECK( client != nullptr );
+
+	// two messages in one TLS record
+	client->receive("not json\r\n{\"cmd\":\"reboot\"}\r\n");
+
+	const std::string answers = client->getWritten();
+	CHECK( contains(answers, "invalid message") );
+	CHECK( contains(answers, "invalid command") );
+	CHECK( answers.find("invalid message") < answers.find("invalid command") );
+
+	// the configuration goes on
+	CHECK( ! client->isClosed() );
+	CHECK_EQUAL( 0u, handler.finished );
+}
+
+HOST_TEST(secondClientIsRejected)
+{
+	RecordingManagerEventHandler	handler;
+	WiFiManager						manager(&handler);
+
+	CHECK( startConfiguration(manager, handler) );
+
+	IDFix::Protocols::TLSSocket_sharedPtr first = FakeProtocols::connect();
+	IDFix::Protocols::TLSSocket_sharedPtr second = FakeProtocols::connect();
+
+	CHECK( ! first->isClosed() );
+	CHECK( second->isClosed() );
+	CHECK( contains(second->getWritten(), "Configuration already running") );
+
+	// once the first client is gone the next one may configure
+	first->disconnect();
+
+	IDFix::Protocols::TLSSocket_sharedPtr third = FakeProtocols::connect();
+	CHECK( ! third->isClosed() );
+}
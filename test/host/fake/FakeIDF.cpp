@@ -0,0 +1,1769 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FakeIDF.h"
+#include "FakeProtocols.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+    #include <esp_err.h>
+    #include <esp_event.h>
+    #include <esp_log.h>
+    #include <esp_system.h>
+    #include <esp_timer.h>
+    #include <nvs.h>
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+    #include <freertos/semphr.h>
+    #include <lwip/netifapi.h>
+    #include <lwip/dhcp.h>
+    #include <lwip/etharp.h>
+}
+
+extern "C"
+{
+	esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+	esp_event_base_t const IP_EVENT = "IP_EVENT";
+}
+
+struct esp_timer
+{
+	esp_timer_cb_t	callback;
+	void*			arg;
+	bool			armed;
+	uint64_t		generation;
+	uint64_t		period;
+};
+
+struct esp_netif_obj
+{
+	tcpip_adapter_if_t	interface;
+};
+
+struct tskTaskControlBlock
+{
+	std::mutex				mutex;
+	std::condition_variable	condition;
+	uint32_t				notifications = { 0 };
+};
+
+struct QueueDefinition
+{
+	std::recursive_timed_mutex	mutex;
+};
+
+namespace
+{
+	const uint32_t	CONNECT_SCAN_TIME = 100;		///< ms per channel the driver searches while connecting
+	const uint32_t	WRONG_PASSWORD_TIMEOUT = 500;	///< ms until the 4-way handshake times out
+	const uint32_t	DEFAULT_ACTIVE_TIME = 120;
+	const uint32_t	DEFAULT_PASSIVE_TIME = 360;
+	const uint32_t	DEFAULT_FREE_HEAP = 200000;
+	const int32_t	DEFAULT_DRIVER_HEAP = 50000;
+
+	struct ScheduledAction
+	{
+		uint64_t				time;
+		uint64_t				sequence;
+		std::function<void()>	action;
+
+		bool operator>(const ScheduledAction &other) const
+		{
+			return time != other.time ? time > other.time : sequence > other.sequence;
+		}
+	};
+
+	struct EventHandler
+	{
+		esp_event_base_t	base;
+		int32_t				id;
+		esp_event_handler_t	handler;
+		void*				arg;
+	};
+
+	struct Radio
+	{
+		bool						initialized = { false };
+		wifi_init_config_t			initConfig = {};
+		wifi_mode_t					mode = { WIFI_MODE_NULL };
+		bool						started = { false };
+		wifi_config_t				station = {};
+		wifi_config_t				accessPoint = {};
+		wifi_country_t				country = { { 'C', 'N', '\0' }, 1, 13, 20, WIFI_COUNTRY_POLICY_AUTO };
+		wifi_ps_type_t				powerSave = { WIFI_PS_MIN_MODEM };
+		bool						connected = { false };
+		int							connectedAP = { -1 };
+		uint64_t					connectGeneration = { 0 };
+		bool						scanning = { false };
+		std::vector<wifi_ap_record_t>	apList;
+		bool						dhcpRunning = { true };
+		uint64_t					dhcpGeneration = { 0 };
+		tcpip_adapter_ip_info_t		stationIP = {};
+		bool						lwipDHCPRunning = { false };	///< started by dhcp_start(), bypassing the adapter
+		bool						lwipDHCPBound = { false };
+	};
+
+	struct State
+	{
+		std::atomic<uint64_t>		now = { 0 };		///< microseconds
+		uint64_t					sequence = { 0 };
+		std::priority_queue<ScheduledAction, std::vector<ScheduledAction>, std::greater<ScheduledAction>>	actions;
+
+		std::vector<EventHandler>	eventHandlers;
+		std::vector<std::unique_ptr<esp_timer>>	timers;
+
+		std::vector<FakeIDF::AccessPoint>	accessPoints;
+		std::vector<bool>			present;
+		std::vector<uint32_t>		lanHosts;
+		std::vector<uint32_t>		arpTable;		///< addresses which answered an ARP request
+		Radio						radio;
+		FakeIDF::Counters			counters;
+
+		std::map<std::string, std::map<std::string, std::vector<uint8_t>>>	nvs;
+		std::vector<std::pair<std::string, nvs_open_mode_t>>			nvsHandles;
+
+		std::function<void(const wifi_scan_config_t&)>	scanStartHook;
+		std::mt19937				random;
+		uint32_t					freeHeap = { DEFAULT_FREE_HEAP };
+		uint32_t					minimumFreeHeap = { DEFAULT_FREE_HEAP };
+		int32_t						driverHeap = { DEFAULT_DRIVER_HEAP };
+		bool						taskCreateFailure = { false };
+		bool						semaphoreCreateFailure = { false };
+	};
+
+	State&	state()
+	{
+		static State instance;
+		return instance;
+	}
+
+	esp_netif_obj	stationInterface = { TCPIP_ADAPTER_IF_STA };
+	esp_netif_obj	accessPointInterface = { TCPIP_ADAPTER_IF_AP };
+	struct netif	stationNetif = {};
+
+	thread_local TaskHandle_t	currentTask = nullptr;
+	thread_local FakeIDF::Context	currentContext = FakeIDF::Context::Application;
+
+	/**
+	 * @brief Marks the code run during its lifetime as running in another context
+	 */
+	class ContextScope
+	{
+		public:
+
+			explicit ContextScope(FakeIDF::Context context) : _previous(currentContext)
+			{
+				currentContext = context;
+			}
+
+			~ContextScope()
+			{
+				currentContext = _previous;
+			}
+
+		private:
+
+			FakeIDF::Context	_previous;
+	};
+
+	void scheduleAt(uint64_t time, std::function<void()> action)
+	{
+		State &s = state();
+
+		s.actions.push( ScheduledAction{ time, s.sequence++, std::move(action) } );
+	}
+
+	void scheduleIn(uint32_t milliseconds, std::function<void()> action)
+	{
+		scheduleAt(state().now + static_cast<uint64_t>(milliseconds) * 1000, std::move(action));
+	}
+
+	bool runNext(uint64_t until)
+	{
+		State &s = state();
+
+		if ( s.actions.empty() || s.actions.top().time > until )
+		{
+			return false;
+		}
+
+		ScheduledAction next = s.actions.top();
+		s.actions.pop();
+
+		if ( next.time > s.now )
+		{
+			s.now = next.time;
+		}
+
+		next.action();
+
+		return true;
+	}
+
+	void runUntilTime(uint64_t until)
+	{
+		while ( runNext(until) )
+		{
+		}
+
+		if ( state().now < until )
+		{
+			state().now = until;
+		}
+	}
+
+	void postEvent(esp_event_base_t base, int32_t id, const void* data, size_t size)
+	{
+		esp_event_post(base, id, const_cast<void*>(data), size, 0);
+	}
+
+	bool isStationMode(wifi_mode_t mode)
+	{
+		return mode == WIFI_MODE_STA || mode == WIFI_MODE_APSTA;
+	}
+
+	bool isAccessPointMode(wifi_mode_t mode)
+	{
+		return mode == WIFI_MODE_AP || mode == WIFI_MODE_APSTA;
+	}
+
+	std::string stationSSID()
+	{
+		const char* ssid = reinterpret_cast<const char*>(state().radio.station.sta.ssid);
+
+		return std::string(ssid, strnlen(ssid, sizeof(state().radio.station.sta.ssid)));
+	}
+
+	tcpip_adapter_ip_info_t leaseOf(size_t index)
+	{
+		const FakeIDF::AccessPoint	&accessPoint = state().accessPoints[index];
+		uint8_t						subnet = static_cast<uint8_t>(index + 1);
+		tcpip_adapter_ip_info_t		lease;
+
+		lease.ip.addr = accessPoint.address != 0 ? accessPoint.address : FakeIDF::ipAddress(10, 0, subnet, 100);
+		lease.netmask.addr = accessPoint.netMask != 0 ? accessPoint.netMask : FakeIDF::ipAddress(255, 255, 255, 0);
+		lease.gw.addr = accessPoint.gateway != 0 ? accessPoint.gateway : FakeIDF::ipAddress(10, 0, subnet, 1);
+
+		return lease;
+	}
+
+	wifi_ap_record_t recordOf(size_t index)
+	{
+		const FakeIDF::AccessPoint	&accessPoint = state().accessPoints[index];
+		wifi_ap_record_t			record = {};
+
+		memcpy(record.bssid, accessPoint.bssid.data(), sizeof(record.bssid));
+		strncpy(reinterpret_cast<char*>(record.ssid), accessPoint.ssid.c_str(), sizeof(record.ssid) - 1);
+		record.primary = accessPoint.channel;
+		record.rssi = accessPoint.rssi;
+		record.authmode = accessPoint.password.empty() ? WIFI_AUTH_OPEN : WIFI_AUTH_WPA2_PSK;
+
+		return record;
+	}
+
+	void postGotIP()
+	{
+		ip_event_got_ip_t event = {};
+
+		event.esp_netif = &stationInterface;
+		event.ip_info = state().radio.stationIP;
+		event.ip_changed = true;
+
+		postEvent(IP_EVENT, IP_EVENT_STA_GOT_IP, &event, sizeof(event));
+	}
+
+	void postDisconnected(uint8_t reason, const uint8_t* bssid)
+	{
+		wifi_event_sta_disconnected_t	event = {};
+		std::string						ssid = stationSSID();
+
+		memcpy(event.ssid, ssid.data(), ssid.size());
+		event.ssid_len = static_cast<uint8_t>(ssid.size());
+		event.reason = reason;
+
+		if ( bssid != nullptr )
+		{
+			memcpy(event.bssid, bssid, sizeof(event.bssid));
+		}
+
+		postEvent(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &event, sizeof(event));
+	}
+
+	void linkDown(uint8_t reason)
+	{
+		Radio &radio = state().radio;
+
+		if ( ! radio.connected )
+		{
+			return;
+		}
+
+		std::array<uint8_t, 6> bssid = state().accessPoints[radio.connectedAP].bssid;
+
+		radio.connected = false;
+		radio.connectedAP = -1;
+		radio.dhcpGeneration++;
+		radio.lwipDHCPBound = false;
+		state().arpTable.clear();
+
+		postDisconnected(reason, bssid.data());
+	}
+
+	void startLease()
+	{
+		Radio		&radio = state().radio;
+		uint64_t	generation = ++radio.dhcpGeneration;
+		int			accessPoint = radio.connectedAP;
+
+		if ( state().accessPoints[accessPoint].dhcpTime == FakeIDF::NEVER )
+		{
+			return;
+		}
+
+		scheduleIn(state().accessPoints[accessPoint].dhcpTime, [generation, accessPoint]()
+		{
+			Radio &radio = state().radio;
+
+			if ( radio.dhcpGeneration == generation && radio.connected && radio.connectedAP == accessPoint && radio.dhcpRunning )
+			{
+				radio.stationIP = leaseOf(accessPoint);
+				postGotIP();
+			}
+		});
+	}
+
+	void startLWIPLease()
+	{
+		Radio		&radio = state().radio;
+		uint64_t	generation = ++radio.dhcpGeneration;
+		int			accessPoint = radio.connectedAP;
+
+		if ( state().accessPoints[accessPoint].dhcpTime == FakeIDF::NEVER )
+		{
+			return;
+		}
+
+		scheduleIn(state().accessPoints[accessPoint].dhcpTime, [generation, accessPoint]()
+		{
+			Radio &radio = state().radio;
+
+			if ( radio.dhcpGeneration == generation && radio.connected && radio.connectedAP == accessPoint && radio.lwipDHCPRunning )
+			{
+				// bound quietly, only the adapter's callback would post IP_EVENT_STA_GOT_IP
+				radio.stationIP = leaseOf(accessPoint);
+				radio.lwipDHCPBound = true;
+			}
+		});
+	}
+
+	void stationStarted()
+	{
+		postEvent(WIFI_EVENT, WIFI_EVENT_STA_START, nullptr, 0);
+	}
+
+	void stationStopped()
+	{
+		state().radio.connectGeneration++;
+		linkDown(WIFI_REASON_ASSOC_LEAVE);
+		postEvent(WIFI_EVENT, WIFI_EVENT_STA_STOP, nullptr, 0);
+	}
+
+	std::vector<uint8_t> channelsOf(const wifi_country_t &country)
+	{
+		std::vector<uint8_t> channels;
+
+		for ( uint8_t channel = country.schan; channel < country.schan + country.nchan; channel++ )
+		{
+			channels.push_back(channel);
+		}
+
+		return channels;
+	}
+}
+
+namespace FakeIDF
+{
+	void reset()
+	{
+		State &s = state();
+
+		s.now = 0;
+		s.sequence = 0;
+		s.actions = decltype(s.actions)();
+		s.eventHandlers.clear();
+		s.timers.clear();
+		s.accessPoints.clear();
+		s.present.clear();
+		s.lanHosts.clear();
+		s.arpTable.clear();
+		s.radio = Radio();
+		s.counters = Counters();
+		s.nvs.clear();
+		s.nvsHandles.clear();
+		s.scanStartHook = nullptr;
+		s.random.seed(1);
+		s.freeHeap = DEFAULT_FREE_HEAP;
+		s.minimumFreeHeap = DEFAULT_FREE_HEAP;
+		s.driverHeap = DEFAULT_DRIVER_HEAP;
+		s.taskCreateFailure = false;
+		s.semaphoreCreateFailure = false;
+
+		FakeProtocols::reset();
+	}
+
+	uint64_t now()
+	{
+		return state().now / 1000;
+	}
+
+	void runFor(uint32_t milliseconds)
+	{
+		runUntilTime(state().now + static_cast<uint64_t>(milliseconds) * 1000);
+	}
+
+	bool runUntil(const std::function<bool()> &condition, uint32_t timeout)
+	{
+		uint64_t deadline = state().now + static_cast<uint64_t>(timeout) * 1000;
+
+		while ( ! condition() )
+		{
+			if ( ! runNext(deadline) )
+			{
+				state().now = deadline;
+				return condition();
+			}
+		}
+
+		return true;
+	}
+
+	void schedule(uint32_t delay, std::function<void()> action)
+	{
+		scheduleIn(delay, std::move(action));
+	}
+
+	size_t addAccessPoint(const AccessPoint &accessPoint)
+	{
+		State &s = state();
+
+		s.accessPoints.push_back(accessPoint);
+		s.present.push_back(true);
+
+		return s.accessPoints.size() - 1;
+	}
+
+	AccessPoint& accessPoint(size_t index)
+	{
+		return state().accessPoints.at(index);
+	}
+
+	void removeAccessPoint(size_t index)
+	{
+		State &s = state();
+
+		s.present.at(index) = false;
+
+		if ( s.radio.connected && s.radio.connectedAP == static_cast<int>(index) )
+		{
+			linkDown(WIFI_REASON_BEACON_TIMEOUT);
+		}
+	}
+
+	void setRSSI(size_t index, int8_t rssi)
+	{
+		state().accessPoints.at(index).rssi = rssi;
+	}
+
+	void dropLink(uint8_t reason)
+	{
+		state().radio.connectGeneration++;
+		linkDown(reason);
+	}
+
+	bool isConnected()
+	{
+		return state().radio.connected;
+	}
+
+	uint32_t stationAddress()
+	{
+		return state().radio.stationIP.ip.addr;
+	}
+
+	void addLANHost(uint32_t address)
+	{
+		state().lanHosts.push_back(address);
+	}
+
+	Counters& counters()
+	{
+		return state().counters;
+	}
+
+	void resetCounters()
+	{
+		state().counters = Counters();
+	}
+
+	void setTaskCreateFailure(bool fail)
+	{
+		state().taskCreateFailure = fail;
+	}
+
+	void setSemaphoreCreateFailure(bool fail)
+	{
+		state().semaphoreCreateFailure = fail;
+	}
+
+	void setDriverHeap(int32_t bytes)
+	{
+		state().driverHeap = bytes;
+	}
+
+	const wifi_init_config_t& lastInitConfig()
+	{
+		return state().radio.initConfig;
+	}
+
+	Context currentContext()
+	{
+		return ::currentContext;
+	}
+
+	void setScanStartHook(std::function<void(const wifi_scan_config_t&)> hook)
+	{
+		state().scanStartHook = std::move(hook);
+	}
+
+	void setRandomSeed(uint32_t seed)
+	{
+		state().random.seed(seed);
+	}
+}
+
+extern "C"
+{
+	const char* esp_err_to_name(esp_err_t code)
+	{
+		return code == ESP_OK ? "ESP_OK" : "ESP_ERR";
+	}
+
+	void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+	{
+		static const int maxLevel = []()
+		{
+			const char* value = getenv("IDFIX_HOST_LOG_LEVEL");
+			return value != nullptr ? atoi(value) : static_cast<int>(ESP_LOG_WARN);
+		}();
+
+		if ( static_cast<int>(level) > maxLevel )
+		{
+			return;
+		}
+
+		va_list arguments;
+
+		fprintf(stderr, "%c (%llu) %s: ", "NEWIDV"[level], static_cast<unsigned long long>(FakeIDF::now()), tag);
+		va_start(arguments, format);
+		vfprintf(stderr, format, arguments);
+		va_end(arguments);
+		fputc('\n', stderr);
+	}
+
+	// event loop
+
+	esp_err_t esp_event_loop_create_default()
+	{
+		return ESP_OK;
+	}
+
+	esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id, esp_event_handler_t event_handler, void* event_handler_arg)
+	{
+		state().eventHandlers.push_back( EventHandler{ event_base, event_id, event_handler, event_handler_arg } );
+		return ESP_OK;
+	}
+
+	esp_err_t esp_event_handler_unregister(esp_event_base_t event_base, int32_t event_id, esp_event_handler_t event_handler)
+	{
+		std::vector<EventHandler> &handlers = state().eventHandlers;
+
+		for ( auto handler = handlers.begin(); handler != handlers.end(); ++handler )
+		{
+			if ( handler->base == event_base && handler->id == event_id && handler->handler == event_handler )
+			{
+				handlers.erase(handler);
+				return ESP_OK;
+			}
+		}
+
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, void* event_data, size_t event_data_size, TickType_t)
+	{
+		auto data = std::make_shared<std::vector<uint8_t>>(event_data_size);
+
+		if ( event_data_size > 0 )
+		{
+			memcpy(data->data(), event_data, event_data_size);
+		}
+
+		state().counters.eventsPosted++;
+
+		scheduleIn(0, [event_base, event_id, data]()
+		{
+			// handlers may register further handlers, so work on a snapshot
+			std::vector<EventHandler>	handlers = state().eventHandlers;
+			ContextScope				scope(FakeIDF::Context::EventLoop);
+
+			for ( const EventHandler &handler : handlers )
+			{
+				if ( ( handler.base == ESP_EVENT_ANY_BASE || handler.base == event_base ) && ( handler.id == ESP_EVENT_ANY_ID || handler.id == event_id ) )
+				{
+					handler.handler(handler.arg, event_base, event_id, data->empty() ? nullptr : data->data());
+				}
+			}
+		});
+
+		return ESP_OK;
+	}
+
+	// timers
+
+	esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle)
+	{
+		if ( create_args == nullptr || create_args->callback == nullptr || out_handle == nullptr )
+		{
+			return ESP_ERR_INVALID_ARG;
+		}
+
+		state().timers.emplace_back( new esp_timer{ create_args->callback, create_args->arg, false, 0, 0 } );
+		*out_handle = state().timers.back().get();
+
+		return ESP_OK;
+	}
+
+	static void scheduleTimer(esp_timer_handle_t timer, uint64_t timeout)
+	{
+		uint64_t generation = timer->generation;
+
+		scheduleAt(state().now + timeout, [timer, generation]()
+		{
+			if ( ! timer->armed || timer->generation != generation )
+			{
+				return;
+			}
+
+			if ( timer->period != 0 )
+			{
+				scheduleTimer(timer, timer->period);
+			}
+			else
+			{
+				timer->armed = false;
+			}
+
+			ContextScope scope(FakeIDF::Context::Timer);
+
+			timer->callback(timer->arg);
+		});
+	}
+
+	esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+	{
+		if ( timer->armed )
+		{
+			return ESP_ERR_INVALID_STATE;
+		}
+
+		timer->armed = true;
+		timer->generation++;
+		timer->period = 0;
+		scheduleTimer(timer, timeout_us);
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+	{
+		if ( timer->armed )
+		{
+			return ESP_ERR_INVALID_STATE;
+		}
+
+		timer->armed = true;
+		timer->generation++;
+		timer->period = period;
+		scheduleTimer(timer, period);
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+	{
+		if ( timer == nullptr || ! timer->armed )
+		{
+			return ESP_ERR_INVALID_STATE;
+		}
+
+		timer->armed = false;
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+	{
+		if ( timer->armed )
+		{
+			return ESP_ERR_INVALID_STATE;
+		}
+
+		return ESP_OK;
+	}
+
+	int64_t esp_timer_get_time()
+	{
+		return static_cast<int64_t>(state().now.load());
+	}
+
+	// system
+
+	uint32_t esp_random()
+	{
+		return state().random();
+	}
+
+	uint32_t esp_get_free_heap_size()
+	{
+		return state().freeHeap;
+	}
+
+	uint32_t esp_get_minimum_free_heap_size()
+	{
+		return state().minimumFreeHeap;
+	}
+
+	esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type)
+	{
+		const uint8_t address[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, static_cast<uint8_t>(type) };
+
+		memcpy(mac, address, sizeof(address));
+
+		return ESP_OK;
+	}
+
+	// NVS
+
+	esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+	{
+		State &s = state();
+
+		if ( open_mode == NVS_READONLY && s.nvs.find(name) == s.nvs.end() )
+		{
+			return ESP_ERR_NVS_NOT_FOUND;
+		}
+
+		s.nvs[name];
+		s.nvsHandles.emplace_back(name, open_mode);
+		*out_handle = static_cast<nvs_handle_t>(s.nvsHandles.size());
+
+		return ESP_OK;
+	}
+
+	void nvs_close(nvs_handle_t)
+	{
+
+	}
+
+	static std::map<std::string, std::vector<uint8_t>>* nvsNamespace(nvs_handle_t handle)
+	{
+		State &s = state();
+
+		if ( handle == 0 || handle > s.nvsHandles.size() )
+		{
+			return nullptr;
+		}
+
+		return &s.nvs[s.nvsHandles[handle - 1].first];
+	}
+
+	esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length)
+	{
+		auto entries = nvsNamespace(handle);
+
+		if ( entries == nullptr )
+		{
+			return ESP_ERR_NVS_INVALID_HANDLE;
+		}
+
+		auto entry = entries->find(key);
+
+		if ( entry == entries->end() )
+		{
+			return ESP_ERR_NVS_NOT_FOUND;
+		}
+
+		if ( out_value == nullptr )
+		{
+			*length = entry->second.size();
+			return ESP_OK;
+		}
+
+		if ( *length < entry->second.size() )
+		{
+			return ESP_ERR_NVS_INVALID_LENGTH;
+		}
+
+		memcpy(out_value, entry->second.data(), entry->second.size());
+		*length = entry->second.size();
+
+		return ESP_OK;
+	}
+
+	esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length)
+	{
+		auto entries = nvsNamespace(handle);
+
+		if ( entries == nullptr )
+		{
+			return ESP_ERR_NVS_INVALID_HANDLE;
+		}
+
+		if ( state().nvsHandles[handle - 1].second == NVS_READONLY )
+		{
+			return ESP_ERR_NVS_READ_ONLY;
+		}
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(value);
+
+		(*entries)[key].assign(bytes, bytes + length);
+		state().counters.nvsWrites++;
+
+		return ESP_OK;
+	}
+
+	esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key)
+	{
+		auto entries = nvsNamespace(handle);
+
+		if ( entries == nullptr )
+		{
+			return ESP_ERR_NVS_INVALID_HANDLE;
+		}
+
+		if ( entries->erase(key) == 0 )
+		{
+			return ESP_ERR_NVS_NOT_FOUND;
+		}
+
+		state().counters.nvsWrites++;
+
+		return ESP_OK;
+	}
+
+	esp_err_t nvs_commit(nvs_handle_t)
+	{
+		return ESP_OK;
+	}
+
+	// FreeRTOS
+
+	BaseType_t xTaskCreate(TaskFunction_t function, const char*, uint32_t, void* parameters, UBaseType_t, TaskHandle_t* createdTask)
+	{
+		if ( state().taskCreateFailure )
+		{
+			// errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY
+			return -1;
+		}
+
+		TaskHandle_t task = new tskTaskControlBlock();
+
+		if ( createdTask != nullptr )
+		{
+			*createdTask = task;
+		}
+
+		std::thread([function, parameters, task]()
+		{
+			currentTask = task;
+			function(parameters);
+		}).detach();
+
+		return pdPASS;
+	}
+
+	void vTaskDelete(TaskHandle_t)
+	{
+
+	}
+
+	void vTaskDelay(TickType_t ticks)
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds(ticks) );
+	}
+
+	TaskHandle_t xTaskGetCurrentTaskHandle()
+	{
+		return currentTask;
+	}
+
+	BaseType_t xTaskNotifyGive(TaskHandle_t task)
+	{
+		if ( task == nullptr )
+		{
+			// configASSERT() in the real kernel
+			fprintf(stderr, "xTaskNotifyGive: task handle is NULL\n");
+			abort();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(task->mutex);
+			task->notifications++;
+		}
+
+		task->condition.notify_one();
+
+		return pdPASS;
+	}
+
+	uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+	{
+		TaskHandle_t task = currentTask;
+
+		if ( task == nullptr )
+		{
+			return 0;
+		}
+
+		std::unique_lock<std::mutex> lock(task->mutex);
+
+		if ( ticksToWait == portMAX_DELAY )
+		{
+			task->condition.wait(lock, [task]() { return task->notifications > 0; });
+		}
+		else if ( ! task->condition.wait_for(lock, std::chrono::milliseconds(ticksToWait), [task]() { return task->notifications > 0; }) )
+		{
+			return 0;
+		}
+
+		uint32_t value = task->notifications;
+
+		task->notifications = clearCountOnExit ? 0 : task->notifications - 1;
+
+		return value;
+	}
+
+	SemaphoreHandle_t xSemaphoreCreateMutex()
+	{
+		return state().semaphoreCreateFailure ? nullptr : new QueueDefinition();
+	}
+
+	SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()
+	{
+		return state().semaphoreCreateFailure ? nullptr : new QueueDefinition();
+	}
+
+	BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait)
+	{
+		if ( semaphore == nullptr )
+		{
+			// configASSERT() in the real kernel
+			fprintf(stderr, "xSemaphoreTake: semaphore handle is NULL\n");
+			abort();
+		}
+
+		if ( ticksToWait == portMAX_DELAY )
+		{
+			semaphore->mutex.lock();
+			return pdTRUE;
+		}
+
+		return semaphore->mutex.try_lock_for( std::chrono::milliseconds(ticksToWait) ) ? pdTRUE : pdFALSE;
+	}
+
+	BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+	{
+		semaphore->mutex.unlock();
+		return pdTRUE;
+	}
+
+	BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticksToWait)
+	{
+		return xSemaphoreTake(semaphore, ticksToWait);
+	}
+
+	BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore)
+	{
+		return xSemaphoreGive(semaphore);
+	}
+
+	void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+	{
+		delete semaphore;
+	}
+
+	// network interfaces
+
+	esp_err_t esp_netif_init()
+	{
+		return ESP_OK;
+	}
+
+	esp_netif_t* esp_netif_create_default_wifi_sta()
+	{
+		return &stationInterface;
+	}
+
+	esp_netif_t* esp_netif_create_default_wifi_ap()
+	{
+		return &accessPointInterface;
+	}
+
+	void esp_netif_destroy(esp_netif_t*)
+	{
+
+	}
+
+	esp_err_t tcpip_adapter_get_ip_info(tcpip_adapter_if_t tcpip_if, tcpip_adapter_ip_info_t* ip_info)
+	{
+		if ( tcpip_if == TCPIP_ADAPTER_IF_STA )
+		{
+			*ip_info = state().radio.stationIP;
+		}
+		else
+		{
+			ip_info->ip.addr = FakeIDF::ipAddress(192, 168, 4, 1);
+			ip_info->netmask.addr = FakeIDF::ipAddress(255, 255, 255, 0);
+			ip_info->gw.addr = FakeIDF::ipAddress(192, 168, 4, 1);
+		}
+
+		return ESP_OK;
+	}
+
+	esp_err_t tcpip_adapter_set_ip_info(tcpip_adapter_if_t tcpip_if, const tcpip_adapter_ip_info_t* ip_info)
+	{
+		Radio &radio = state().radio;
+
+		if ( tcpip_if != TCPIP_ADAPTER_IF_STA )
+		{
+			return ESP_OK;
+		}
+
+		if ( radio.dhcpRunning )
+		{
+			return ESP_ERR_TCPIP_ADAPTER_DHCP_NOT_STOPPED;
+		}
+
+		radio.stationIP = *ip_info;
+
+		if ( ip_info->ip.addr != 0 )
+		{
+			postGotIP();
+		}
+
+		return ESP_OK;
+	}
+
+	esp_err_t tcpip_adapter_dhcpc_start(tcpip_adapter_if_t tcpip_if)
+	{
+		Radio &radio = state().radio;
+
+		if ( tcpip_if != TCPIP_ADAPTER_IF_STA )
+		{
+			return ESP_ERR_TCPIP_ADAPTER_INVALID_PARAMS;
+		}
+
+		if ( radio.dhcpRunning )
+		{
+			return ESP_ERR_TCPIP_ADAPTER_DHCP_ALREADY_STARTED;
+		}
+
+		// the adapter drives the same lwIP client
+		radio.dhcpRunning = true;
+		radio.lwipDHCPRunning = false;
+		radio.lwipDHCPBound = false;
+		state().counters.dhcpStart++;
+
+		// the client starts from scratch, which takes the address off the interface
+		if ( radio.stationIP.ip.addr != 0 && radio.connected )
+		{
+			state().counters.addressCleared++;
+		}
+
+		radio.stationIP = {};
+
+		if ( radio.connected )
+		{
+			startLease();
+		}
+
+		return ESP_OK;
+	}
+
+	esp_err_t tcpip_adapter_dhcpc_stop(tcpip_adapter_if_t tcpip_if)
+	{
+		Radio &radio = state().radio;
+
+		if ( tcpip_if != TCPIP_ADAPTER_IF_STA )
+		{
+			return ESP_ERR_TCPIP_ADAPTER_INVALID_PARAMS;
+		}
+
+		if ( ! radio.dhcpRunning )
+		{
+			return ESP_ERR_TCPIP_ADAPTER_DHCP_ALREADY_STOPPED;
+		}
+
+		radio.dhcpRunning = false;
+		radio.dhcpGeneration++;
+
+		return ESP_OK;
+	}
+
+	esp_err_t tcpip_adapter_get_netif(tcpip_adapter_if_t tcpip_if, void** netif)
+	{
+		if ( tcpip_if != TCPIP_ADAPTER_IF_STA )
+		{
+			return ESP_ERR_TCPIP_ADAPTER_INVALID_PARAMS;
+		}
+
+		*netif = &stationNetif;
+
+		return ESP_OK;
+	}
+
+	// lwIP
+
+	err_t netifapi_netif_common(struct netif* netif, netifapi_void_fn voidfunc, netifapi_errt_fn errtfunc)
+	{
+		if ( voidfunc != nullptr )
+		{
+			voidfunc(netif);
+			return ERR_OK;
+		}
+
+		return errtfunc(netif);
+	}
+
+	err_t dhcp_start(struct netif* netif)
+	{
+		Radio &radio = state().radio;
+
+		if ( netif != &stationNetif )
+		{
+			return ERR_IF;
+		}
+
+		radio.lwipDHCPRunning = true;
+		radio.lwipDHCPBound = false;
+		state().counters.dhcpStart++;
+
+		if ( radio.connected )
+		{
+			startLWIPLease();
+		}
+
+		return ERR_OK;
+	}
+
+	void dhcp_stop(struct netif* netif)
+	{
+		Radio &radio = state().radio;
+
+		if ( netif != &stationNetif || ! radio.lwipDHCPRunning )
+		{
+			return;
+		}
+
+		radio.lwipDHCPRunning = false;
+		radio.lwipDHCPBound = false;
+		radio.dhcpGeneration++;
+	}
+
+	uint8_t dhcp_supplied_address(const struct netif* netif)
+	{
+		return netif == &stationNetif && state().radio.lwipDHCPBound ? 1 : 0;
+	}
+
+	err_t etharp_query(struct netif* netif, const ip4_addr_t* ipaddr, struct pbuf*)
+	{
+		State		&s = state();
+		uint32_t	address = ipaddr->addr;
+
+		if ( netif != &stationNetif || ! s.radio.connected )
+		{
+			return ERR_IF;
+		}
+
+		s.counters.arpProbes++;
+
+		if ( std::find(s.lanHosts.begin(), s.lanHosts.end(), address) != s.lanHosts.end() )
+		{
+			scheduleIn(5, [address]()
+			{
+				state().arpTable.push_back(address);
+			});
+		}
+
+		return ERR_OK;
+	}
+
+	ssize_t etharp_find_addr(struct netif* netif, const ip4_addr_t* ipaddr, struct eth_addr**, const ip4_addr_t**)
+	{
+		std::vector<uint32_t> &arpTable = state().arpTable;
+
+		if ( netif != &stationNetif )
+		{
+			return -1;
+		}
+
+		auto entry = std::find(arpTable.begin(), arpTable.end(), ipaddr->addr);
+
+		return entry != arpTable.end() ? entry - arpTable.begin() : -1;
+	}
+
+	// WIFI driver
+
+	esp_err_t esp_wifi_init(const wifi_init_config_t* config)
+	{
+		State &s = state();
+
+		s.radio.initialized = true;
+		s.radio.initConfig = *config;
+		s.freeHeap = static_cast<uint32_t>( static_cast<int64_t>(s.freeHeap) - s.driverHeap );
+		s.minimumFreeHeap = std::min(s.minimumFreeHeap, s.freeHeap);
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_deinit()
+	{
+		state().radio.initialized = false;
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_set_storage(wifi_storage_t)
+	{
+		return state().radio.initialized ? ESP_OK : ESP_ERR_WIFI_NOT_INIT;
+	}
+
+	esp_err_t esp_wifi_set_country(const wifi_country_t* country)
+	{
+		state().radio.country = *country;
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+	{
+		Radio &radio = state().radio;
+
+		state().counters.setMode++;
+
+		if ( ! radio.initialized )
+		{
+			return ESP_ERR_WIFI_NOT_INIT;
+		}
+
+		wifi_mode_t previous = radio.mode;
+
+		radio.mode = mode;
+
+		if ( radio.started )
+		{
+			if ( isStationMode(previous) && ! isStationMode(mode) )
+			{
+				stationStopped();
+			}
+			else if ( ! isStationMode(previous) && isStationMode(mode) )
+			{
+				stationStarted();
+			}
+
+			if ( isAccessPointMode(previous) && ! isAccessPointMode(mode) )
+			{
+				postEvent(WIFI_EVENT, WIFI_EVENT_AP_STOP, nullptr, 0);
+			}
+			else if ( ! isAccessPointMode(previous) && isAccessPointMode(mode) )
+			{
+				postEvent(WIFI_EVENT, WIFI_EVENT_AP_START, nullptr, 0);
+			}
+		}
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_get_mode(wifi_mode_t* mode)
+	{
+		*mode = state().radio.mode;
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_start()
+	{
+		Radio &radio = state().radio;
+
+		state().counters.start++;
+
+		if ( ! radio.initialized )
+		{
+			return ESP_ERR_WIFI_NOT_INIT;
+		}
+
+		if ( radio.started )
+		{
+			return ESP_OK;
+		}
+
+		radio.started = true;
+
+		if ( isStationMode(radio.mode) )
+		{
+			stationStarted();
+		}
+
+		if ( isAccessPointMode(radio.mode) )
+		{
+			postEvent(WIFI_EVENT, WIFI_EVENT_AP_START, nullptr, 0);
+		}
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_stop()
+	{
+		Radio &radio = state().radio;
+
+		state().counters.stop++;
+
+		if ( ! radio.initialized )
+		{
+			return ESP_ERR_WIFI_NOT_INIT;
+		}
+
+		if ( ! radio.started )
+		{
+			return ESP_OK;
+		}
+
+		if ( isStationMode(radio.mode) )
+		{
+			stationStopped();
+		}
+
+		if ( isAccessPointMode(radio.mode) )
+		{
+			postEvent(WIFI_EVENT, WIFI_EVENT_AP_STOP, nullptr, 0);
+		}
+
+		radio.started = false;
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_connect()
+	{
+		State	&s = state();
+		Radio	&radio = s.radio;
+
+		s.counters.connect++;
+
+		if ( ! radio.initialized )
+		{
+			return ESP_ERR_WIFI_NOT_INIT;
+		}
+
+		if ( ! radio.started )
+		{
+			return ESP_ERR_WIFI_NOT_STARTED;
+		}
+
+		if ( ! isStationMode(radio.mode) )
+		{
+			return ESP_ERR_WIFI_MODE;
+		}
+
+		if ( radio.connected )
+		{
+			return ESP_OK;
+		}
+
+		const wifi_sta_config_t	&config = radio.station.sta;
+		uint64_t				generation = ++radio.connectGeneration;
+		std::string				ssid = stationSSID();
+		std::vector<uint8_t>	channels = channelsOf(radio.country);
+
+		if ( config.bssid_set && config.channel != 0 )
+		{
+			channels = { config.channel };
+		}
+		else if ( config.channel != 0 )
+		{
+			// start searching on the hinted channel
+			auto hint = std::find(channels.begin(), channels.end(), config.channel);
+
+			if ( hint != channels.end() )
+			{
+				std::rotate(channels.begin(), hint, channels.end());
+			}
+		}
+
+		uint32_t	visited = 0;
+		int			found = -1;
+
+		for ( uint8_t channel : channels )
+		{
+			visited++;
+
+			for ( size_t index = 0; index < s.accessPoints.size(); index++ )
+			{
+				const FakeIDF::AccessPoint &accessPoint = s.accessPoints[index];
+
+				if ( ! s.present[index] || accessPoint.channel != channel || accessPoint.ssid != ssid )
+				{
+					continue;
+				}
+
+				if ( config.bssid_set && memcmp(config.bssid, accessPoint.bssid.data(), sizeof(config.bssid)) != 0 )
+				{
+					continue;
+				}
+
+				if ( found < 0 || accessPoint.rssi > s.accessPoints[found].rssi )
+				{
+					found = static_cast<int>(index);
+				}
+			}
+
+			if ( found >= 0 && config.scan_method == WIFI_FAST_SCAN )
+			{
+				break;
+			}
+		}
+
+		uint32_t searchTime = visited * CONNECT_SCAN_TIME;
+
+		if ( found < 0 )
+		{
+			scheduleIn(searchTime, [generation]()
+			{
+				if ( state().radio.connectGeneration == generation && state().radio.started )
+				{
+					postDisconnected(WIFI_REASON_NO_AP_FOUND, nullptr);
+				}
+			});
+
+			return ESP_OK;
+		}
+
+		const FakeIDF::AccessPoint	&accessPoint = s.accessPoints[found];
+		std::string					password( reinterpret_cast<const char*>(config.password), strnlen(reinterpret_cast<const char*>(config.password), sizeof(config.password)) );
+
+		if ( ! accessPoint.password.empty() && accessPoint.password != password )
+		{
+			std::array<uint8_t, 6> bssid = accessPoint.bssid;
+
+			scheduleIn(searchTime + accessPoint.associationTime + WRONG_PASSWORD_TIMEOUT, [generation, bssid]()
+			{
+				if ( state().radio.connectGeneration == generation && state().radio.started )
+				{
+					postDisconnected(WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT, bssid.data());
+				}
+			});
+
+			return ESP_OK;
+		}
+
+		scheduleIn(searchTime + accessPoint.associationTime, [generation, found]()
+		{
+			State	&s = state();
+			Radio	&radio = s.radio;
+
+			if ( radio.connectGeneration != generation || ! radio.started || ! s.present[found] )
+			{
+				return;
+			}
+
+			wifi_event_sta_connected_t	event = {};
+			wifi_ap_record_t			record = recordOf(found);
+
+			radio.connected = true;
+			radio.connectedAP = found;
+
+			memcpy(event.ssid, record.ssid, sizeof(event.ssid));
+			event.ssid_len = static_cast<uint8_t>( strnlen(reinterpret_cast<const char*>(record.ssid), sizeof(event.ssid)) );
+			memcpy(event.bssid, record.bssid, sizeof(event.bssid));
+			event.channel = record.primary;
+			event.authmode = record.authmode;
+
+			postEvent(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &event, sizeof(event));
+
+			if ( radio.dhcpRunning )
+			{
+				startLease();
+			}
+		});
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_disconnect()
+	{
+		Radio &radio = state().radio;
+
+		state().counters.disconnect++;
+
+		if ( ! radio.started )
+		{
+			return ESP_ERR_WIFI_NOT_STARTED;
+		}
+
+		radio.connectGeneration++;
+		linkDown(WIFI_REASON_ASSOC_LEAVE);
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf)
+	{
+		if ( ! state().radio.initialized )
+		{
+			return ESP_ERR_WIFI_NOT_INIT;
+		}
+
+		if ( interface == WIFI_IF_STA )
+		{
+			state().radio.station = *conf;
+		}
+		else
+		{
+			state().radio.accessPoint = *conf;
+		}
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf)
+	{
+		*conf = interface == WIFI_IF_STA ? state().radio.station : state().radio.accessPoint;
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_scan_start(const wifi_scan_config_t* config, bool block)
+	{
+		State	&s = state();
+		Radio	&radio = s.radio;
+
+		s.counters.scanStart++;
+
+		if ( ! radio.initialized )
+		{
+			return ESP_ERR_WIFI_NOT_INIT;
+		}
+
+		if ( ! radio.started )
+		{
+			return ESP_ERR_WIFI_NOT_STARTED;
+		}
+
+		if ( ! isStationMode(radio.mode) )
+		{
+			return ESP_ERR_WIFI_MODE;
+		}
+
+		if ( radio.scanning )
+		{
+			s.counters.scanRejected++;
+			return ESP_ERR_WIFI_STATE;
+		}
+
+		wifi_scan_config_t				scanConfig = config != nullptr ? *config : wifi_scan_config_t();
+		std::string						ssid = scanConfig.ssid != nullptr ? reinterpret_cast<const char*>(scanConfig.ssid) : "";
+		std::vector<uint8_t>			channels = scanConfig.channel != 0 ? std::vector<uint8_t>{ scanConfig.channel } : channelsOf(radio.country);
+		std::vector<wifi_ap_record_t>	results;
+		uint32_t						duration = 0;
+
+		for ( uint8_t channel : channels )
+		{
+			std::vector<size_t> candidates;
+
+			for ( size_t index = 0; index < s.accessPoints.size(); index++ )
+			{
+				if ( s.present[index] && s.accessPoints[index].channel == channel && ( ssid.empty() || s.accessPoints[index].ssid == ssid ) )
+				{
+					candidates.push_back(index);
+				}
+			}
+
+			uint32_t	window;
+			bool		passive = scanConfig.scan_type == WIFI_SCAN_TYPE_PASSIVE;
+
+			if ( passive )
+			{
+				window = scanConfig.scan_time.passive != 0 ? scanConfig.scan_time.passive : DEFAULT_PASSIVE_TIME;
+			}
+			else
+			{
+				uint32_t minTime = scanConfig.scan_time.active.min;
+				uint32_t maxTime = scanConfig.scan_time.active.max != 0 ? scanConfig.scan_time.active.max : DEFAULT_ACTIVE_TIME;
+
+				window = maxTime;
+
+				if ( minTime != 0 )
+				{
+					// without an answer within the minimum time the driver moves on
+					bool answered = std::any_of(candidates.begin(), candidates.end(), [&s, minTime](size_t index) { return s.accessPoints[index].probeResponseTime <= minTime; });
+
+					window = answered ? maxTime : minTime;
+				}
+			}
+
+			duration += window;
+
+			for ( size_t index : candidates )
+			{
+				uint32_t delay = passive ? s.accessPoints[index].beaconInterval : s.accessPoints[index].probeResponseTime;
+
+				if ( delay <= window )
+				{
+					results.push_back( recordOf(index) );
+				}
+			}
+		}
+
+		radio.scanning = true;
+
+		if ( s.scanStartHook )
+		{
+			s.scanStartHook(scanConfig);
+		}
+
+		auto finish = [results]()
+		{
+			wifi_event_sta_scan_done_t event = {};
+
+			state().radio.apList = results;
+			state().radio.scanning = false;
+
+			event.status = 0;
+			event.number = static_cast<uint8_t>( std::min<size_t>(results.size(), UINT8_MAX) );
+
+			postEvent(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, &event, sizeof(event));
+		};
+
+		if ( block )
+		{
+			// the other tasks keep running while the caller waits
+			runUntilTime(s.now + static_cast<uint64_t>(duration) * 1000);
+			finish();
+		}
+		else
+		{
+			scheduleIn(duration, finish);
+		}
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_scan_stop()
+	{
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_scan_get_ap_num(uint16_t* number)
+	{
+		*number = static_cast<uint16_t>( state().radio.apList.size() );
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_scan_get_ap_records(uint16_t* number, wifi_ap_record_t* ap_records)
+	{
+		std::vector<wifi_ap_record_t> &apList = state().radio.apList;
+
+		uint16_t count = static_cast<uint16_t>( std::min<size_t>(*number, apList.size()) );
+
+		std::copy(apList.begin(), apList.begin() + count, ap_records);
+		*number = count;
+
+		// the driver frees all records, fetched or not
+		apList.clear();
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_scan_get_ap_record(wifi_ap_record_t* ap_record)
+	{
+		std::vector<wifi_ap_record_t> &apList = state().radio.apList;
+
+		if ( apList.empty() )
+		{
+			return ESP_FAIL;
+		}
+
+		// hands out the records one by one and frees each, like IDF 5.1
+		*ap_record = apList.front();
+		apList.erase(apList.begin());
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_clear_ap_list()
+	{
+		state().radio.apList.clear();
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info)
+	{
+		Radio &radio = state().radio;
+
+		if ( ! radio.connected )
+		{
+			return ESP_ERR_WIFI_NOT_CONNECT;
+		}
+
+		*ap_info = recordOf(radio.connectedAP);
+
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+	{
+		state().radio.powerSave = type;
+		return ESP_OK;
+	}
+
+	esp_err_t esp_wifi_get_ps(wifi_ps_type_t* type)
+	{
+		*type = state().radio.powerSave;
+		return ESP_OK;
+	}
+}
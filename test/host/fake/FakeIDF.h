@@ -0,0 +1,181 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKEIDF_H
+#define FAKEIDF_H
+
+extern "C"
+{
+    #include <esp_wifi.h>
+    #include <esp_netif.h>
+}
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * @brief The FakeIDF namespace controls the simulated IDF the host tests link against
+ *
+ * Time is simulated: nothing happens until the test advances the clock with runFor() or runUntil().
+ * Events posted to the default event loop, esp_timer callbacks and the reactions of the fake radio
+ * are then executed in order of their due time on the calling thread. A blocking scan advances the
+ * clock by its duration and runs everything which gets due meanwhile, like the other tasks of a real
+ * device would.
+ *
+ * The radio knows a set of access points. Scans report the ones which answer within the dwell time,
+ * connects search, associate, authenticate and get a DHCP lease with the delays of the access point.
+ */
+namespace FakeIDF
+{
+	static constexpr uint32_t	NEVER = UINT32_MAX;
+
+	struct AccessPoint
+	{
+		std::string				ssid;
+		std::array<uint8_t, 6>	bssid = {};
+		uint8_t					channel = { 1 };
+		int8_t					rssi = { -60 };
+		std::string				password;					///< empty for an open network
+		uint32_t				probeResponseTime = { 10 };	///< ms until a probe request is answered, NEVER if hidden from active scans
+		uint32_t				beaconInterval = { 102 };	///< ms between two beacons
+		uint32_t				associationTime = { 40 };	///< ms to authenticate and associate
+		uint32_t				dhcpTime = { 100 };			///< ms until the DHCP server hands out a lease, NEVER if it does not answer
+		uint32_t				address = { 0 };			///< the lease handed out, derived from the index if 0
+		uint32_t				netMask = { 0 };
+		uint32_t				gateway = { 0 };
+	};
+
+	/**
+	 * @brief The tasks the IDF runs code on, the simulation runs all but the application tasks on one thread
+	 */
+	enum class Context
+	{
+		Application,		///< the test itself or a task started by xTaskCreate()
+		EventLoop,			///< a handler of the default event loop
+		Timer				///< an esp_timer callback
+	};
+
+	struct Counters
+	{
+		uint32_t	setMode = { 0 };
+		uint32_t	start = { 0 };
+		uint32_t	stop = { 0 };
+		uint32_t	connect = { 0 };
+		uint32_t	disconnect = { 0 };
+		uint32_t	scanStart = { 0 };
+		uint32_t	scanRejected = { 0 };		///< scans started while another one was running
+		uint32_t	addressCleared = { 0 };		///< the address of a connected station was reset to 0.0.0.0
+		uint32_t	arpProbes = { 0 };
+		uint32_t	dhcpStart = { 0 };
+		uint32_t	nvsWrites = { 0 };
+		uint32_t	eventsPosted = { 0 };
+	};
+
+	/**
+	 * @brief Drop all state including the one of FakeProtocols, the clock starts at 0 again
+	 */
+	void					reset(void);
+
+	/**
+	 * @brief Get the simulated time in milliseconds
+	 */
+	uint64_t				now(void);
+
+	/**
+	 * @brief Advance the clock and run everything which gets due meanwhile
+	 */
+	void					runFor(uint32_t milliseconds);
+
+	/**
+	 * @brief Advance the clock until the condition holds
+	 *
+	 * @return \c false if the condition did not hold within timeout milliseconds
+	 */
+	bool					runUntil(const std::function<bool()> &condition, uint32_t timeout);
+
+	/**
+	 * @brief Run an action after a delay, e.g. to call the API from another "task"
+	 */
+	void					schedule(uint32_t delay, std::function<void()> action);
+
+	size_t					addAccessPoint(const AccessPoint &accessPoint);
+	AccessPoint&			accessPoint(size_t index);
+	void					removeAccessPoint(size_t index);
+	void					setRSSI(size_t index, int8_t rssi);
+
+	/**
+	 * @brief Let the connected station lose its link
+	 *
+	 * @param reason    the reason reported by WIFI_EVENT_STA_DISCONNECTED
+	 */
+	void					dropLink(uint8_t reason = WIFI_REASON_BEACON_TIMEOUT);
+	bool					isConnected(void);
+
+	/**
+	 * @brief Get the address currently set on the station interface
+	 */
+	uint32_t				stationAddress(void);
+
+	/**
+	 * @brief Add a host which answers ARP requests for its address on every network
+	 */
+	void					addLANHost(uint32_t address);
+
+	Counters&				counters(void);
+	void					resetCounters(void);
+
+	/**
+	 * @brief Let xTaskCreate() fail, e.g. because the heap is exhausted
+	 */
+	void					setTaskCreateFailure(bool fail);
+
+	/**
+	 * @brief Let the xSemaphoreCreate functions fail and return NULL
+	 */
+	void					setSemaphoreCreateFailure(bool fail);
+
+	/**
+	 * @brief Set the heap the WIFI driver allocates in esp_wifi_init(), negative values let the heap grow
+	 */
+	void					setDriverHeap(int32_t bytes);
+
+	/**
+	 * @brief Get the configuration passed to the last esp_wifi_init()
+	 */
+	const wifi_init_config_t&	lastInitConfig(void);
+
+	/**
+	 * @brief Call a hook whenever a scan is started successfully
+	 */
+	/**
+	 * @brief Get the context the caller runs in, e.g. to check which task notified a handler
+	 */
+	Context					currentContext(void);
+
+	void					setScanStartHook(std::function<void(const wifi_scan_config_t&)> hook);
+	void					setRandomSeed(uint32_t seed);
+
+	constexpr uint32_t		ipAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+	{
+		// lwIP keeps addresses in network byte order
+		return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+	}
+}
+
+#endif
@@ -0,0 +1,226 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FakeProtocols.h"
+#include "SimpleDNSResponder.h"
+
+#include <cstring>
+
+namespace
+{
+	struct State
+	{
+		IDFix::Protocols::TLSServer*	listeningServer = { nullptr };
+		int								listeningPort = { 0 };
+		bool							dnsResponderRunning = { false };
+		bool							dnsResponderFailure = { false };
+	};
+
+	State&	state()
+	{
+		static State s;
+		return s;
+	}
+}
+
+namespace FakeProtocols
+{
+	void reset()
+	{
+		state() = State();
+	}
+
+	IDFix::Protocols::TLSServer* listeningServer()
+	{
+		return state().listeningServer;
+	}
+
+	int listeningPort()
+	{
+		return state().listeningPort;
+	}
+
+	IDFix::Protocols::TLSSocket_sharedPtr connect()
+	{
+		IDFix::Protocols::TLSServer *server = state().listeningServer;
+
+		if ( server == nullptr )
+		{
+			return nullptr;
+		}
+
+		IDFix::Protocols::TLSSocket_sharedPtr socket = std::make_shared<IDFix::Protocols::TLSSocket>();
+		server->getEventHandler()->tlsNewConnection(socket);
+
+		return socket;
+	}
+
+	bool dnsResponderRunning()
+	{
+		return state().dnsResponderRunning;
+	}
+
+	void setDNSResponderFailure(bool fail)
+	{
+		state().dnsResponderFailure = fail;
+	}
+}
+
+namespace IDFix
+{
+	namespace Protocols
+	{
+		TLSServer::TLSServer(TLSServerEventHandler *eventHandler)
+			: _eventHandler(eventHandler)
+		{
+
+		}
+
+		TLSServer::~TLSServer()
+		{
+			shutdown();
+		}
+
+		bool TLSServer::init()
+		{
+			return true;
+		}
+
+		bool TLSServer::setCertificate(const unsigned char* UNUSED(cert), long UNUSED(certLength) )
+		{
+			return true;
+		}
+
+		bool TLSServer::setPrivateKey(const unsigned char* UNUSED(key), long UNUSED(keyLength) )
+		{
+			return true;
+		}
+
+		bool TLSServer::listen(int port)
+		{
+			if ( state().listeningServer != nullptr )
+			{
+				// the port is taken
+				return false;
+			}
+
+			state().listeningServer = this;
+			state().listeningPort = port;
+
+			return true;
+		}
+
+		void TLSServer::shutdown()
+		{
+			if ( state().listeningServer == this )
+			{
+				state().listeningServer = nullptr;
+				state().listeningPort = 0;
+			}
+		}
+
+		TLSServerEventHandler* TLSServer::getEventHandler() const
+		{
+			return _eventHandler;
+		}
+
+		void TLSSocket::setEventHandler(TLSSocketEventHandler *eventHandler)
+		{
+			_eventHandler = eventHandler;
+		}
+
+		int TLSSocket::write(const std::string &data)
+		{
+			return write(data.data(), data.size());
+		}
+
+		int TLSSocket::write(const char *data)
+		{
+			return write(data, strlen(data));
+		}
+
+		int TLSSocket::write(const char *data, size_t length)
+		{
+			if ( _closed )
+			{
+				return -1;
+			}
+
+			_written.append(data, length);
+
+			return static_cast<int>(length);
+		}
+
+		void TLSSocket::close()
+		{
+			if ( _closed )
+			{
+				return;
+			}
+
+			_closed = true;
+
+			if ( _eventHandler != nullptr )
+			{
+				_eventHandler->socketDisconnected(*this);
+			}
+		}
+
+		void TLSSocket::receive(const std::string &data)
+		{
+			if ( _closed || _eventHandler == nullptr )
+			{
+				return;
+			}
+
+			ByteArray bytes(data.begin(), data.end());
+			_eventHandler->socketBytesReceived(*this, bytes);
+		}
+
+		void TLSSocket::disconnect()
+		{
+			close();
+		}
+
+		const std::string& TLSSocket::getWritten() const
+		{
+			return _written;
+		}
+
+		bool TLSSocket::isClosed() const
+		{
+			return _closed;
+		}
+
+		int SimpleDNSResponder::start(ip4_addr_t UNUSED(address), int UNUSED(port) )
+		{
+			if ( state().dnsResponderFailure )
+			{
+				return -1;
+			}
+
+			state().dnsResponderRunning = true;
+
+			return 0;
+		}
+
+		void SimpleDNSResponder::stop()
+		{
+			state().dnsResponderRunning = false;
+		}
+	}
+}
@@ -0,0 +1,49 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKEPROTOCOLS_H
+#define FAKEPROTOCOLS_H
+
+#include "TLSServer.h"
+#include "TLSSocket.h"
+
+/**
+ * @brief The FakeProtocols namespace controls the fake idfix-protocols components the WiFiManager uses
+ *
+ * There is no network: a test opens a connection to the listening TLSServer with connect() and talks
+ * through the returned socket, which records all the server writes.
+ */
+namespace FakeProtocols
+{
+	void								reset(void);
+
+	/**
+	 * @brief The server listening on the configuration port, nullptr if there is none
+	 */
+	IDFix::Protocols::TLSServer*		listeningServer(void);
+	int									listeningPort(void);
+
+	/**
+	 * @brief Open a connection to the listening server, nullptr if there is none
+	 */
+	IDFix::Protocols::TLSSocket_sharedPtr	connect(void);
+
+	bool								dnsResponderRunning(void);
+	void								setDNSResponderFailure(bool fail);
+}
+
+#endif
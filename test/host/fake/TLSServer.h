@@ -0,0 +1,54 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_TLSSERVER_H
+#define FAKE_TLSSERVER_H
+
+#include "TLSServerEventHandler.h"
+
+namespace IDFix
+{
+	namespace Protocols
+	{
+		/**
+		 * @brief The fake configuration server of idfix-protocols, it only notes whether it listens
+		 *
+		 * Tests hand in connections with FakeProtocols::connect().
+		 */
+		class TLSServer
+		{
+			public:
+
+				explicit			TLSServer(TLSServerEventHandler *eventHandler);
+									~TLSServer();
+
+				bool				init(void);
+				bool				setCertificate(const unsigned char *cert, long certLength);
+				bool				setPrivateKey(const unsigned char *key, long keyLength);
+				bool				listen(int port);
+				void				shutdown(void);
+
+				TLSServerEventHandler*	getEventHandler(void) const;
+
+			private:
+
+				TLSServerEventHandler*	_eventHandler;
+		};
+	}
+}
+
+#endif
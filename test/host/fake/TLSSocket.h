@@ -0,0 +1,65 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_TLSSOCKET_H
+#define FAKE_TLSSOCKET_H
+
+#include "TLSSocketEventHandler.h"
+
+#include <cstddef>
+#include <string>
+
+namespace IDFix
+{
+	namespace Protocols
+	{
+		/**
+		 * @brief A fake TLS connection which keeps everything written to it
+		 */
+		class TLSSocket
+		{
+			public:
+
+				void				setEventHandler(TLSSocketEventHandler *eventHandler);
+				int					write(const std::string &data);
+				int					write(const char *data);
+				int					write(const char *data, size_t length);
+				void				close(void);
+
+				/**
+				 * @brief Deliver bytes from the client as one TLS record
+				 */
+				void				receive(const std::string &data);
+
+				/**
+				 * @brief Let the client disconnect
+				 */
+				void				disconnect(void);
+
+				const std::string&	getWritten(void) const;
+				bool				isClosed(void) const;
+
+			private:
+
+				TLSSocketEventHandler*	_eventHandler = { nullptr };
+				std::string				_written;
+				bool					_closed = { false };
+		};
+	}
+}
+
+#endif
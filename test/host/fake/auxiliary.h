@@ -0,0 +1,36 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_AUXILIARY_H
+#define FAKE_AUXILIARY_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * The subset of the idfix-core helpers the WiFi component uses
+ */
+#define UNUSED(x) x __attribute__((unused))
+
+#define DeclarePointers(T)							\
+	typedef std::shared_ptr<T>	T##_sharedPtr;		\
+	typedef std::weak_ptr<T>	T##_weakPtr
+
+typedef std::vector<uint8_t> ByteArray;
+
+#endif
@@ -0,0 +1,519 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cJSON.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+	cJSON* newItem(int type)
+	{
+		cJSON *item = static_cast<cJSON*>( calloc(1, sizeof(cJSON)) );
+
+		if ( item != nullptr )
+		{
+			item->type = type;
+		}
+
+		return item;
+	}
+
+	char* duplicate(const char *string)
+	{
+		size_t	length = strlen(string) + 1;
+		char	*copy = static_cast<char*>( malloc(length) );
+
+		if ( copy != nullptr )
+		{
+			memcpy(copy, string, length);
+		}
+
+		return copy;
+	}
+
+	void appendChild(cJSON *parent, cJSON *item)
+	{
+		if ( parent->child == nullptr )
+		{
+			parent->child = item;
+			return;
+		}
+
+		cJSON *last = parent->child;
+
+		while ( last->next != nullptr )
+		{
+			last = last->next;
+		}
+
+		last->next = item;
+		item->prev = last;
+	}
+
+	class Parser
+	{
+		public:
+
+			explicit Parser(const char *text) : _position(text) {}
+
+			cJSON* parseDocument()
+			{
+				cJSON *item = parseValue();
+
+				skipWhitespace();
+
+				if ( item != nullptr && *_position != '\0' )
+				{
+					cJSON_Delete(item);
+					return nullptr;
+				}
+
+				return item;
+			}
+
+		private:
+
+			void skipWhitespace()
+			{
+				while ( *_position != '\0' && isspace( static_cast<unsigned char>(*_position) ) )
+				{
+					_position++;
+				}
+			}
+
+			bool consume(const char *literal)
+			{
+				size_t length = strlen(literal);
+
+				if ( strncmp(_position, literal, length) != 0 )
+				{
+					return false;
+				}
+
+				_position += length;
+				return true;
+			}
+
+			cJSON* parseValue()
+			{
+				skipWhitespace();
+
+				switch ( *_position )
+				{
+					case '{':	return parseObject();
+					case '[':	return parseArray();
+					case '"':	return parseString();
+					default:	break;
+				}
+
+				if ( consume("true") )
+				{
+					cJSON *item = newItem(cJSON_True);
+					item->valueint = 1;
+					return item;
+				}
+
+				if ( consume("false") )
+				{
+					return newItem(cJSON_False);
+				}
+
+				if ( consume("null") )
+				{
+					return newItem(cJSON_NULL);
+				}
+
+				return parseNumber();
+			}
+
+			bool parseRawString(std::string &result)
+			{
+				// the opening quote
+				_position++;
+
+				while ( *_position != '"' )
+				{
+					if ( *_position == '\0' )
+					{
+						return false;
+					}
+
+					if ( *_position == '\\' )
+					{
+						_position++;
+
+						switch ( *_position )
+						{
+							case 'b':	result += '\b';	break;
+							case 'f':	result += '\f';	break;
+							case 'n':	result += '\n';	break;
+							case 'r':	result += '\r';	break;
+							case 't':	result += '\t';	break;
+							case '"':
+							case '\\':
+							case '/':	result += *_position;	break;
+							default:	return false;		// \u escapes are not needed by the tests
+						}
+					}
+					else
+					{
+						result += *_position;
+					}
+
+					_position++;
+				}
+
+				// the closing quote
+				_position++;
+				return true;
+			}
+
+			cJSON* parseString()
+			{
+				std::string value;
+
+				if ( ! parseRawString(value) )
+				{
+					return nullptr;
+				}
+
+				cJSON *item = newItem(cJSON_String);
+				item->valuestring = duplicate(value.c_str());
+
+				return item;
+			}
+
+			cJSON* parseNumber()
+			{
+				char	*end;
+				double	value = strtod(_position, &end);
+
+				if ( end == _position )
+				{
+					return nullptr;
+				}
+
+				_position = end;
+
+				cJSON *item = newItem(cJSON_Number);
+				item->valuedouble = value;
+				item->valueint = static_cast<int>(value);
+
+				return item;
+			}
+
+			cJSON* parseArray()
+			{
+				cJSON *array = newItem(cJSON_Array);
+
+				_position++;
+				skipWhitespace();
+
+				if ( consume("]") )
+				{
+					return array;
+				}
+
+				do
+				{
+					cJSON *item = parseValue();
+
+					if ( item == nullptr )
+					{
+						cJSON_Delete(array);
+						return nullptr;
+					}
+
+					appendChild(array, item);
+					skipWhitespace();
+				}
+				while ( consume(",") );
+
+				if ( ! consume("]") )
+				{
+					cJSON_Delete(array);
+					return nullptr;
+				}
+
+				return array;
+			}
+
+			cJSON* parseObject()
+			{
+				cJSON *object = newItem(cJSON_Object);
+
+				_position++;
+				skipWhitespace();
+
+				if ( consume("}") )
+				{
+					return object;
+				}
+
+				do
+				{
+					std::string	name;
+
+					skipWhitespace();
+
+					if ( *_position != '"' || ! parseRawString(name) )
+					{
+						cJSON_Delete(object);
+						return nullptr;
+					}
+
+					skipWhitespace();
+
+					cJSON *item = consume(":") ? parseValue() : nullptr;
+
+					if ( item == nullptr )
+					{
+						cJSON_Delete(object);
+						return nullptr;
+					}
+
+					item->string = duplicate(name.c_str());
+					appendChild(object, item);
+					skipWhitespace();
+				}
+				while ( consume(",") );
+
+				if ( ! consume("}") )
+				{
+					cJSON_Delete(object);
+					return nullptr;
+				}
+
+				return object;
+			}
+
+			const char*	_position;
+	};
+
+	void printString(std::string &out, const char *string)
+	{
+		out += '"';
+
+		for ( const char *c = string; *c != '\0'; c++ )
+		{
+			switch ( *c )
+			{
+				case '"':	out += "\\\"";	break;
+				case '\\':	out += "\\\\";	break;
+				case '\n':	out += "\\n";	break;
+				case '\r':	out += "\\r";	break;
+				case '\t':	out += "\\t";	break;
+				default:	out += *c;		break;
+			}
+		}
+
+		out += '"';
+	}
+
+	// formatted like cJSON_Print() does: tab indented, a tab between name and value
+	void printItem(std::string &out, const cJSON *item, size_t depth)
+	{
+		switch ( item->type & 0xFF )
+		{
+			case cJSON_False:	out += "false";	break;
+			case cJSON_True:	out += "true";	break;
+			case cJSON_NULL:	out += "null";	break;
+			case cJSON_String:	printString(out, item->valuestring);	break;
+
+			case cJSON_Number:
+			{
+				char buffer[32];
+				snprintf(buffer, sizeof(buffer), "%.17g", item->valuedouble);
+				out += buffer;
+				break;
+			}
+
+			case cJSON_Array:
+			{
+				out += '[';
+
+				for ( const cJSON *child = item->child; child != nullptr; child = child->next )
+				{
+					printItem(out, child, depth);
+
+					if ( child->next != nullptr )
+					{
+						out += ", ";
+					}
+				}
+
+				out += ']';
+				break;
+			}
+
+			case cJSON_Object:
+			{
+				out += "{\n";
+
+				for ( const cJSON *child = item->child; child != nullptr; child = child->next )
+				{
+					out.append(depth + 1, '\t');
+					printString(out, child->string);
+					out += ":\t";
+					printItem(out, child, depth + 1);
+
+					if ( child->next != nullptr )
+					{
+						out += ',';
+					}
+
+					out += '\n';
+				}
+
+				out.append(depth, '\t');
+				out += '}';
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+}
+
+extern "C"
+{
+	cJSON* cJSON_Parse(const char *value)
+	{
+		if ( value == nullptr )
+		{
+			return nullptr;
+		}
+
+		return Parser(value).parseDocument();
+	}
+
+	char* cJSON_Print(const cJSON *item)
+	{
+		if ( item == nullptr )
+		{
+			return nullptr;
+		}
+
+		std::string out;
+		printItem(out, item, 0);
+
+		return duplicate(out.c_str());
+	}
+
+	void cJSON_Delete(cJSON *item)
+	{
+		while ( item != nullptr )
+		{
+			cJSON *next = item->next;
+
+			cJSON_Delete(item->child);
+			free(item->valuestring);
+			free(item->string);
+			free(item);
+
+			item = next;
+		}
+	}
+
+	cJSON* cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string)
+	{
+		if ( object == nullptr || string == nullptr )
+		{
+			return nullptr;
+		}
+
+		for ( cJSON *child = object->child; child != nullptr; child = child->next )
+		{
+			if ( child->string != nullptr && strcmp(child->string, string) == 0 )
+			{
+				return child;
+			}
+		}
+
+		return nullptr;
+	}
+
+	cJSON_bool cJSON_IsBool(const cJSON *item)
+	{
+		return item != nullptr && ( item->type & ( cJSON_True | cJSON_False ) ) != 0;
+	}
+
+	cJSON_bool cJSON_IsTrue(const cJSON *item)
+	{
+		return item != nullptr && ( item->type & 0xFF ) == cJSON_True;
+	}
+
+	cJSON_bool cJSON_IsNumber(const cJSON *item)
+	{
+		return item != nullptr && ( item->type & 0xFF ) == cJSON_Number;
+	}
+
+	cJSON_bool cJSON_IsString(const cJSON *item)
+	{
+		return item != nullptr && ( item->type & 0xFF ) == cJSON_String;
+	}
+
+	cJSON_bool cJSON_IsObject(const cJSON *item)
+	{
+		return item != nullptr && ( item->type & 0xFF ) == cJSON_Object;
+	}
+
+	cJSON* cJSON_CreateObject(void)
+	{
+		return newItem(cJSON_Object);
+	}
+
+	cJSON* cJSON_AddStringToObject(cJSON *object, const char *name, const char *string)
+	{
+		cJSON *item = newItem(cJSON_String);
+
+		if ( item == nullptr )
+		{
+			return nullptr;
+		}
+
+		item->valuestring = duplicate(string);
+
+		if ( ! cJSON_AddItemToObject(object, name, item) )
+		{
+			cJSON_Delete(item);
+			return nullptr;
+		}
+
+		return item;
+	}
+
+	cJSON_bool cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
+	{
+		if ( object == nullptr || string == nullptr || item == nullptr || item == object )
+		{
+			return false;
+		}
+
+		free(item->string);
+		item->string = duplicate(string);
+		appendChild(object, item);
+
+		return true;
+	}
+}
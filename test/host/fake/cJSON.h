@@ -0,0 +1,73 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_CJSON_H
+#define FAKE_CJSON_H
+
+/*
+ * The subset of cJSON the WiFiManager uses, with the layout and type flags of the real library
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define cJSON_Invalid	(0)
+#define cJSON_False		(1 << 0)
+#define cJSON_True		(1 << 1)
+#define cJSON_NULL		(1 << 2)
+#define cJSON_Number	(1 << 3)
+#define cJSON_String	(1 << 4)
+#define cJSON_Array		(1 << 5)
+#define cJSON_Object	(1 << 6)
+
+typedef int cJSON_bool;
+
+typedef struct cJSON
+{
+	struct cJSON	*next;
+	struct cJSON	*prev;
+	struct cJSON	*child;
+	int				type;
+	char			*valuestring;
+	int				valueint;
+	double			valuedouble;
+	char			*string;
+} cJSON;
+
+cJSON*		cJSON_Parse(const char *value);
+char*		cJSON_Print(const cJSON *item);
+void		cJSON_Delete(cJSON *item);
+
+cJSON*		cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string);
+
+cJSON_bool	cJSON_IsBool(const cJSON *item);
+cJSON_bool	cJSON_IsTrue(const cJSON *item);
+cJSON_bool	cJSON_IsNumber(const cJSON *item);
+cJSON_bool	cJSON_IsString(const cJSON *item);
+cJSON_bool	cJSON_IsObject(const cJSON *item);
+
+cJSON*		cJSON_CreateObject(void);
+cJSON*		cJSON_AddStringToObject(cJSON *object, const char *name, const char *string);
+cJSON_bool	cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,50 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_ESP_ERR_H
+#define FAKE_ESP_ERR_H
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                          0
+#define ESP_FAIL                        -1
+
+#define ESP_ERR_NO_MEM                  0x101
+#define ESP_ERR_INVALID_ARG             0x102
+#define ESP_ERR_INVALID_STATE           0x103
+#define ESP_ERR_INVALID_SIZE            0x104
+#define ESP_ERR_NOT_FOUND               0x105
+#define ESP_ERR_NOT_SUPPORTED           0x106
+#define ESP_ERR_TIMEOUT                 0x107
+
+#define ESP_ERR_WIFI_BASE               0x3000
+#define ESP_ERR_WIFI_NOT_INIT           (ESP_ERR_WIFI_BASE + 1)
+#define ESP_ERR_WIFI_NOT_STARTED        (ESP_ERR_WIFI_BASE + 2)
+#define ESP_ERR_WIFI_NOT_STOPPED        (ESP_ERR_WIFI_BASE + 3)
+#define ESP_ERR_WIFI_IF                 (ESP_ERR_WIFI_BASE + 4)
+#define ESP_ERR_WIFI_MODE               (ESP_ERR_WIFI_BASE + 5)
+#define ESP_ERR_WIFI_STATE              (ESP_ERR_WIFI_BASE + 6)
+#define ESP_ERR_WIFI_CONN               (ESP_ERR_WIFI_BASE + 7)
+#define ESP_ERR_WIFI_NOT_CONNECT        (ESP_ERR_WIFI_BASE + 15)
+
+const char* esp_err_to_name(esp_err_t code);
+
+#define ESP_ERROR_CHECK(x)              do { esp_err_t err_rc_ = (x); (void) err_rc_; } while (0)
+
+#endif
@@ -0,0 +1,33 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_ESP_EVENT_BASE_H
+#define FAKE_ESP_EVENT_BASE_H
+
+#include <stdint.h>
+
+typedef const char* esp_event_base_t;
+
+typedef void (*esp_event_handler_t)(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+
+#define ESP_EVENT_DECLARE_BASE(id)  extern esp_event_base_t const id
+#define ESP_EVENT_DEFINE_BASE(id)   esp_event_base_t const id = #id
+
+#define ESP_EVENT_ANY_BASE      NULL
+#define ESP_EVENT_ANY_ID        -1
+
+#endif
@@ -0,0 +1,43 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_ESP_LOG_H
+#define FAKE_ESP_LOG_H
+
+typedef enum
+{
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+/**
+ * Prints the message if level is at most the level in the environment variable IDFIX_HOST_LOG_LEVEL,
+ * which defaults to ESP_LOG_WARN.
+ */
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, format, ...)  esp_log_write(ESP_LOG_ERROR,    tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  esp_log_write(ESP_LOG_WARN,     tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  esp_log_write(ESP_LOG_INFO,     tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  esp_log_write(ESP_LOG_DEBUG,    tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)  esp_log_write(ESP_LOG_VERBOSE,  tag, format, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,94 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_ESP_NETIF_H
+#define FAKE_ESP_NETIF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_event_base.h"
+#include "lwip/ip4_addr.h"
+
+extern esp_event_base_t const IP_EVENT;
+
+#define ESP_ERR_TCPIP_ADAPTER_BASE                  0x5000
+#define ESP_ERR_TCPIP_ADAPTER_INVALID_PARAMS        (ESP_ERR_TCPIP_ADAPTER_BASE + 0x01)
+#define ESP_ERR_TCPIP_ADAPTER_IF_NOT_READY          (ESP_ERR_TCPIP_ADAPTER_BASE + 0x02)
+#define ESP_ERR_TCPIP_ADAPTER_DHCPC_START_FAILED    (ESP_ERR_TCPIP_ADAPTER_BASE + 0x03)
+#define ESP_ERR_TCPIP_ADAPTER_DHCP_ALREADY_STARTED  (ESP_ERR_TCPIP_ADAPTER_BASE + 0x04)
+#define ESP_ERR_TCPIP_ADAPTER_DHCP_ALREADY_STOPPED  (ESP_ERR_TCPIP_ADAPTER_BASE + 0x05)
+#define ESP_ERR_TCPIP_ADAPTER_DHCP_NOT_STOPPED      (ESP_ERR_TCPIP_ADAPTER_BASE + 0x07)
+
+typedef ip4_addr_t esp_ip4_addr_t;
+
+typedef struct
+{
+    esp_ip4_addr_t  ip;
+    esp_ip4_addr_t  netmask;
+    esp_ip4_addr_t  gw;
+} esp_netif_ip_info_t;
+
+typedef esp_netif_ip_info_t tcpip_adapter_ip_info_t;
+
+typedef struct esp_netif_obj esp_netif_t;
+
+typedef struct
+{
+    esp_netif_t*        esp_netif;
+    esp_netif_ip_info_t ip_info;
+    bool                ip_changed;
+} ip_event_got_ip_t;
+
+typedef enum
+{
+    TCPIP_ADAPTER_IF_STA = 0,
+    TCPIP_ADAPTER_IF_AP,
+    TCPIP_ADAPTER_IF_ETH,
+    TCPIP_ADAPTER_IF_MAX
+} tcpip_adapter_if_t;
+
+typedef enum
+{
+    IP_EVENT_STA_GOT_IP,
+    IP_EVENT_STA_LOST_IP,
+    IP_EVENT_AP_STAIPASSIGNED,
+    IP_EVENT_GOT_IP6,
+    IP_EVENT_ETH_GOT_IP,
+    IP_EVENT_PPP_GOT_IP,
+    IP_EVENT_PPP_LOST_IP
+} ip_event_t;
+
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(ipaddr) ((ipaddr)->addr & 0xff), (((ipaddr)->addr >> 8) & 0xff), (((ipaddr)->addr >> 16) & 0xff), (((ipaddr)->addr >> 24) & 0xff)
+
+esp_err_t esp_netif_init(void);
+esp_netif_t* esp_netif_create_default_wifi_sta(void);
+esp_netif_t* esp_netif_create_default_wifi_ap(void);
+void esp_netif_destroy(esp_netif_t* esp_netif);
+
+/**
+ * The DHCP client of the station is started by default and requests a lease whenever the station connects
+ */
+esp_err_t tcpip_adapter_get_ip_info(tcpip_adapter_if_t tcpip_if, tcpip_adapter_ip_info_t* ip_info);
+esp_err_t tcpip_adapter_set_ip_info(tcpip_adapter_if_t tcpip_if, const tcpip_adapter_ip_info_t* ip_info);
+esp_err_t tcpip_adapter_dhcpc_start(tcpip_adapter_if_t tcpip_if);
+esp_err_t tcpip_adapter_dhcpc_stop(tcpip_adapter_if_t tcpip_if);
+esp_err_t tcpip_adapter_get_netif(tcpip_adapter_if_t tcpip_if, void** netif);
+
+#endif
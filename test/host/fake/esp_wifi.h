@@ -0,0 +1,86 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_ESP_WIFI_H
+#define FAKE_ESP_WIFI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include "esp_event.h"
+
+typedef struct
+{
+    int         static_rx_buf_num;
+    int         dynamic_rx_buf_num;
+    int         tx_buf_type;
+    int         static_tx_buf_num;
+    int         dynamic_tx_buf_num;
+    int         cache_tx_buf_num;
+    int         csi_enable;
+    int         ampdu_rx_enable;
+    int         ampdu_tx_enable;
+    int         amsdu_tx_enable;
+    int         nvs_enable;
+    int         nano_enable;
+    int         rx_ba_win;
+    int         wifi_task_core_id;
+    int         beacon_max_len;
+    int         mgmt_sbuf_num;
+    uint64_t    feature_caps;
+    bool        sta_disconnected_pm;
+    int         magic;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_MAGIC      0x1F2F3F4F
+
+/**
+ * The defaults of the IDF configuration
+ */
+#define WIFI_INIT_CONFIG_DEFAULT() { 10, 32, 1, 0, 32, 0, 0, 1, 1, 0, 1, 0, 6, 0, 752, 32, 0, false, WIFI_INIT_CONFIG_MAGIC }
+
+typedef enum
+{
+    WIFI_STORAGE_FLASH,
+    WIFI_STORAGE_RAM
+} wifi_storage_t;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config);
+esp_err_t esp_wifi_deinit(void);
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage);
+esp_err_t esp_wifi_set_country(const wifi_country_t* country);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_get_mode(wifi_mode_t* mode);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_stop(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t* config, bool block);
+esp_err_t esp_wifi_scan_stop(void);
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t* number);
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t* number, wifi_ap_record_t* ap_records);
+esp_err_t esp_wifi_scan_get_ap_record(wifi_ap_record_t* ap_record);
+esp_err_t esp_wifi_clear_ap_list(void);
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info);
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t* type);
+
+#endif
@@ -0,0 +1,262 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_ESP_WIFI_TYPES_H
+#define FAKE_ESP_WIFI_TYPES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_event_base.h"
+
+extern esp_event_base_t const WIFI_EVENT;
+
+typedef enum
+{
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA,
+    WIFI_MODE_MAX
+} wifi_mode_t;
+
+typedef enum
+{
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP
+} wifi_interface_t;
+
+typedef enum
+{
+    WIFI_COUNTRY_POLICY_AUTO,
+    WIFI_COUNTRY_POLICY_MANUAL
+} wifi_country_policy_t;
+
+typedef struct
+{
+    char                    cc[3];
+    uint8_t                 schan;
+    uint8_t                 nchan;
+    int8_t                  max_tx_power;
+    wifi_country_policy_t   policy;
+} wifi_country_t;
+
+typedef enum
+{
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_WPA2_ENTERPRISE,
+    WIFI_AUTH_MAX
+} wifi_auth_mode_t;
+
+typedef enum
+{
+    WIFI_REASON_UNSPECIFIED              = 1,
+    WIFI_REASON_AUTH_EXPIRE              = 2,
+    WIFI_REASON_AUTH_LEAVE               = 3,
+    WIFI_REASON_ASSOC_EXPIRE             = 4,
+    WIFI_REASON_ASSOC_TOOMANY            = 5,
+    WIFI_REASON_NOT_AUTHED               = 6,
+    WIFI_REASON_NOT_ASSOCED              = 7,
+    WIFI_REASON_ASSOC_LEAVE              = 8,
+    WIFI_REASON_ASSOC_NOT_AUTHED         = 9,
+    WIFI_REASON_DISASSOC_PWRCAP_BAD      = 10,
+    WIFI_REASON_DISASSOC_SUPCHAN_BAD     = 11,
+    WIFI_REASON_IE_INVALID               = 13,
+    WIFI_REASON_MIC_FAILURE              = 14,
+    WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT   = 15,
+    WIFI_REASON_GROUP_KEY_UPDATE_TIMEOUT = 16,
+    WIFI_REASON_IE_IN_4WAY_DIFFERS       = 17,
+    WIFI_REASON_GROUP_CIPHER_INVALID     = 18,
+    WIFI_REASON_PAIRWISE_CIPHER_INVALID  = 19,
+    WIFI_REASON_AKMP_INVALID             = 20,
+    WIFI_REASON_UNSUPP_RSN_IE_VERSION    = 21,
+    WIFI_REASON_INVALID_RSN_IE_CAP       = 22,
+    WIFI_REASON_802_1X_AUTH_FAILED       = 23,
+    WIFI_REASON_CIPHER_SUITE_REJECTED    = 24,
+
+    WIFI_REASON_BEACON_TIMEOUT           = 200,
+    WIFI_REASON_NO_AP_FOUND              = 201,
+    WIFI_REASON_AUTH_FAIL                = 202,
+    WIFI_REASON_ASSOC_FAIL               = 203,
+    WIFI_REASON_HANDSHAKE_TIMEOUT        = 204,
+    WIFI_REASON_CONNECTION_FAIL          = 205
+} wifi_err_reason_t;
+
+typedef enum
+{
+    WIFI_SCAN_TYPE_ACTIVE = 0,
+    WIFI_SCAN_TYPE_PASSIVE
+} wifi_scan_type_t;
+
+typedef struct
+{
+    uint32_t    min;
+    uint32_t    max;
+} wifi_active_scan_time_t;
+
+typedef struct
+{
+    wifi_active_scan_time_t active;
+    uint32_t                passive;
+} wifi_scan_time_t;
+
+typedef struct
+{
+    uint8_t*            ssid;
+    uint8_t*            bssid;
+    uint8_t             channel;
+    bool                show_hidden;
+    wifi_scan_type_t    scan_type;
+    wifi_scan_time_t    scan_time;
+} wifi_scan_config_t;
+
+typedef enum
+{
+    WIFI_SECOND_CHAN_NONE = 0,
+    WIFI_SECOND_CHAN_ABOVE,
+    WIFI_SECOND_CHAN_BELOW
+} wifi_second_chan_t;
+
+typedef struct
+{
+    uint8_t             bssid[6];
+    uint8_t             ssid[33];
+    uint8_t             primary;
+    wifi_second_chan_t  second;
+    int8_t              rssi;
+    wifi_auth_mode_t    authmode;
+} wifi_ap_record_t;
+
+typedef enum
+{
+    WIFI_FAST_SCAN = 0,
+    WIFI_ALL_CHANNEL_SCAN
+} wifi_scan_method_t;
+
+typedef enum
+{
+    WIFI_CONNECT_AP_BY_SIGNAL = 0,
+    WIFI_CONNECT_AP_BY_SECURITY
+} wifi_sort_method_t;
+
+typedef struct
+{
+    bool    capable;
+    bool    required;
+} wifi_pmf_config_t;
+
+typedef struct
+{
+    uint8_t             ssid[32];
+    uint8_t             password[64];
+    wifi_scan_method_t  scan_method;
+    bool                bssid_set;
+    uint8_t             bssid[6];
+    uint8_t             channel;
+    uint16_t            listen_interval;
+    wifi_sort_method_t  sort_method;
+    wifi_pmf_config_t   pmf_cfg;
+} wifi_sta_config_t;
+
+typedef struct
+{
+    uint8_t             ssid[32];
+    uint8_t             password[64];
+    uint8_t             ssid_len;
+    uint8_t             channel;
+    wifi_auth_mode_t    authmode;
+    uint8_t             ssid_hidden;
+    uint8_t             max_connection;
+    uint16_t            beacon_interval;
+} wifi_ap_config_t;
+
+typedef union
+{
+    wifi_ap_config_t    ap;
+    wifi_sta_config_t   sta;
+} wifi_config_t;
+
+typedef enum
+{
+    WIFI_PS_NONE,
+    WIFI_PS_MIN_MODEM,
+    WIFI_PS_MAX_MODEM
+} wifi_ps_type_t;
+
+typedef enum
+{
+    WIFI_EVENT_WIFI_READY = 0,
+    WIFI_EVENT_SCAN_DONE,
+    WIFI_EVENT_STA_START,
+    WIFI_EVENT_STA_STOP,
+    WIFI_EVENT_STA_CONNECTED,
+    WIFI_EVENT_STA_DISCONNECTED,
+    WIFI_EVENT_STA_AUTHMODE_CHANGE,
+    WIFI_EVENT_STA_WPS_ER_SUCCESS,
+    WIFI_EVENT_STA_WPS_ER_FAILED,
+    WIFI_EVENT_STA_WPS_ER_TIMEOUT,
+    WIFI_EVENT_STA_WPS_ER_PIN,
+    WIFI_EVENT_STA_WPS_ER_PBC_OVERLAP,
+    WIFI_EVENT_AP_START,
+    WIFI_EVENT_AP_STOP,
+    WIFI_EVENT_AP_STACONNECTED,
+    WIFI_EVENT_AP_STADISCONNECTED,
+    WIFI_EVENT_AP_PROBEREQRECVED,
+    WIFI_EVENT_MAX
+} wifi_event_t;
+
+typedef struct
+{
+    uint32_t    status;
+    uint8_t     number;
+    uint8_t     scan_id;
+} wifi_event_sta_scan_done_t;
+
+typedef struct
+{
+    uint8_t             ssid[32];
+    uint8_t             ssid_len;
+    uint8_t             bssid[6];
+    uint8_t             channel;
+    wifi_auth_mode_t    authmode;
+} wifi_event_sta_connected_t;
+
+typedef struct
+{
+    uint8_t     ssid[32];
+    uint8_t     ssid_len;
+    uint8_t     bssid[6];
+    uint8_t     reason;
+} wifi_event_sta_disconnected_t;
+
+typedef struct
+{
+    uint8_t     mac[6];
+    uint8_t     aid;
+} wifi_event_ap_staconnected_t;
+
+typedef struct
+{
+    uint8_t     mac[6];
+    uint8_t     aid;
+} wifi_event_ap_stadisconnected_t;
+
+#endif
@@ -0,0 +1,34 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_LWIP_DHCP_H
+#define FAKE_LWIP_DHCP_H
+
+#include <stdint.h>
+
+#include "lwip/err.h"
+#include "lwip/netif.h"
+
+/**
+ * The plain lwIP client, unlike tcpip_adapter_dhcpc_start() it keeps the address of the interface
+ * until it is bound to a lease and it does not post IP_EVENT_STA_GOT_IP
+ */
+err_t dhcp_start(struct netif* netif);
+void dhcp_stop(struct netif* netif);
+uint8_t dhcp_supplied_address(const struct netif* netif);
+
+#endif
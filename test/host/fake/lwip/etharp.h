@@ -0,0 +1,40 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_LWIP_ETHARP_H
+#define FAKE_LWIP_ETHARP_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "lwip/err.h"
+#include "lwip/netif.h"
+
+struct pbuf;
+
+struct eth_addr
+{
+    uint8_t addr[6];
+};
+
+/**
+ * Hosts added by FakeIDF::addLANHost() answer a few milliseconds after the request was sent
+ */
+err_t etharp_query(struct netif* netif, const ip4_addr_t* ipaddr, struct pbuf* q);
+ssize_t etharp_find_addr(struct netif* netif, const ip4_addr_t* ipaddr, struct eth_addr** eth_ret, const ip4_addr_t** ip_ret);
+
+#endif
@@ -0,0 +1,36 @@
+/*   2log.io
+ *   Copyright (C) 2021 - 2log.io | mail@2log.io,  sascha@2log.io
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_LWIP_NETIFAPI_H
+#define FAKE_LWIP_NETIFAPI_H
+
+#include "lwip/err.h"
+#include "lwip/netif.h"
+#include "lwip/dhcp.h"
+
+typedef void (*netifapi_void_fn)(struct netif* netif);
+typedef err_t (*netifapi_errt_fn)(struct netif* netif);
+
+/**
+ * There is no tcpip thread, the functions are called right away
+ */
+err_t netifapi_netif_common(struct netif* netif, netifapi_void_fn voidfunc, netifapi_errt_fn errtfunc);
+
+#define netifapi_dhcp_start(n)  netifapi_netif_common(n, NULL, dhcp_start)
+#define netifapi_dhcp_stop(n)   netifapi_netif_common(n, dhcp_stop, NULL)
+
+#endif